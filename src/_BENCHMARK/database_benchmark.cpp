@@ -0,0 +1,364 @@
+#include "database_benchmark.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "db/core/database_api.h"
+#include "db/model/sound_file_table_model.h"
+#include "db/model/category_closure.h"
+
+namespace _BENCHMARK {
+
+// number of records looked up per benchmark iteration
+static const int LOOKUP_COUNT = 1000;
+
+// number of sound files inserted per benchmark iteration
+static const int INSERT_BATCH_SIZE = 1000;
+
+DatabaseBenchmark::DatabaseBenchmark(QObject* parent)
+    : QObject(parent)
+    , dir_()
+    , libraries_()
+{}
+
+void DatabaseBenchmark::initTestCase()
+{
+    dir_ = qgetenv("COMPANION_BENCH_DIR");
+    if(dir_.isEmpty())
+        dir_ = QDir::temp().filePath("companion-benchmark");
+    QVERIFY(QDir().mkpath(dir_));
+
+    QString sizes = qgetenv("COMPANION_BENCH_SIZES");
+    if(sizes.isEmpty())
+        sizes = "10000,100000";
+
+    foreach(QString const& size, sizes.split(",", QString::SkipEmptyParts)) {
+        bool ok = false;
+        LibrarySpec spec(size.trimmed().toInt(&ok));
+        QVERIFY2(ok && spec.sound_files > 0, qPrintable("invalid library size " + size));
+
+        QString db_path = QDir(dir_).filePath(spec.getFileName());
+        if(!QFileInfo(db_path).exists()) {
+            QVERIFY(LibraryGenerator::generate(db_path, spec));
+
+            // first open migrates and builds search index, keep that out of measurements
+            DatabaseApi api(db_path);
+        }
+
+        libraries_.insert(db_path, spec);
+    }
+}
+
+void DatabaseBenchmark::selectSoundFileTable_data()
+{
+    addLibraryRows();
+}
+
+void DatabaseBenchmark::selectSoundFileTable()
+{
+    QFETCH(QString, db_path);
+    QFETCH(int, sound_files);
+
+    DatabaseApi api(db_path);
+    SoundFileTableModel model(&api);
+
+    QBENCHMARK {
+        model.select();
+        model.waitForSelect();
+    }
+
+    QCOMPARE(model.rowCount(), sound_files);
+}
+
+void DatabaseBenchmark::lookupSoundFileById_data()
+{
+    addLibraryRows();
+}
+
+void DatabaseBenchmark::lookupSoundFileById()
+{
+    QFETCH(QString, db_path);
+    QFETCH(int, sound_files);
+
+    DatabaseApi api(db_path);
+    SoundFileTableModel model(&api);
+    model.select();
+    model.waitForSelect();
+
+    int step = qMax(1, sound_files / LOOKUP_COUNT);
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        for(int id = 1; id <= sound_files; id += step) {
+            if(model.getSoundFileById(id) != 0)
+                ++found;
+        }
+    }
+
+    QVERIFY(found > 0);
+}
+
+void DatabaseBenchmark::lookupSoundFileByPath_data()
+{
+    addLibraryRows();
+}
+
+void DatabaseBenchmark::lookupSoundFileByPath()
+{
+    QFETCH(QString, db_path);
+    QFETCH(int, sound_files);
+
+    LibrarySpec spec = libraries_.value(db_path);
+
+    DatabaseApi api(db_path);
+    SoundFileTableModel model(&api);
+    model.select();
+    model.waitForSelect();
+
+    QStringList paths;
+    int step = qMax(1, sound_files / LOOKUP_COUNT);
+    for(int id = 1; id <= sound_files; id += step)
+        paths.append(LibraryGenerator::getSoundFilePath(id, spec));
+
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        foreach(QString const& path, paths) {
+            if(model.getSoundFileByPath(path) != 0)
+                ++found;
+        }
+    }
+
+    QCOMPARE(found, paths.size());
+}
+
+void DatabaseBenchmark::lookupSoundFileId_data()
+{
+    QTest::addColumn<QString>("db_path");
+    QTest::addColumn<int>("sound_files");
+    QTest::addColumn<bool>("prepared");
+
+    foreach(QString const& db_path, libraries_.keys()) {
+        int sound_files = libraries_[db_path].sound_files;
+
+        // cached prepared statement against escaped string query compiled per call
+        QTest::newRow(qPrintable(QString("%1/prepared").arg(sound_files))) << db_path << sound_files << true;
+        QTest::newRow(qPrintable(QString("%1/legacy").arg(sound_files))) << db_path << sound_files << false;
+    }
+}
+
+void DatabaseBenchmark::lookupSoundFileId()
+{
+    QFETCH(QString, db_path);
+    QFETCH(int, sound_files);
+    QFETCH(bool, prepared);
+
+    LibrarySpec spec = libraries_.value(db_path);
+    DatabaseApi api(db_path);
+
+    QStringList paths;
+    int step = qMax(1, sound_files / LOOKUP_COUNT);
+    for(int id = 1; id <= sound_files; id += step)
+        paths.append(LibraryGenerator::getSoundFilePath(id, spec));
+
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        foreach(QString const& path, paths) {
+            int id = -1;
+            if(prepared) {
+                id = api.getSoundFileId(path);
+            }
+            else {
+                // lookup as done before statements got cached
+                QList<QSqlRecord> res = api.selectQuery("id", SOUND_FILE, "path = '" + SqliteWrapper::escape(path) + "'");
+                if(res.size() > 0)
+                    id = res[0].value(0).toInt();
+            }
+            if(id != -1)
+                ++found;
+        }
+    }
+
+    QCOMPARE(found, paths.size());
+}
+
+void DatabaseBenchmark::insertSoundFiles_data()
+{
+    addLibraryRows();
+}
+
+void DatabaseBenchmark::insertSoundFiles()
+{
+    QFETCH(QString, db_path);
+
+    QString copy_path = copyLibrary(db_path);
+    QVERIFY(!copy_path.isEmpty());
+
+    {
+        DatabaseApi api(copy_path);
+        ResourceDirRecord resource_dir(1, "dir_0", LibraryGenerator::getResourceDirPath(0));
+
+        // paths have to be unique across iterations, building them is part of the measurement
+        int batch = 0;
+        QList<int> ids;
+
+        QBENCHMARK {
+            QList<QFileInfo> infos;
+            for(int i = 0; i < INSERT_BATCH_SIZE; ++i)
+                infos.append(QFileInfo(resource_dir.path + QString("/inserted/batch_%1/file_%2.wav").arg(batch).arg(i)));
+            ++batch;
+
+            ids = api.insertSoundFiles(infos, resource_dir);
+        }
+
+        QCOMPARE(ids.size(), INSERT_BATCH_SIZE);
+    }
+
+    QFile::remove(copy_path);
+}
+
+void DatabaseBenchmark::resolveCategorySubtree_data()
+{
+    QTest::addColumn<QString>("db_path");
+    QTest::addColumn<int>("sound_files");
+    QTest::addColumn<int>("category_id");
+
+    foreach(QString const& db_path, libraries_.keys()) {
+        int sound_files = libraries_[db_path].sound_files;
+
+        // first top level category spans a full tree, -1 spans all categories
+        QTest::newRow(qPrintable(QString("%1/top").arg(sound_files))) << db_path << sound_files << 1;
+        QTest::newRow(qPrintable(QString("%1/all").arg(sound_files))) << db_path << sound_files << -1;
+    }
+}
+
+void DatabaseBenchmark::resolveCategorySubtree()
+{
+    QFETCH(QString, db_path);
+    QFETCH(int, category_id);
+
+    DatabaseApi api(db_path);
+    QList<int> ids;
+
+    QBENCHMARK {
+        ids = api.getSoundFileIdsByCategoryTree(category_id);
+    }
+
+    QVERIFY(ids.size() > 0);
+}
+
+void DatabaseBenchmark::deleteAll_data()
+{
+    addLibraryRows();
+}
+
+void DatabaseBenchmark::deleteAll()
+{
+    QFETCH(QString, db_path);
+
+    QString copy_path = copyLibrary(db_path);
+    QVERIFY(!copy_path.isEmpty());
+
+    {
+        DatabaseApi api(copy_path);
+
+        // destructive, so measured once
+        QBENCHMARK_ONCE {
+            api.deleteAll();
+        }
+
+        QCOMPARE(api.getSoundFileCount(), 0);
+    }
+
+    QFile::remove(copy_path);
+}
+
+void DatabaseBenchmark::categoryClosureDescendants()
+{
+    // 1 -> 2 -> 3, 1 -> 4, 5 (added out of depth-first order, as during imports)
+    CategoryClosure closure;
+    QVERIFY(closure.add(CategoryRecord(1, "a", 0)));
+    QVERIFY(closure.add(CategoryRecord(5, "e", 0)));
+    QVERIFY(closure.add(CategoryRecord(2, "b", 1)));
+    QVERIFY(closure.add(CategoryRecord(4, "d", 1)));
+
+    QVERIFY(closure.isDescendant(2, 1));
+    QVERIFY(closure.isDescendant(4, 1));
+    QVERIFY(!closure.isDescendant(1, 2));
+    QVERIFY(!closure.isDescendant(5, 1));
+    QVERIFY(!closure.isDescendant(1, 1));
+    QVERIFY(!closure.isDescendant(3, 1));
+
+    // adding after a query renumbers again
+    QVERIFY(closure.add(CategoryRecord(3, "c", 2)));
+    QVERIFY(closure.isDescendant(3, 2));
+    QVERIFY(closure.isDescendant(3, 1));
+    QVERIFY(!closure.isDescendant(3, 4));
+    QVERIFY(!closure.isDescendant(4, 2));
+    QCOMPARE(closure.getDescendantIds(1), QList<int>() << 2 << 3 << 4);
+
+    closure.rename(2, "x");
+    QCOMPARE(closure.getIdByPath(QStringList() << "a" << "x" << "c"), 3);
+    QVERIFY(closure.isDescendant(3, 1));
+}
+
+void DatabaseBenchmark::addCategories_data()
+{
+    QTest::addColumn<int>("categories");
+
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+void DatabaseBenchmark::addCategories()
+{
+    QFETCH(int, categories);
+
+    // ten top level categories, each further category below one of the previous ones
+    QList<CategoryRecord> records;
+    for(int id = 1; id <= categories; ++id)
+        records.append(CategoryRecord(id, QString("category %1").arg(id), id <= 10 ? 0 : (id * 7) % (id - 1) + 1));
+
+    CategoryClosure closure;
+
+    QBENCHMARK {
+        closure.clear();
+        foreach(CategoryRecord const& rec, records)
+            closure.add(rec);
+        closure.isDescendant(categories, 1);
+    }
+
+    QCOMPARE(closure.getDescendantIds(-1).size(), categories);
+}
+
+void DatabaseBenchmark::addLibraryRows()
+{
+    QTest::addColumn<QString>("db_path");
+    QTest::addColumn<int>("sound_files");
+
+    foreach(QString const& db_path, libraries_.keys()) {
+        int sound_files = libraries_[db_path].sound_files;
+        QTest::newRow(qPrintable(QString::number(sound_files))) << db_path << sound_files;
+    }
+}
+
+const QString DatabaseBenchmark::copyLibrary(const QString &db_path)
+{
+    QString copy_path = db_path + ".write";
+    QFile::remove(copy_path);
+    QFile::remove(copy_path + "-wal");
+    QFile::remove(copy_path + "-shm");
+
+    if(!QFile::copy(db_path, copy_path))
+        return "";
+
+    return copy_path;
+}
+
+} // namespace _BENCHMARK
@@ -0,0 +1,73 @@
+#ifndef BENCHMARK_DATABASE_BENCHMARK_H
+#define BENCHMARK_DATABASE_BENCHMARK_H
+
+#include <QObject>
+#include <QMap>
+
+#include "library_generator.h"
+
+namespace _BENCHMARK {
+
+/*
+ * QTest benchmarks of the database layer.
+ * Each benchmark runs once per generated library size.
+ * Libraries are generated on first run and reused afterwards.
+ *
+ * Environment:
+ *  COMPANION_BENCH_SIZES  comma separated numbers of sound files (default "10000,100000")
+ *  COMPANION_BENCH_DIR    directory holding generated libraries (default <tmp>/companion-benchmark)
+**/
+class DatabaseBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DatabaseBenchmark(QObject* parent = 0);
+
+private slots:
+    void initTestCase();
+
+    void selectSoundFileTable_data();
+    void selectSoundFileTable();
+
+    void lookupSoundFileById_data();
+    void lookupSoundFileById();
+
+    void lookupSoundFileByPath_data();
+    void lookupSoundFileByPath();
+
+    void lookupSoundFileId_data();
+    void lookupSoundFileId();
+
+    void insertSoundFiles_data();
+    void insertSoundFiles();
+
+    void resolveCategorySubtree_data();
+    void resolveCategorySubtree();
+
+    void deleteAll_data();
+    void deleteAll();
+
+    void categoryClosureDescendants();
+
+    void addCategories_data();
+    void addCategories();
+
+private:
+    /* Adds one data row per library (columns db_path & sound_files) */
+    void addLibraryRows();
+
+    /*
+     * Copies library db at given path for benchmarks writing to it.
+     * Returns path of copy, empty string on failure.
+    */
+    QString const copyLibrary(QString const& db_path);
+
+    QString dir_;
+
+    // library spec by db path
+    QMap<QString, LibrarySpec> libraries_;
+};
+
+} // namespace _BENCHMARK
+
+#endif // BENCHMARK_DATABASE_BENCHMARK_H
@@ -0,0 +1,201 @@
+#include "library_generator.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QVariant>
+#include <QElapsedTimer>
+
+namespace _BENCHMARK {
+
+// connection used while generating, removed again afterwards
+static const QString CONNECTION_NAME = "library_generator";
+
+// seed of generated content
+static const uint SEED = 42;
+
+// words sound names get built from (keeps search benchmarks realistic)
+static const QStringList WORDS = QStringList()
+        << "rain" << "wind" << "forest" << "tavern" << "battle" << "sword" << "fire"
+        << "thunder" << "cave" << "river" << "crowd" << "horse" << "door" << "magic"
+        << "dragon" << "ambience" << "footsteps" << "bell" << "night" << "storm";
+
+// schema as created by companion-sqlalchemy-models
+static const QStringList SCHEMA = QStringList()
+        << "CREATE TABLE sound_file (id INTEGER PRIMARY KEY, name TEXT, path TEXT, relative_path TEXT)"
+        << "CREATE TABLE category (id INTEGER PRIMARY KEY, name TEXT, parent_id INTEGER)"
+        << "CREATE TABLE sound_file_category (id INTEGER PRIMARY KEY, sound_file_id INTEGER, category_id INTEGER)"
+        << "CREATE TABLE resource_directory (id INTEGER PRIMARY KEY, name TEXT, path TEXT)"
+        << "CREATE TABLE image_directory (id INTEGER PRIMARY KEY, name TEXT, path TEXT)"
+        << "CREATE TABLE preset (id INTEGER PRIMARY KEY, name TEXT, json TEXT)";
+
+int LibrarySpec::getCategoryCount() const
+{
+    int count = 0;
+    int level = top_categories;
+    for(int depth = 0; depth <= category_depth; ++depth) {
+        count += level;
+        level *= category_fanout;
+    }
+    return count;
+}
+
+const QString LibrarySpec::getFileName() const
+{
+    return QString("library_%1_d%2_f%3.db")
+            .arg(sound_files)
+            .arg(category_depth)
+            .arg(category_fanout);
+}
+
+/* Executes given prepared query with values, logs failure */
+static bool exec(QSqlQuery& qry, QVariantList const& values)
+{
+    for(int i = 0; i < values.size(); ++i)
+        qry.bindValue(i, values[i]);
+
+    if(qry.exec())
+        return true;
+
+    qDebug() << "FAILURE: could not generate library row";
+    qDebug() << " > Query:" << qry.lastQuery();
+    qDebug() << " > Error:" << qry.lastError().text();
+    return false;
+}
+
+/* Writes all tables, connection has to be open */
+static bool fill(QSqlDatabase& db, LibrarySpec const& spec)
+{
+    QSqlQuery qry(db);
+
+    foreach(QString const& stmt, SCHEMA) {
+        if(!qry.exec(stmt)) {
+            qDebug() << "FAILURE: could not create library schema";
+            qDebug() << " > Error:" << qry.lastError().text();
+            return false;
+        }
+    }
+
+    // writing a throwaway db, durability is of no concern
+    qry.exec("PRAGMA synchronous = OFF");
+    qry.exec("PRAGMA journal_mode = MEMORY");
+
+    db.transaction();
+
+    qry.prepare("INSERT INTO resource_directory (id, name, path) VALUES (?, ?, ?)");
+    for(int dir = 0; dir < spec.resource_dirs; ++dir) {
+        if(!exec(qry, QVariantList() << dir + 1 << QString("dir_%1").arg(dir) << LibraryGenerator::getResourceDirPath(dir)))
+            return false;
+    }
+
+    qry.prepare("INSERT INTO sound_file (id, name, path, relative_path) VALUES (?, ?, ?, ?)");
+    for(int id = 1; id <= spec.sound_files; ++id) {
+        QString path = LibraryGenerator::getSoundFilePath(id, spec);
+        QString dir_path = LibraryGenerator::getResourceDirPath(id % spec.resource_dirs);
+        if(!exec(qry, QVariantList() << id << path.split("/").last() << path << path.mid(dir_path.size())))
+            return false;
+    }
+
+    // categories level by level, children get consecutive ids
+    qry.prepare("INSERT INTO category (id, name, parent_id) VALUES (?, ?, ?)");
+    QList<int> level;
+    int id = 0;
+    for(int i = 0; i < spec.top_categories; ++i) {
+        ++id;
+        if(!exec(qry, QVariantList() << id << WORDS[i % WORDS.size()] + QString(" %1").arg(id) << QVariant(QVariant::Int)))
+            return false;
+        level.append(id);
+    }
+    QList<int> leaves = level;
+    for(int depth = 0; depth < spec.category_depth; ++depth) {
+        QList<int> next_level;
+        foreach(int parent_id, level) {
+            for(int i = 0; i < spec.category_fanout; ++i) {
+                ++id;
+                if(!exec(qry, QVariantList() << id << WORDS[id % WORDS.size()] + QString(" %1").arg(id) << parent_id))
+                    return false;
+                next_level.append(id);
+            }
+        }
+        level = next_level;
+        leaves = level;
+    }
+
+    // files are related to random leaves, like an imported folder structure would
+    qry.prepare("INSERT INTO sound_file_category (sound_file_id, category_id) VALUES (?, ?)");
+    for(int file_id = 1; file_id <= spec.sound_files; ++file_id) {
+        for(int i = 0; i < spec.categories_per_file; ++i) {
+            if(!exec(qry, QVariantList() << file_id << leaves[qrand() % leaves.size()]))
+                return false;
+        }
+    }
+
+    qry.prepare("INSERT INTO preset (name, json) VALUES (?, ?)");
+    for(int i = 0; i < spec.presets; ++i) {
+        QString json = QString("{\"name\": \"preset %1\", \"tiles\": [{\"sound_file_id\": %2}]}")
+                .arg(i)
+                .arg(qrand() % qMax(1, spec.sound_files) + 1);
+        if(!exec(qry, QVariantList() << QString("preset %1").arg(i) << json))
+            return false;
+    }
+
+    return db.commit();
+}
+
+bool LibraryGenerator::generate(const QString &db_path, const LibrarySpec &spec)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile::remove(db_path);
+    QFile::remove(db_path + "-wal");
+    QFile::remove(db_path + "-shm");
+
+    qsrand(SEED);
+
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+        db.setDatabaseName(db_path);
+        if(db.open()) {
+            ok = fill(db, spec);
+            if(!ok)
+                db.rollback();
+            db.close();
+        }
+        else {
+            qDebug() << "FAILURE: could not create library db";
+            qDebug() << " > path:" << db_path;
+            qDebug() << " > Error:" << db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+
+    qDebug() << "NOTIFICATION: generated library";
+    qDebug() << " > path:" << db_path;
+    qDebug() << " > sound files:" << spec.sound_files;
+    qDebug() << " > categories:" << spec.getCategoryCount();
+    qDebug() << " > ms:" << timer.elapsed();
+
+    return ok;
+}
+
+const QString LibraryGenerator::getResourceDirPath(int dir)
+{
+    return QString("/library/dir_%1").arg(dir);
+}
+
+const QString LibraryGenerator::getSoundFilePath(int id, const LibrarySpec &spec)
+{
+    // two folder levels below resource dir, a few hundred files per folder
+    QString path = getResourceDirPath(id % spec.resource_dirs) + "/";
+    path += WORDS[(id / 7) % WORDS.size()] + "/";
+    path += QString("set_%1/").arg(id / 200);
+    path += QString("%1_%2_%3.wav").arg(WORDS[id % WORDS.size()]).arg(WORDS[(id / 3) % WORDS.size()]).arg(id);
+    return path;
+}
+
+} // namespace _BENCHMARK
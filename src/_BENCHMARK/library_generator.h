@@ -0,0 +1,63 @@
+#ifndef BENCHMARK_LIBRARY_GENERATOR_H
+#define BENCHMARK_LIBRARY_GENERATOR_H
+
+#include <QString>
+
+namespace _BENCHMARK {
+
+/*
+ * Describes shape of a synthetic sound library.
+ * Categories form top_categories trees, each category below
+ * depth category_depth holds category_fanout subcategories.
+**/
+struct LibrarySpec
+{
+    int sound_files;
+    int resource_dirs;
+    int top_categories;
+    int category_depth;
+    int category_fanout;
+    int categories_per_file;
+    int presets;
+
+    LibrarySpec(int files = 10000)
+        : sound_files(files)
+        , resource_dirs(4)
+        , top_categories(8)
+        , category_depth(5)
+        , category_fanout(3)
+        , categories_per_file(2)
+        , presets(500)
+    {}
+
+    /* Gets total number of categories spanned by spec */
+    int getCategoryCount() const;
+
+    /* Gets unique file name for db of this spec */
+    QString const getFileName() const;
+};
+
+/*
+ * Writes synthetic companion databases, with the schema the app expects.
+ * Content is deterministic (fixed random seed), so equal specs yield equal dbs
+ * and results stay comparable between runs.
+**/
+class LibraryGenerator
+{
+public:
+    /*
+     * Creates db at given path filled as described by spec.
+     * Replaces existing file. Returns success.
+    */
+    static bool generate(QString const& db_path, LibrarySpec const& spec);
+
+    /* Gets path of resource dir with given index */
+    static QString const getResourceDirPath(int dir);
+
+    /* Gets path of sound_file with given (1-based) id */
+    static QString const getSoundFilePath(int id, LibrarySpec const& spec);
+};
+
+} // namespace _BENCHMARK
+
+#endif // BENCHMARK_LIBRARY_GENERATOR_H
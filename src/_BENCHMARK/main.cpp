@@ -0,0 +1,25 @@
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QtTest>
+
+#include "database_benchmark.h"
+
+/*
+ * Runs benchmarks of the database layer against generated libraries.
+ * Accepts all QTest arguments, results are machine-readable through QTest loggers, e.g.
+ *
+ *   companion-benchmark -o results.xml,xml -o results.csv,csv
+ *
+ * Set COMPANION_BENCH_VERBOSE to keep log output of the database layer.
+**/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // db layer reports through qDebug, which would drown results
+    if(qgetenv("COMPANION_BENCH_VERBOSE").isEmpty())
+        QLoggingCategory::setFilterRules("default.debug=false");
+
+    _BENCHMARK::DatabaseBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
@@ -0,0 +1,44 @@
+#-------------------------------------------------
+#
+# Benchmarks of the database layer,
+# run against generated sound libraries (see _BENCHMARK/main.cpp).
+#
+#-------------------------------------------------
+TARGET = companion-benchmark
+TEMPLATE = app
+
+QT       += core \
+            sql \
+            concurrent \
+            testlib
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+INCLUDEPATH += $$PWD
+
+SOURCES += _BENCHMARK/main.cpp \
+    _BENCHMARK/database_benchmark.cpp \
+    _BENCHMARK/library_generator.cpp \
+    db/table_records.cpp \
+    db/core/sqlite_wrapper.cpp \
+    db/core/sqlite_connection.cpp \
+    db/core/sqlite_profile.cpp \
+    db/core/database_api.cpp \
+    db/model/sound_file_store.cpp \
+    db/model/category_closure.cpp \
+    db/model/id_ordered_table_model.cpp \
+    db/model/sound_file_table_model.cpp
+
+HEADERS  += _BENCHMARK/database_benchmark.h \
+    _BENCHMARK/library_generator.h \
+    db/table_records.h \
+    db/core/sqlite_wrapper.h \
+    db/core/sqlite_connection.h \
+    db/core/sqlite_profile.h \
+    db/core/database_api.h \
+    db/model/sound_file_store.h \
+    db/model/category_closure.h \
+    db/model/id_ordered_table_model.h \
+    db/model/sound_file_table_model.h
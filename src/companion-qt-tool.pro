@@ -29,16 +29,30 @@ SOURCES += main.cpp \
     _TEST/multi_track_media_player.cpp \
     _TEST/player_controls.cpp \
     db/core/sqlite_wrapper.cpp \
+    db/core/sqlite_connection.cpp \
+    db/core/sqlite_profile.cpp \
     db/model/category_tree_model.cpp \
     db/model/sound_file_table_model.cpp \
+    db/model/id_ordered_table_model.cpp \
+    db/model/sound_file_paged_model.cpp \
+    db/model/sound_file_search_model.cpp \
+    db/model/sound_file_store.cpp \
+    db/model/category_closure.cpp \
+    db/model/sound_file_bitmap.cpp \
+    db/model/category_membership_index.cpp \
     db/table_records.cpp \
     misc/drop_group_box.cpp \
     misc/standard_item_model.cpp \
     misc/char_input_dialog.cpp \
     db/model/resource_dir_table_model.cpp \
     resources/importer.cpp \
+    resources/folder_scanner.cpp \
+    resources/rescanner.cpp \
+    resources/audio_metadata_reader.cpp \
+    resources/metadata_extractor.cpp \
     resources/lib.cpp \
     resources/path_fixer.cpp \
+    resources/path_relocator.cpp \
     resources/image_file.cpp \
     resources/resource_file.cpp \
     resources/sound_file.cpp \
@@ -98,6 +112,14 @@ SOURCES += main.cpp \
     db/core/database_api.cpp \
     image/image_browser.cpp \
     image/image_canvas.cpp \
+    sound/audio_engine.cpp \
+    sound/audio_mixer.cpp \
+    sound/audio_ring_buffer.cpp \
+    sound/audio_stream_decoder.cpp \
+    sound/audio_voice.cpp \
+    sound/mix_kernels.cpp \
+    sound/preroll_cache.cpp \
+    sound/preroll_decoder.cpp \
     sound/sound_file_player.cpp \
     sound/sound_list_playback_view.cpp \
     sound/sound_list_view.cpp \
@@ -106,6 +128,8 @@ SOURCES += main.cpp \
     playlist/playlist.cpp \
     playlist/playlist_player.cpp \
     playlist/playlist_settings_widget.cpp \
+    playlist/playlist_weights_dialog.cpp \
+    playlist/weighted_sampler.cpp \
     json/json_mime_data_parser.cpp
 
 HEADERS  += main_window.h \
@@ -114,16 +138,30 @@ HEADERS  += main_window.h \
     _TEST/multi_track_media_player.h \
     _TEST/player_controls.h \
     db/core/sqlite_wrapper.h \
+    db/core/sqlite_connection.h \
+    db/core/sqlite_profile.h \
     db/model/category_tree_model.h \
     db/model/sound_file_table_model.h \
+    db/model/id_ordered_table_model.h \
+    db/model/sound_file_paged_model.h \
+    db/model/sound_file_search_model.h \
+    db/model/sound_file_store.h \
+    db/model/category_closure.h \
+    db/model/sound_file_bitmap.h \
+    db/model/category_membership_index.h \
     db/table_records.h \
     misc/drop_group_box.h \
     misc/char_input_dialog.h \
     misc/standard_item_model.h \
     db/model/resource_dir_table_model.h \
     resources/importer.h \
+    resources/folder_scanner.h \
+    resources/rescanner.h \
+    resources/audio_metadata_reader.h \
+    resources/metadata_extractor.h \
     resources/lib.h \
     resources/path_fixer.h \
+    resources/path_relocator.h \
     resources/image_file.h \
     resources/resource_file.h \
     resources/sound_file.h \
@@ -183,6 +221,14 @@ HEADERS  += main_window.h \
     db/core/database_api.h \
     image/image_browser.h \
     image/image_canvas.h \
+    sound/audio_engine.h \
+    sound/audio_mixer.h \
+    sound/audio_ring_buffer.h \
+    sound/audio_stream_decoder.h \
+    sound/audio_voice.h \
+    sound/mix_kernels.h \
+    sound/preroll_cache.h \
+    sound/preroll_decoder.h \
     sound/sound_file_player.h \
     sound/sound_list_playback_view.h \
     sound/sound_list_view.h \
@@ -192,6 +238,8 @@ HEADERS  += main_window.h \
     playlist/playlist_player.h \
     playlist/playlist_settings.h \
     playlist/playlist_settings_widget.h \
+    playlist/playlist_weights_dialog.h \
+    playlist/weighted_sampler.h \
     json/json_mime_data_parser.h
 
 RESOURCES += \
@@ -21,11 +21,16 @@ CompanionWidget::CompanionWidget(QWidget *parent)
     , actions_()
     , main_menu_(0)
     , sound_file_view_(0)
+    , sound_search_edit_(0)
     , global_player_(0)
     , category_view_(0)
     , preset_view_(0)
     , graphics_view_(0)
     , sound_file_importer_(0)
+    , rescanner_(0)
+    , metadata_extractor_(0)
+    , path_fixer_(0)
+    , path_relocator_(0)
     , center_h_splitter_(0)
     , left_v_splitter_(0)
     , left_box_(0)
@@ -86,19 +91,76 @@ void CompanionWidget::onProgressChanged(int value)
     progress_bar_->setValue(value);
 }
 
+void CompanionWidget::onImportStarted()
+{
+    // number of files is not known while scanning, show busy indicator
+    progress_bar_->setRange(0, 0);
+    progress_bar_->show();
+    actions_["Cancel Import"]->setEnabled(true);
+}
+
+void CompanionWidget::onImportStatusChanged(const QString &message)
+{
+    status_message_ = message;
+    progress_bar_->setToolTip(message);
+    emit statusMessageUpdated(message);
+}
+
+void CompanionWidget::onImportFinished()
+{
+    progress_bar_->setRange(0, 100);
+    progress_bar_->setValue(100);
+    progress_bar_->hide();
+    actions_["Cancel Import"]->setEnabled(false);
+}
+
+void CompanionWidget::onRelocationFinished(int relocated, int ambiguous, int unmatched)
+{
+    Resources::PathRelocator::Report const& report = path_relocator_->getReport();
+
+    QMessageBox b;
+    b.setText(tr("Relocated %1 of %2 missing sound files.").arg(relocated).arg(report.missing));
+    if(ambiguous > 0 || unmatched > 0) {
+        b.setInformativeText(tr("%1 sound files match more than one file, %2 were not found. See details.")
+                             .arg(ambiguous).arg(unmatched));
+        b.setDetailedText(Resources::PathRelocator::formatReport(report));
+    }
+    b.setStandardButtons(QMessageBox::Ok);
+    b.setDefaultButton(QMessageBox::Ok);
+    b.exec();
+}
+
 void CompanionWidget::onSelectedCategoryChanged(CategoryRecord *rec)
 {
     int id = -1;
     if(rec != 0)
         id = rec->id;
 
+    // category listing replaces search results
+    if(!sound_search_edit_->text().isEmpty()) {
+        sound_search_edit_->blockSignals(true);
+        sound_search_edit_->clear();
+        sound_search_edit_->blockSignals(false);
+        db_handler_->getSoundFileSearchModel()->setQuery("");
+    }
+
     sound_file_view_->setSoundFiles(db_handler_->getSoundFileRecordsByCategoryId(id));
 }
 
+void CompanionWidget::onSoundSearchChanged(const QString &text)
+{
+    db_handler_->getSoundFileSearchModel()->setQuery(text);
+
+    if(text.trimmed().isEmpty())
+        sound_file_view_->setLibraryModel(db_handler_->getSoundFilePagedModel());
+    else
+        sound_file_view_->setLibraryModel(db_handler_->getSoundFileSearchModel());
+}
+
 void CompanionWidget::onDeleteDatabase()
 {
-    db_handler_->deleteAll();
-    category_view_->selectRoot();
+    if(db_handler_->deleteAll())
+        category_view_->selectRoot();
 }
 
 void CompanionWidget::onSaveProjectAs()
@@ -327,10 +389,13 @@ void CompanionWidget::setProjectPath(const QString &path)
 
 void CompanionWidget::initWidgets()
 {
-    sound_file_view_ = new SoundListPlaybackView(
-        db_handler_->getSoundFileTableModel()->getSoundFiles(),
-        this
-    );
+    // whole library is paged in, rather than listed record by record
+    sound_file_view_ = new SoundListPlaybackView(this);
+    sound_file_view_->setLibraryModel(db_handler_->getSoundFilePagedModel());
+
+    sound_search_edit_ = new QLineEdit(this);
+    sound_search_edit_->setPlaceholderText(tr("Search sounds..."));
+    sound_search_edit_->setClearButtonEnabled(true);
 
     global_player_ = new SoundFilePlayer(this);
     connect(sound_file_view_, &SoundListPlaybackView::play,
@@ -353,6 +418,15 @@ void CompanionWidget::initWidgets()
         this
     );
 
+    rescanner_ = new Resources::Rescanner(db_handler_, this);
+
+    metadata_extractor_ = new Resources::MetadataExtractor(db_handler_, this);
+    path_fixer_ = new Resources::PathFixer(db_handler_, this);
+    path_relocator_ = new Resources::PathRelocator(db_handler_, this);
+
+    // files imported before (or by older versions) may lack metadata
+    QMetaObject::invokeMethod(metadata_extractor_, "extractPending", Qt::QueuedConnection);
+
     category_view_ = new CategoryTreeView(this);
     category_view_->setCategoryTreeModel(db_handler_->getCategoryTreeModel());
 
@@ -372,6 +446,7 @@ void CompanionWidget::initWidgets()
 
     QWidget* sound_container = new QWidget(this);
     QVBoxLayout* container_layout = new QVBoxLayout;
+    container_layout->addWidget(sound_search_edit_, -1);
     container_layout->addWidget(sound_file_view_, 10);
     container_layout->addWidget(global_player_, -1);
     container_layout->setContentsMargins(0,0,0,0);
@@ -393,14 +468,38 @@ void CompanionWidget::initWidgets()
     left_tabwidget_->addTab(image_browser_, tr("Images"));
     left_tabwidget_->addTab(preset_view_, tr("Presets"));
 
-    connect(sound_file_importer_, SIGNAL(folderImported(QList<Resources::SoundFile> const&)),
-            db_handler_, SLOT(insertSoundFilesAndCategories(QList<Resources::SoundFile> const&)));
+    connect(sound_file_importer_, SIGNAL(soundFilesFound(QList<Resources::SoundFile> const&)),
+            db_handler_, SLOT(importSoundFiles(QList<Resources::SoundFile> const&)));
+    connect(sound_file_importer_, SIGNAL(importStarted()),
+            this, SLOT(onImportStarted()));
+    connect(sound_file_importer_, SIGNAL(statusMessageUpdated(QString const&)),
+            this, SLOT(onImportStatusChanged(QString const&)));
+    connect(sound_file_importer_, SIGNAL(folderImported()),
+            this, SLOT(onImportFinished()));
     connect(sound_file_importer_, SIGNAL(folderImported()),
             category_view_, SLOT(selectRoot()));
+    connect(rescanner_, SIGNAL(statusMessageUpdated(QString const&)),
+            this, SLOT(onImportStatusChanged(QString const&)));
+    connect(sound_file_importer_, SIGNAL(folderImported()),
+            metadata_extractor_, SLOT(extractPending()));
+    connect(rescanner_, SIGNAL(rescanFinished(QString const&, int, int, int)),
+            metadata_extractor_, SLOT(extractPending()));
+    connect(metadata_extractor_, SIGNAL(statusMessageUpdated(QString const&)),
+            this, SLOT(onImportStatusChanged(QString const&)));
+    connect(metadata_extractor_, SIGNAL(extractionFinished(int)),
+            path_fixer_, SLOT(reportDuplicates()));
+    connect(path_fixer_, SIGNAL(statusMessageUpdated(QString const&)),
+            this, SLOT(onImportStatusChanged(QString const&)));
+    connect(path_relocator_, SIGNAL(statusMessageUpdated(QString const&)),
+            this, SLOT(onImportStatusChanged(QString const&)));
+    connect(path_relocator_, SIGNAL(relocationFinished(int, int, int)),
+            this, SLOT(onRelocationFinished(int, int, int)));
     connect(db_handler_, SIGNAL(progressChanged(int)),
             this, SLOT(onProgressChanged(int)));
     connect(category_view_, SIGNAL(categorySelected(CategoryRecord*)),
             this, SLOT(onSelectedCategoryChanged(CategoryRecord*)));
+    connect(sound_search_edit_, SIGNAL(textChanged(QString const&)),
+            this, SLOT(onSoundSearchChanged(QString const&)));
     connect(sound_file_view_, SIGNAL(deleteSoundFileRequested(int)),
             db_handler_->getSoundFileTableModel(), SLOT(deleteSoundFile(int)));
     connect(db_handler_->getSoundFileTableModel(), SIGNAL(aboutToBeDeleted(SoundFileRecord*)),
@@ -436,6 +535,20 @@ void CompanionWidget::initActions()
     actions_["Import Resource Folder..."]->setToolTip(tr("Imports a folder of resources into the program."));
     actions_["Import Resource Folder..."]->setShortcut(QKeySequence(tr("Ctrl+Shift+O")));
 
+    actions_["Cancel Import"] = new QAction(tr("Cancel Import"), this);
+    actions_["Cancel Import"]->setToolTip(tr("Stops scanning the resource folder being imported."));
+    actions_["Cancel Import"]->setEnabled(false);
+
+    actions_["Rescan Resource Folders"] = new QAction(tr("Rescan Resource Folders"), this);
+    actions_["Rescan Resource Folders"]->setToolTip(tr("Adds, removes and updates sound files of all resource folders, to match their contents on disk."));
+
+    actions_["Watch Resource Folders"] = new QAction(tr("Watch Resource Folders"), this);
+    actions_["Watch Resource Folders"]->setToolTip(tr("Rescans resource folders as soon as their contents change on disk."));
+    actions_["Watch Resource Folders"]->setCheckable(true);
+
+    actions_["Relocate Missing Sound Files..."] = new QAction(tr("Relocate Missing Sound Files..."), this);
+    actions_["Relocate Missing Sound Files..."]->setToolTip(tr("Searches a folder for sound files missing at their recorded path and relinks them."));
+
     actions_["Delete Database Contents..."] = new QAction(tr("Delete Database Contents..."), this);
     actions_["Delete Database Contents..."]->setToolTip(tr("Deletes all contents from application database."));
 
@@ -485,6 +598,14 @@ void CompanionWidget::initActions()
 
     connect(actions_["Import Resource Folder..."] , SIGNAL(triggered(bool)),
             sound_file_importer_, SLOT(startBrowseFolder(bool)));
+    connect(actions_["Cancel Import"], SIGNAL(triggered()),
+            sound_file_importer_, SLOT(cancelImport()));
+    connect(actions_["Rescan Resource Folders"], SIGNAL(triggered()),
+            rescanner_, SLOT(rescanAll()));
+    connect(actions_["Watch Resource Folders"], SIGNAL(toggled(bool)),
+            rescanner_, SLOT(setWatching(bool)));
+    connect(actions_["Relocate Missing Sound Files..."], SIGNAL(triggered()),
+            path_relocator_, SLOT(startBrowseRoot()));
     connect(actions_["Delete Database Contents..."], SIGNAL(triggered()),
             this, SLOT(onDeleteDatabase()));
     connect(actions_["Close Project"], SIGNAL(triggered()),
@@ -524,6 +645,10 @@ void CompanionWidget::initMenu()
     file_menu->addAction(actions_["Save View as Layout..."]);
     file_menu->addSeparator();
     file_menu->addAction(actions_["Import Resource Folder..."]);
+    file_menu->addAction(actions_["Cancel Import"]);
+    file_menu->addAction(actions_["Rescan Resource Folders"]);
+    file_menu->addAction(actions_["Watch Resource Folders"]);
+    file_menu->addAction(actions_["Relocate Missing Sound Files..."]);
     file_menu->addSeparator();
     file_menu->addAction(actions_["Delete Database Contents..."]);
     QMenu* tool_menu = main_menu_->addMenu(tr("Tools"));
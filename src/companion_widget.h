@@ -14,9 +14,14 @@
 #include <QProgressBar>
 #include <QSplitter>
 #include <QScrollArea>
+#include <QLineEdit>
 
 #include "misc/drop_group_box.h"
 #include "resources/importer.h"
+#include "resources/rescanner.h"
+#include "resources/metadata_extractor.h"
+#include "resources/path_fixer.h"
+#include "resources/path_relocator.h"
 #include "sound/sound_list_playback_view.h"
 #include "db/database_handler.h"
 #include "category/category_tree_view.h"
@@ -46,7 +51,12 @@ public slots:
 
 private slots:
     void onProgressChanged(int);
+    void onImportStarted();
+    void onImportStatusChanged(QString const& message);
+    void onImportFinished();
+    void onRelocationFinished(int relocated, int ambiguous, int unmatched);
     void onSelectedCategoryChanged(CategoryRecord* rec);
+    void onSoundSearchChanged(QString const& text);
     void onDeleteDatabase();
     void onSaveProjectAs();
     void onSaveProject();
@@ -82,12 +92,17 @@ private:
 
     // WIDGETS
     SoundListPlaybackView* sound_file_view_;
+    QLineEdit* sound_search_edit_;
     SoundFilePlayer* global_player_;
     CategoryTreeView* category_view_;
     PresetView* preset_view_;
 
     Tile::Canvas* graphics_view_;
     Resources::Importer* sound_file_importer_;
+    Resources::Rescanner* rescanner_;
+    Resources::MetadataExtractor* metadata_extractor_;
+    Resources::PathFixer* path_fixer_;
+    Resources::PathRelocator* path_relocator_;
     QSplitter* center_h_splitter_;
     QSplitter* left_v_splitter_;
     QGroupBox* left_box_;
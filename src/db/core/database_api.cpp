@@ -1,159 +1,821 @@
 #include "database_api.h"
 
+#include <QtAlgorithms>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// number of row writes remembered per table, before models have to diff whole table
+static const int CHANGE_LOG_SIZE = 1024;
+
+/*
+ * Schema changes applied on top of the schema the db was created with (name, statement).
+ * Names are recorded in schema_migration once applied, so entries must never be renamed or reordered.
+ * New entries go to the end.
+*/
+static const QList<QPair<QString, QString> > MIGRATIONS = QList<QPair<QString, QString> >()
+        << qMakePair(QString("sound_file_path_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS sound_file_path_idx ON sound_file (path)"))
+        << qMakePair(QString("sound_file_category_sound_file_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS sound_file_category_sound_file_idx ON sound_file_category (sound_file_id, category_id)"))
+        << qMakePair(QString("sound_file_category_category_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS sound_file_category_category_idx ON sound_file_category (category_id)"))
+        << qMakePair(QString("category_parent_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS category_parent_idx ON category (parent_id)"))
+        << qMakePair(QString("preset_name_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS preset_name_idx ON preset (name)"))
+        << qMakePair(QString("resource_directory_path_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS resource_directory_path_idx ON resource_directory (path)"))
+        << qMakePair(QString("image_directory_path_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS image_directory_path_idx ON image_directory (path)"))
+        << qMakePair(QString("sound_file_size_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN size INTEGER"))
+        << qMakePair(QString("sound_file_mtime_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN mtime INTEGER"))
+        << qMakePair(QString("resource_folder_table"),
+                     QString("CREATE TABLE IF NOT EXISTS resource_folder (id INTEGER PRIMARY KEY, resource_directory_id INTEGER, path TEXT UNIQUE, mtime INTEGER)"))
+        << qMakePair(QString("resource_folder_resource_directory_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS resource_folder_resource_directory_idx ON resource_folder (resource_directory_id)"))
+        << qMakePair(QString("sound_file_duration_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN duration_ms INTEGER"))
+        << qMakePair(QString("sound_file_sample_rate_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN sample_rate INTEGER"))
+        << qMakePair(QString("sound_file_channels_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN channels INTEGER"))
+        << qMakePair(QString("sound_file_bitrate_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN bitrate INTEGER"))
+        << qMakePair(QString("sound_file_tags_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN tags TEXT"))
+        << qMakePair(QString("sound_file_metadata_mtime_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN metadata_mtime INTEGER"))
+        << qMakePair(QString("sound_file_duration_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS sound_file_duration_idx ON sound_file (duration_ms)"))
+        << qMakePair(QString("sound_file_fingerprint_column"),
+                     QString("ALTER TABLE sound_file ADD COLUMN fingerprint TEXT"))
+        << qMakePair(QString("sound_file_fingerprint_idx"),
+                     QString("CREATE INDEX IF NOT EXISTS sound_file_fingerprint_idx ON sound_file (fingerprint)"))
+        // fingerprints get computed along with metadata, read metadata of all files again
+        << qMakePair(QString("sound_file_fingerprint_backfill"),
+                     QString("UPDATE sound_file SET metadata_mtime = NULL WHERE fingerprint IS NULL"));
+
+// maximum number of ids bound to a single 'IN (...)' list
+static const int DELETE_CHUNK_SIZE = 512;
+
+/*
+ * Deletes rows of table with column value in ids, using 'IN (...)' lists of bound ids.
+ * Lists get padded (repeating last id) to a power of two, so only a few statement shapes get cached.
+ * Has to run on the database thread within a transaction. Returns success.
+*/
+static bool deleteByIds(SqliteConnection* c, QString const& table, QString const& column, QList<int> const& ids)
+{
+    for(int start = 0; start < ids.size(); start += DELETE_CHUNK_SIZE) {
+        QList<int> chunk = ids.mid(start, DELETE_CHUNK_SIZE);
+
+        int size = 1;
+        while(size < chunk.size())
+            size *= 2;
+
+        QVariantList values;
+        values.reserve(size);
+        foreach(int id, chunk)
+            values << id;
+        while(values.size() < size)
+            values << chunk.last();
+
+        QStringList params;
+        params.reserve(size);
+        for(int i = 0; i < size; ++i)
+            params << "?";
+
+        QString qry_str = "DELETE FROM " + table + " WHERE " + column + " IN (" + params.join(",") + ")";
+        if(!c->preparedExec(qry_str, values))
+            return false;
+    }
+
+    return true;
+}
+
+// space separated category names of a sound_file (for search index)
+static const QString SEARCH_CATEGORIES_OF =
+        "(SELECT group_concat(category.name, ' ') FROM category"
+        " JOIN sound_file_category ON sound_file_category.category_id = category.id"
+        " WHERE sound_file_category.sound_file_id = %1)";
+
 DatabaseApi::DatabaseApi(QString const& db_path, QObject *parent)
     : SqliteWrapper(db_path, parent)
-{}
+    , change_logs_()
+    , search_mode_(SEARCH_LIKE)
+{
+    runMigrations();
+    initSearchIndex();
+}
 
-QSqlRelationalTableModel *DatabaseApi::getSoundFileTable()
+const QList<QSqlRecord> DatabaseApi::getSoundFileTable()
 {
     return getTable(SOUND_FILE);
 }
 
-QSqlRelationalTableModel *DatabaseApi::getCategoryTable()
+const QList<QSqlRecord> DatabaseApi::getCategoryTable()
 {
     return getTable(CATEGORY);
 }
 
-QSqlRelationalTableModel *DatabaseApi::getSoundFileCategoryTable()
+const QList<QSqlRecord> DatabaseApi::getSoundFileCategoryTable()
 {
     return getTable(SOUND_FILE_CATEGORY);
 }
 
-QSqlRelationalTableModel *DatabaseApi::getResourceDirTable()
+const QList<QSqlRecord> DatabaseApi::getResourceDirTable()
 {
     return getTable(RESOURCE_DIRECTORY);
 }
 
-QSqlRelationalTableModel *DatabaseApi::getImageDirTable()
+const QList<QSqlRecord> DatabaseApi::getImageDirTable()
 {
     return getTable(IMAGE_DIRECTORY);
 }
 
-QSqlRelationalTableModel *DatabaseApi::getPresetTable()
+const QList<QSqlRecord> DatabaseApi::getPresetTable()
 {
     return getTable(PRESET);
 }
 
+QFuture<QList<QSqlRecord> > DatabaseApi::getSoundFileTableAsync()
+{
+    return getTableAsync(SOUND_FILE);
+}
+
+int DatabaseApi::getSoundFileCount()
+{
+    return preparedValue("SELECT COUNT(*) FROM sound_file").toInt();
+}
+
+const QList<int> DatabaseApi::getSoundFileIds()
+{
+    QList<int> ids;
+    foreach(QSqlRecord const& rec, preparedQuery("SELECT id FROM sound_file ORDER BY id"))
+        ids.append(rec.value(0).toInt());
+    return ids;
+}
+
+const QList<QSqlRecord> DatabaseApi::getSoundFilePage(int after_id, int limit)
+{
+    return preparedQuery(
+        "SELECT id, name, path, relative_path, duration_ms FROM sound_file WHERE id > ? ORDER BY id LIMIT ?",
+        QVariantList() << after_id << limit
+    );
+}
+
+int DatabaseApi::getSoundFileIdAt(int row)
+{
+    QVariant id = preparedValue(
+        "SELECT id FROM sound_file ORDER BY id LIMIT 1 OFFSET ?",
+        QVariantList() << row
+    );
+    return id.isValid() ? id.toInt() : -1;
+}
+
+int DatabaseApi::getSoundFileRow(int id)
+{
+    QVariant exists = preparedValue("SELECT id FROM sound_file WHERE id = ?", QVariantList() << id);
+    if(!exists.isValid())
+        return -1;
+
+    return preparedValue("SELECT COUNT(*) FROM sound_file WHERE id < ?", QVariantList() << id).toInt();
+}
+
+const QList<int> DatabaseApi::getSoundFileRows(const QList<int> &ids)
+{
+    if(ids.size() == 0)
+        return QList<int>();
+
+    return callRead<QList<int> >([ids](SqliteConnection* c) -> QList<int> {
+        QList<int> rows;
+        rows.reserve(ids.size());
+
+        // count id range between neighbouring ids only, so table gets walked once
+        int count = 0;
+        int from_id = 0;
+        foreach(int id, ids) {
+            count += c->preparedValue(
+                "SELECT COUNT(*) FROM sound_file WHERE id >= ? AND id < ?",
+                QVariantList() << from_id << id
+            ).toInt();
+            rows.append(count);
+            from_id = id;
+        }
+        return rows;
+    });
+}
+
+int DatabaseApi::getSoundFileMaxId()
+{
+    return preparedValue("SELECT IFNULL(MAX(id), 0) FROM sound_file").toInt();
+}
+
+const QList<QSqlRecord> DatabaseApi::getRecords(TableIndex index, const QList<int> &ids)
+{
+    if(index == NONE || ids.size() == 0)
+        return QList<QSqlRecord>();
+
+    QList<int> sorted_ids(ids);
+    qSort(sorted_ids);
+
+    QString qry_str = "SELECT * FROM " + toString(index) + " WHERE id = ?";
+    return callRead<QList<QSqlRecord> >([qry_str, sorted_ids](SqliteConnection* c) -> QList<QSqlRecord> {
+        QList<QSqlRecord> rows;
+        foreach(int id, sorted_ids)
+            rows.append(c->preparedQuery(qry_str, QVariantList() << id));
+        return rows;
+    });
+}
+
+int DatabaseApi::getTableVersion(TableIndex index) const
+{
+    return change_logs_.value(index).version;
+}
+
+bool DatabaseApi::getChangedIds(TableIndex index, int since_version, QSet<int> &ids) const
+{
+    TableChangeLog log = change_logs_.value(index);
+    if(since_version < log.base_version || since_version > log.version)
+        return false;
+
+    typedef QPair<int, int> Change;
+    foreach(Change const& change, log.changes) {
+        if(change.first > since_version)
+            ids.insert(change.second);
+    }
+
+    return true;
+}
+
 void DatabaseApi::insertSoundFile(const QFileInfo &info, ResourceDirRecord const& resource_dir)
 {
     QString rel_path = info.filePath();
     rel_path.remove(0, resource_dir.path.size());
 
-    QString value_block  = "";
-    value_block = "(name, path, relative_path) VALUES (";
-    value_block += "'" + SqliteWrapper::escape(info.fileName()) + "','";
-    value_block += SqliteWrapper::escape(info.filePath()) + "','";
-    value_block += SqliteWrapper::escape(rel_path) + "')";
-
-    insertQuery(SOUND_FILE, value_block);
+    int id = preparedInsert(
+        "INSERT INTO sound_file (name, path, relative_path, size, mtime) VALUES (?, ?, ?, ?, ?)",
+        QVariantList() << info.fileName() << info.filePath() << rel_path << info.size() << getManifestTime(info)
+    );
+    markChanged(SOUND_FILE, id);
 }
 
 void DatabaseApi::insertCategory(const QString &name, int parent_id)
 {
-    QString value_block  = "";
+    int id = -1;
     if(parent_id != -1) {
-        value_block = "(name, parent_id) VALUES (";
-        value_block += "'" + SqliteWrapper::escape(name) + "'," + QString::number(parent_id) + ")";
+        id = preparedInsert(
+            "INSERT INTO category (name, parent_id) VALUES (?, ?)",
+            QVariantList() << name << parent_id
+        );
     }
     else {
-        value_block = "(name) VALUES ('" + SqliteWrapper::escape(name) + "')";
+        id = preparedInsert(
+            "INSERT INTO category (name) VALUES (?)",
+            QVariantList() << name
+        );
     }
-    insertQuery(CATEGORY, value_block);
+    markChanged(CATEGORY, id);
 }
 
 void DatabaseApi::insertSoundFileCategory(int sound_file_id, int category_id)
 {
-    QString value_block  = "";
-    value_block = "(sound_file_id, category_id) VALUES (";
-    value_block += QString::number(sound_file_id) + ",";
-    value_block += QString::number(category_id) + ")";
-
-    insertQuery(SOUND_FILE_CATEGORY, value_block);
+    int id = preparedInsert(
+        "INSERT INTO sound_file_category (sound_file_id, category_id) VALUES (?, ?)",
+        QVariantList() << sound_file_id << category_id
+    );
+    markChanged(SOUND_FILE_CATEGORY, id);
 }
 
 void DatabaseApi::insertResourceDir(const QFileInfo &info)
 {
-    QString value_block  = "";
-    value_block = "(name, path) VALUES (";
-    value_block += "'" + SqliteWrapper::escape(info.fileName()) + "','";
-    value_block += SqliteWrapper::escape(info.filePath()) + "')";
-
-    insertQuery(RESOURCE_DIRECTORY, value_block);
+    int id = preparedInsert(
+        "INSERT INTO resource_directory (name, path) VALUES (?, ?)",
+        QVariantList() << info.fileName() << info.filePath()
+    );
+    markChanged(RESOURCE_DIRECTORY, id);
 }
 
 void DatabaseApi::insertImageDir(const QFileInfo &info)
 {
-    QString value_block  = "";
-    value_block = "(path) VALUES ";
-    value_block += "('" + SqliteWrapper::escape(info.filePath()) + "')";
-
-    insertQuery(IMAGE_DIRECTORY, value_block);
+    int id = preparedInsert(
+        "INSERT INTO image_directory (path) VALUES (?)",
+        QVariantList() << info.filePath()
+    );
+    markChanged(IMAGE_DIRECTORY, id);
 }
 
 void DatabaseApi::insertPreset(const QString &name, const QString &json)
 {
-    QString value_block  = "";
-    value_block = "(name, json) VALUES (";
-    value_block += "'" + SqliteWrapper::escape(name) + "','";
-    value_block += SqliteWrapper::escape(json) + "')";
+    int id = preparedInsert(
+        "INSERT INTO preset (name, json) VALUES (?, ?)",
+        QVariantList() << name << json
+    );
+    markChanged(PRESET, id);
+}
+
+const QList<int> DatabaseApi::insertSoundFiles(const QList<QFileInfo> &infos, const ResourceDirRecord &resource_dir,
+                                               const QList<int> &category_ids)
+{
+    if(infos.size() == 0)
+        return QList<int>();
+
+    // whole batch runs as one job on database thread, files stay uncategorized only if none got inserted
+    QString dir_path = resource_dir.path;
+    QList<int> ids = callSync<QList<int> >([infos, dir_path, category_ids](SqliteConnection* c) -> QList<int> {
+        QList<int> ids;
+        if(!c->beginTransaction())
+            return ids;
+
+        for(int i = 0; i < infos.size(); ++i) {
+            QFileInfo const& info = infos[i];
+            QString rel_path = info.filePath();
+            rel_path.remove(0, dir_path.size());
+
+            bool success = c->preparedExec(
+                "INSERT INTO sound_file (name, path, relative_path, size, mtime) VALUES (?, ?, ?, ?, ?)",
+                QVariantList() << info.fileName() << info.filePath() << rel_path << info.size() << getManifestTime(info)
+            );
+
+            int id = success ? c->lastInsertId() : -1;
+            int category_id = i < category_ids.size() ? category_ids[i] : -1;
+            if(success && category_id != -1) {
+                success = c->preparedExec(
+                    "INSERT INTO sound_file_category (sound_file_id, category_id) VALUES (?, ?)",
+                    QVariantList() << id << category_id
+                );
+            }
+
+            if(!success) {
+                c->rollbackTransaction();
+                return QList<int>();
+            }
 
-    insertQuery(PRESET, value_block);
+            ids.append(id);
+        }
+
+        if(!c->commitTransaction())
+            return QList<int>();
+
+        return ids;
+    });
+
+    markChanged(SOUND_FILE, ids);
+
+    // ids of relation rows are not tracked
+    if(ids.size() > 0 && category_ids.size() > 0)
+        markTableChanged(SOUND_FILE_CATEGORY);
+
+    return ids;
+}
+
+bool DatabaseApi::insertSoundFileCategories(const QList<QPair<int, int> > &relations)
+{
+    if(relations.size() == 0)
+        return true;
+
+    bool success = callSync<bool>([relations](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        typedef QPair<int, int> Relation;
+        foreach(Relation const& rel, relations) {
+            bool success = c->preparedExec(
+                "INSERT INTO sound_file_category (sound_file_id, category_id) VALUES (?, ?)",
+                QVariantList() << rel.first << rel.second
+            );
+            if(!success) {
+                c->rollbackTransaction();
+                return false;
+            }
+        }
+
+        return c->commitTransaction();
+    });
+
+    // ids of relation rows are not tracked
+    markTableChanged(SOUND_FILE_CATEGORY);
+    return success;
+}
+
+bool DatabaseApi::updateCategoryName(int category_id, const QString &name)
+{
+    bool success = preparedExec(
+        "UPDATE category SET name = ? WHERE id = ?",
+        QVariantList() << name << category_id
+    );
+    if(success)
+        markChanged(CATEGORY, category_id);
+    return success;
+}
+
+bool DatabaseApi::deleteRecords(TableIndex index, const QList<int> &ids)
+{
+    if(index == NONE)
+        return false;
+    if(ids.size() == 0)
+        return true;
+
+    QString table = toString(index);
+    bool success = callSync<bool>([table, ids](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        if(!deleteByIds(c, table, "id", ids)) {
+            c->rollbackTransaction();
+            return false;
+        }
+
+        return c->commitTransaction();
+    });
+
+    if(success)
+        markChanged(index, ids);
+    return success;
+}
+
+bool DatabaseApi::deleteSoundFiles(const QList<int> &ids)
+{
+    if(ids.size() == 0)
+        return true;
+
+    bool success = callSync<bool>([ids](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        // relations first, so no orphans remain if anything fails
+        if(!deleteByIds(c, "sound_file_category", "sound_file_id", ids) || !deleteByIds(c, "sound_file", "id", ids)) {
+            c->rollbackTransaction();
+            return false;
+        }
+
+        return c->commitTransaction();
+    });
+
+    if(success) {
+        markTableChanged(SOUND_FILE_CATEGORY);
+        markChanged(SOUND_FILE, ids);
+    }
+    else {
+        qDebug() << "FAILURE: could not delete sound files";
+        qDebug() << " > count:" << ids.size();
+    }
+
+    return success;
+}
+
+const QList<QSqlRecord> DatabaseApi::getSoundFileManifest(const QString &prefix)
+{
+    return preparedQuery(
+        "SELECT id, path, size, mtime, fingerprint FROM sound_file WHERE substr(path, 1, ?) = ?",
+        QVariantList() << prefix.size() << prefix
+    );
+}
+
+qint64 DatabaseApi::getManifestTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+const QList<QSqlRecord> DatabaseApi::getResourceFolders(int resource_dir_id)
+{
+    return preparedQuery(
+        "SELECT path, mtime FROM resource_folder WHERE resource_directory_id = ?",
+        QVariantList() << resource_dir_id
+    );
+}
+
+bool DatabaseApi::applySoundFileDiff(const SoundFileDiff &diff, const ResourceDirRecord &resource_dir)
+{
+    QString dir_path = resource_dir.path;
+    int dir_id = resource_dir.id;
+
+    // ids of inserted sound_files and relations, filled on database thread
+    QList<int> ids;
+    QList<int> relation_ids;
+
+    bool success = callSync<bool>([&diff, dir_path, dir_id, &ids, &relation_ids](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        bool ok = deleteByIds(c, "sound_file_category", "sound_file_id", diff.removed)
+                && deleteByIds(c, "sound_file", "id", diff.removed);
+
+        for(int i = 0; ok && i < diff.added.size(); ++i) {
+            QFileInfo const& info = diff.added[i];
+            QString rel_path = info.filePath();
+            rel_path.remove(0, dir_path.size());
+
+            ok = c->preparedExec(
+                "INSERT INTO sound_file (name, path, relative_path, size, mtime) VALUES (?, ?, ?, ?, ?)",
+                QVariantList() << info.fileName() << info.filePath() << rel_path << info.size() << getManifestTime(info)
+            );
+            if(!ok)
+                break;
+
+            int id = c->lastInsertId();
+            ids.append(id);
+
+            int category_id = i < diff.added_category_ids.size() ? diff.added_category_ids[i] : -1;
+            if(category_id == -1)
+                continue;
+
+            ok = c->preparedExec(
+                "INSERT INTO sound_file_category (sound_file_id, category_id) VALUES (?, ?)",
+                QVariantList() << id << category_id
+            );
+            relation_ids.append(c->lastInsertId());
+        }
+
+        typedef QPair<int, QFileInfo> Modified;
+        foreach(Modified const& modified, diff.modified) {
+            if(!ok)
+                break;
+            ok = c->preparedExec(
+                "UPDATE sound_file SET size = ?, mtime = ? WHERE id = ?",
+                QVariantList() << modified.second.size() << getManifestTime(modified.second) << modified.first
+            );
+        }
+
+        foreach(Modified const& moved, diff.moved) {
+            if(!ok)
+                break;
+            QFileInfo const& info = moved.second;
+            QString rel_path = info.filePath();
+            rel_path.remove(0, dir_path.size());
+
+            ok = c->preparedExec(
+                "UPDATE sound_file SET name = ?, path = ?, relative_path = ?, size = ?, mtime = ? WHERE id = ?",
+                QVariantList() << info.fileName() << info.filePath() << rel_path << info.size() << getManifestTime(info) << moved.first
+            );
+        }
+
+        // folder manifest gets replaced as a whole
+        ok = ok && c->preparedExec(
+            "DELETE FROM resource_folder WHERE resource_directory_id = ?",
+            QVariantList() << dir_id
+        );
+        typedef QPair<QString, qint64> Folder;
+        foreach(Folder const& folder, diff.folders) {
+            if(!ok)
+                break;
+            ok = c->preparedExec(
+                "INSERT OR REPLACE INTO resource_folder (resource_directory_id, path, mtime) VALUES (?, ?, ?)",
+                QVariantList() << dir_id << folder.first << folder.second
+            );
+        }
+
+        if(!ok) {
+            c->rollbackTransaction();
+            return false;
+        }
+
+        // rolls back on its own, if commit fails
+        return c->commitTransaction();
+    });
+
+    if(!success) {
+        qDebug() << "FAILURE: could not apply sound file diff";
+        qDebug() << " > resource dir:" << dir_path;
+        return false;
+    }
+
+    QList<int> changed = ids;
+    changed << diff.removed;
+    typedef QPair<int, QFileInfo> Modified;
+    foreach(Modified const& modified, diff.modified + diff.moved)
+        changed.append(modified.first);
+    markChanged(SOUND_FILE, changed);
+
+    // relations of removed files are not known row by row
+    if(diff.removed.size() > 0)
+        markTableChanged(SOUND_FILE_CATEGORY);
+    else
+        markChanged(SOUND_FILE_CATEGORY, relation_ids);
+
+    return true;
+}
+
+const QList<QSqlRecord> DatabaseApi::getSoundFileLocations()
+{
+    return preparedQuery(
+        "SELECT id, name, path, relative_path, size, fingerprint FROM sound_file ORDER BY id"
+    );
+}
+
+bool DatabaseApi::relocateSoundFiles(const QList<SoundFileRelocation> &relocations)
+{
+    if(relocations.size() == 0)
+        return true;
+
+    bool success = callSync<bool>([&relocations](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        foreach(SoundFileRelocation const& r, relocations) {
+            bool ok = c->preparedExec(
+                "UPDATE sound_file SET name = ?, path = ?, relative_path = ?, size = ?, mtime = ? WHERE id = ?",
+                QVariantList() << r.info.fileName() << r.info.filePath() << r.relative_path
+                               << r.info.size() << getManifestTime(r.info) << r.id
+            );
+            if(!ok) {
+                c->rollbackTransaction();
+                return false;
+            }
+        }
+
+        return c->commitTransaction();
+    });
+
+    if(!success) {
+        qDebug() << "FAILURE: could not relocate sound files";
+        qDebug() << " > count:" << relocations.size();
+        return false;
+    }
+
+    QList<int> ids;
+    foreach(SoundFileRelocation const& r, relocations)
+        ids.append(r.id);
+    markChanged(SOUND_FILE, ids);
+
+    return true;
+}
+
+bool DatabaseApi::deleteResourceFolders(int resource_dir_id)
+{
+    return preparedExec(
+        "DELETE FROM resource_folder WHERE resource_directory_id = ?",
+        QVariantList() << resource_dir_id
+    );
+}
+
+const QList<QSqlRecord> DatabaseApi::getSoundFilesWithoutMetadata(int limit)
+{
+    // files imported before manifests existed have no mtime, 0 stands for unknown state
+    return preparedQuery(
+        "SELECT id, path, IFNULL(mtime, 0) AS mtime FROM sound_file"
+        " WHERE metadata_mtime IS NULL OR metadata_mtime <> IFNULL(mtime, 0) ORDER BY id LIMIT ?",
+        QVariantList() << limit
+    );
+}
+
+int DatabaseApi::getSoundFilesWithoutMetadataCount()
+{
+    return preparedValue(
+        "SELECT COUNT(*) FROM sound_file WHERE metadata_mtime IS NULL OR metadata_mtime <> IFNULL(mtime, 0)"
+    ).toInt();
+}
+
+bool DatabaseApi::updateSoundFileMetadata(const QList<SoundFileMetadata> &metadata)
+{
+    if(metadata.size() == 0)
+        return true;
+
+    bool success = callSync<bool>([metadata](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
+
+        foreach(SoundFileMetadata const& m, metadata) {
+            // unknown values are stored as null
+            QVariantList values;
+            values << (m.duration_ms > 0 ? QVariant(m.duration_ms) : QVariant());
+            values << (m.sample_rate > 0 ? QVariant(m.sample_rate) : QVariant());
+            values << (m.channels > 0 ? QVariant(m.channels) : QVariant());
+            values << (m.bitrate > 0 ? QVariant(m.bitrate) : QVariant());
+            values << (m.tags.size() > 0 ? QVariant(QString::fromUtf8(QJsonDocument(QJsonObject::fromVariantMap(m.tags)).toJson(QJsonDocument::Compact))) : QVariant());
+            values << (m.fingerprint.size() > 0 ? QVariant(m.fingerprint) : QVariant());
+            values << m.mtime << m.id;
+
+            bool ok = c->preparedExec(
+                "UPDATE sound_file SET duration_ms = ?, sample_rate = ?, channels = ?, bitrate = ?, tags = ?, fingerprint = ?, metadata_mtime = ? WHERE id = ?",
+                values
+            );
+            if(!ok) {
+                c->rollbackTransaction();
+                return false;
+            }
+        }
+
+        return c->commitTransaction();
+    });
+
+    if(!success) {
+        qDebug() << "FAILURE: could not store sound file metadata";
+        qDebug() << " > count:" << metadata.size();
+        return false;
+    }
+
+    QList<int> ids;
+    foreach(SoundFileMetadata const& m, metadata)
+        ids.append(m.id);
+    emit metadataUpdated(ids);
+
+    return true;
+}
+
+const QList<int> DatabaseApi::getSoundFileIdsByFingerprint(const QString &fingerprint)
+{
+    QList<int> ids;
+    QString qry_str = "SELECT id FROM sound_file WHERE fingerprint = ? ORDER BY id";
+    foreach(QSqlRecord const& rec, preparedQuery(qry_str, QVariantList() << fingerprint))
+        ids.append(rec.value(0).toInt());
+    return ids;
+}
+
+const QString DatabaseApi::getSoundFileFingerprint(int id)
+{
+    return preparedValue(
+        "SELECT fingerprint FROM sound_file WHERE id = ?",
+        QVariantList() << id
+    ).toString();
+}
+
+const QList<QList<int> > DatabaseApi::getDuplicateSoundFileIds()
+{
+    QList<QList<int> > groups;
+
+    QString qry_str = "SELECT fingerprint, id FROM sound_file WHERE fingerprint IN ("
+                      " SELECT fingerprint FROM sound_file WHERE fingerprint IS NOT NULL"
+                      " GROUP BY fingerprint HAVING COUNT(*) > 1"
+                      ") ORDER BY fingerprint, id";
+
+    QString last;
+    foreach(QSqlRecord const& rec, preparedQuery(qry_str)) {
+        QString fingerprint = rec.value(0).toString();
+        if(groups.isEmpty() || fingerprint != last)
+            groups.append(QList<int>());
+        groups.last().append(rec.value(1).toInt());
+        last = fingerprint;
+    }
+
+    return groups;
+}
+
+const QList<int> DatabaseApi::getSoundFileIdsByDuration(qint64 min_ms, qint64 max_ms)
+{
+    QList<int> ids;
+    QString qry_str = "SELECT id FROM sound_file WHERE duration_ms BETWEEN ? AND ? ORDER BY id";
+    foreach(QSqlRecord const& rec, preparedQuery(qry_str, QVariantList() << min_ms << max_ms))
+        ids.append(rec.value(0).toInt());
+    return ids;
+}
+
+const QList<int> DatabaseApi::getSoundFileIdsByPathPrefix(const QString &prefix)
+{
+    QList<int> ids;
+
+    // substr comparison, so '%' and '_' in paths need no escaping
+    QString qry_str = "SELECT id FROM sound_file WHERE substr(path, 1, ?) = ? ORDER BY id";
+    foreach(QSqlRecord const& rec, preparedQuery(qry_str, QVariantList() << prefix.size() << prefix))
+        ids.append(rec.value(0).toInt());
+
+    return ids;
 }
 
 int DatabaseApi::getSoundFileId(const QString &path)
 {
-    QString SELECT = "id";
-    QString WHERE = "path = '" + SqliteWrapper::escape(path) + "'";
-    QList<QSqlRecord> res = selectQuery(SELECT, SOUND_FILE, WHERE);
-    if(res.size() > 0)
-        return res[0].value(0).toInt();
-    return -1;
+    QVariant id = preparedValue("SELECT id FROM sound_file WHERE path = ?", QVariantList() << path);
+    return id.isValid() ? id.toInt() : -1;
 }
 
 int DatabaseApi::getResourceDirId(const QString &path)
 {
-    QString SELECT = "id";
-    QString WHERE = "path = '" + SqliteWrapper::escape(path) + "'";
-    QList<QSqlRecord> res = selectQuery(SELECT, RESOURCE_DIRECTORY, WHERE);
-    if(res.size() > 0)
-        return res[0].value(0).toInt();
-    return -1;
+    QVariant id = preparedValue("SELECT id FROM resource_directory WHERE path = ?", QVariantList() << path);
+    return id.isValid() ? id.toInt() : -1;
 }
 
 int DatabaseApi::getImageDirId(const QString &path)
 {
-    QString SELECT = "id";
-    QString WHERE = "path = '" + SqliteWrapper::escape(path) + "'";
-    QList<QSqlRecord> res = selectQuery(SELECT, IMAGE_DIRECTORY, WHERE);
-    if(res.size() > 0)
-        return res[0].value(0).toInt();
-    return -1;
+    QVariant id = preparedValue("SELECT id FROM image_directory WHERE path = ?", QVariantList() << path);
+    return id.isValid() ? id.toInt() : -1;
 }
 
 int DatabaseApi::getPresetId(const QString &name)
 {
-    QString SELECT = "id";
-    QString WHERE = "name = '" + SqliteWrapper::escape(name) + "'";
-    QList<QSqlRecord> res = selectQuery(SELECT, PRESET, WHERE);
-    if(res.size() > 0)
-        return res[0].value(0).toInt();
-    return -1;
+    QVariant id = preparedValue("SELECT id FROM preset WHERE name = ?", QVariantList() << name);
+    return id.isValid() ? id.toInt() : -1;
 }
 
 bool DatabaseApi::soundFileExists(const QString &path, const QString &name)
 {
-    QString where = "path = '" + SqliteWrapper::escape(path) + "' and ";
-    where += "name = '" + SqliteWrapper::escape(name) + "'";
-
-    return selectQuery("Count(*)", SOUND_FILE, where)[0].value(0).toInt() > 0;
+    QVariant count = preparedValue(
+        "SELECT COUNT(*) FROM sound_file WHERE path = ? AND name = ?",
+        QVariantList() << path << name
+    );
+    return count.toInt() > 0;
 }
 
 bool DatabaseApi::soundFileCategoryExists(int sound_file_id, int category_id)
 {
-    QString where = "sound_file_id = " + QString::number(sound_file_id) + " and ";
-    where += "category_id = " + QString::number(category_id) + "";
-
-    return selectQuery("Count(*)", SOUND_FILE_CATEGORY, where)[0].value(0).toInt() > 0;
+    QVariant count = preparedValue(
+        "SELECT COUNT(*) FROM sound_file_category WHERE sound_file_id = ? AND category_id = ?",
+        QVariantList() << sound_file_id << category_id
+    );
+    return count.toInt() > 0;
 }
 
 const QList<int> DatabaseApi::getRelatedIds(TableIndex get_table, TableIndex have_table, int have_id)
@@ -166,35 +828,110 @@ const QList<int> DatabaseApi::getRelatedIds(TableIndex get_table, TableIndex hav
     if(relation_idx == NONE)
         return ids;
 
-    QString SELECT = toString(get_table) + "_id";
-    QString FROM = toString(relation_idx);
-    QString WHERE = toString(have_table) + "_id = " +  QString::number(have_id);
+    // table names cannot be bound, but they only vary by enum,
+    // so each combination still maps onto one cached statement.
+    QString qry_str = "SELECT " + toString(get_table) + "_id";
+    qry_str += " FROM " + toString(relation_idx);
+    qry_str += " WHERE " + toString(have_table) + "_id = ?";
+
+    foreach(QSqlRecord rec, preparedQuery(qry_str, QVariantList() << have_id))
+        ids.append(rec.value(0).toInt());
+
+    return ids;
+}
+
+const QList<int> DatabaseApi::getSoundFileIdsByCategoryTree(int category_id)
+{
+    QList<int> ids;
+
+    // top level categories have no (or a 0) parent_id
+    QString root_str = "SELECT id FROM category WHERE id = ?";
+    QVariantList values;
+    if(category_id == -1)
+        root_str = "SELECT id FROM category WHERE IFNULL(parent_id, 0) <= 0";
+    else
+        values << category_id;
+
+    // UNION (not UNION ALL) stops on cyclic parent references
+    QString qry_str = "WITH RECURSIVE subtree(id) AS (";
+    qry_str += root_str;
+    qry_str += " UNION SELECT category.id FROM category JOIN subtree ON category.parent_id = subtree.id";
+    qry_str += ") SELECT DISTINCT sound_file_category.sound_file_id FROM sound_file_category";
+    qry_str += " JOIN subtree ON sound_file_category.category_id = subtree.id";
+    qry_str += " ORDER BY sound_file_category.sound_file_id";
 
-    foreach(QSqlRecord rec, selectQuery(SELECT, FROM, WHERE))
+    foreach(QSqlRecord const& rec, preparedQuery(qry_str, values))
         ids.append(rec.value(0).toInt());
 
     return ids;
 }
 
-void DatabaseApi::deleteAll()
+const QList<QSqlRecord> DatabaseApi::searchSoundFiles(const QString &text, int limit)
+{
+    QString qry_str;
+    QVariantList values;
+    if(!buildSearchQuery(text, limit, qry_str, values))
+        return QList<QSqlRecord>();
+
+    return preparedQuery(qry_str, values);
+}
+
+QFuture<QList<QSqlRecord> > DatabaseApi::searchSoundFilesAsync(const QString &text, int limit)
+{
+    QString qry_str;
+    QVariantList values;
+    if(!buildSearchQuery(text, limit, qry_str, values))
+        return QtConcurrent::run([]() -> QList<QSqlRecord> { return QList<QSqlRecord>(); });
+
+    return preparedQueryAsync(qry_str, values);
+}
+
+bool DatabaseApi::deleteAll()
 {
-    // delete sound_files
-    deleteQuery(SOUND_FILE, "id > 0");
+    bool success = callSync<bool>([](SqliteConnection* c) -> bool {
+        if(!c->beginTransaction())
+            return false;
 
-    // delete categories
-    deleteQuery(CATEGORY, "id > 0");
+        QStringList statements;
+        statements
+            // delete sound_files
+            << "DELETE FROM sound_file WHERE id > 0"
+            // delete categories
+            << "DELETE FROM category WHERE id > 0"
+            // delete sound_file_categories
+            << "DELETE FROM sound_file_category WHERE id > 0"
+            // delete resource_dirs
+            << "DELETE FROM resource_directory WHERE id > 0"
+            // delete presets
+            << "DELETE FROM preset WHERE id > 0"
+            // delete image_dirs
+            << "DELETE FROM image_directory WHERE id > 0"
+            // delete folder manifests of resource_dirs
+            << "DELETE FROM resource_folder";
 
-    // delete sound_file_categories
-    deleteQuery(SOUND_FILE_CATEGORY, "id > 0");
+        foreach(QString const& statement, statements) {
+            if(!c->preparedExec(statement)) {
+                c->rollbackTransaction();
+                return false;
+            }
+        }
 
-    // delete resource_dirs
-    deleteQuery(RESOURCE_DIRECTORY, "id > 0");
+        return c->commitTransaction();
+    });
 
-    // delete presets
-    deleteQuery(PRESET, "id > 0");
+    if(success) {
+        markTableChanged(SOUND_FILE);
+        markTableChanged(CATEGORY);
+        markTableChanged(SOUND_FILE_CATEGORY);
+        markTableChanged(RESOURCE_DIRECTORY);
+        markTableChanged(PRESET);
+        markTableChanged(IMAGE_DIRECTORY);
+    }
+    else {
+        qDebug() << "FAILURE: could not delete database contents";
+    }
 
-    // delete image_dirs
-    deleteQuery(IMAGE_DIRECTORY, "id > 0");
+    return success;
 }
 
 TableIndex DatabaseApi::getRelationTable(TableIndex first, TableIndex second)
@@ -209,3 +946,257 @@ TableIndex DatabaseApi::getRelationTable(TableIndex first, TableIndex second)
 
     return NONE;
 }
+
+void DatabaseApi::markChanged(TableIndex index, const QList<int> &ids)
+{
+    if(ids.size() == 0)
+        return;
+
+    // too many rows to tell apart, readers diff whole table
+    if(ids.size() > CHANGE_LOG_SIZE) {
+        markTableChanged(index);
+        return;
+    }
+
+    TableChangeLog& log = change_logs_[index];
+    log.version++;
+    foreach(int id, ids)
+        log.changes.append(QPair<int, int>(log.version, id));
+
+    // drop oldest writes, only versions after the dropped ones stay complete
+    while(log.changes.size() > CHANGE_LOG_SIZE)
+        log.base_version = log.changes.takeFirst().first;
+
+    emit tableChanged(index);
+}
+
+void DatabaseApi::markChanged(TableIndex index, int id)
+{
+    // failed insert, nothing written
+    if(id == -1)
+        return;
+
+    markChanged(index, QList<int>() << id);
+}
+
+void DatabaseApi::markTableChanged(TableIndex index)
+{
+    TableChangeLog& log = change_logs_[index];
+    log.version++;
+    log.changes.clear();
+    log.base_version = log.version;
+
+    emit tableChanged(index);
+}
+
+void DatabaseApi::runMigrations()
+{
+    QElapsedTimer total_timer;
+    total_timer.start();
+
+    int applied = callSync<int>([](SqliteConnection* c) -> int {
+        c->preparedExec(
+            "CREATE TABLE IF NOT EXISTS schema_migration (name TEXT PRIMARY KEY, applied_at TEXT)"
+        );
+
+        QSet<QString> done;
+        foreach(QSqlRecord const& rec, c->preparedQuery("SELECT name FROM schema_migration"))
+            done.insert(rec.value(0).toString());
+
+        int count = 0;
+        QElapsedTimer timer;
+        typedef QPair<QString, QString> Migration;
+        foreach(Migration const& migration, MIGRATIONS) {
+            if(done.contains(migration.first))
+                continue;
+
+            timer.start();
+
+            if(!c->beginTransaction())
+                return count;
+
+            bool ok = c->preparedExec(migration.second);
+            ok = ok && c->preparedExec(
+                "INSERT INTO schema_migration (name, applied_at) VALUES (?, datetime('now'))",
+                QVariantList() << migration.first
+            );
+
+            // commit rolls back on its own, if it fails
+            if(ok)
+                ok = c->commitTransaction();
+            else
+                c->rollbackTransaction();
+
+            if(!ok) {
+                qDebug() << "FAILURE: could not apply migration, retrying on next start";
+                qDebug() << " > name:" << migration.first;
+                continue;
+            }
+
+            qDebug() << " > applied migration" << migration.first << "(ms:" << timer.elapsed() << ")";
+            ++count;
+        }
+
+        return count;
+    });
+
+    qDebug() << "NOTIFICATION: db migrations checked";
+    qDebug() << " > applied:" << applied;
+    qDebug() << " > ms:" << total_timer.elapsed();
+}
+
+void DatabaseApi::initSearchIndex()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int rows = -1;
+    search_mode_ = (SearchMode) callSync<int>([&rows](SqliteConnection* c) -> int {
+        QString sql = c->preparedValue(
+            "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'sound_file_search'"
+        ).toString();
+
+        // keep index created by an earlier run
+        int mode = SEARCH_LIKE;
+        if(sql.contains("fts5", Qt::CaseInsensitive)) {
+            mode = SEARCH_FTS5;
+        }
+        else if(sql.contains("fts4", Qt::CaseInsensitive)) {
+            mode = SEARCH_FTS4;
+        }
+        else if(sql.isEmpty()) {
+            if(c->preparedExec("CREATE VIRTUAL TABLE sound_file_search USING fts5(name, relative_path, categories)"))
+                mode = SEARCH_FTS5;
+            else if(c->preparedExec("CREATE VIRTUAL TABLE sound_file_search USING fts4(name, relative_path, categories)"))
+                mode = SEARCH_FTS4;
+        }
+
+        if(mode == SEARCH_LIKE)
+            return mode;
+
+        // category lookups of triggers below rely on sound_file_category indexes (see MIGRATIONS)
+        c->beginTransaction();
+
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_insert AFTER INSERT ON sound_file BEGIN"
+            " INSERT INTO sound_file_search (rowid, name, relative_path, categories)"
+            " VALUES (new.id, new.name, new.relative_path, " + SEARCH_CATEGORIES_OF.arg("new.id") + ");"
+            " END"
+        );
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_update AFTER UPDATE OF name, relative_path ON sound_file BEGIN"
+            " UPDATE sound_file_search SET name = new.name, relative_path = new.relative_path WHERE rowid = new.id;"
+            " END"
+        );
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_delete AFTER DELETE ON sound_file BEGIN"
+            " DELETE FROM sound_file_search WHERE rowid = old.id;"
+            " END"
+        );
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_category_insert AFTER INSERT ON sound_file_category BEGIN"
+            " UPDATE sound_file_search SET categories = " + SEARCH_CATEGORIES_OF.arg("new.sound_file_id") +
+            " WHERE rowid = new.sound_file_id;"
+            " END"
+        );
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_category_delete AFTER DELETE ON sound_file_category BEGIN"
+            " UPDATE sound_file_search SET categories = " + SEARCH_CATEGORIES_OF.arg("old.sound_file_id") +
+            " WHERE rowid = old.sound_file_id;"
+            " END"
+        );
+        c->preparedExec(
+            "CREATE TRIGGER IF NOT EXISTS sound_file_search_category_rename AFTER UPDATE OF name ON category BEGIN"
+            " UPDATE sound_file_search SET categories = " + SEARCH_CATEGORIES_OF.arg("sound_file_search.rowid") +
+            " WHERE rowid IN (SELECT sound_file_id FROM sound_file_category WHERE category_id = new.id);"
+            " END"
+        );
+
+        // (re)build index if it is new or got out of sync (e.g. db written by older version)
+        int indexed = c->preparedValue("SELECT COUNT(*) FROM sound_file_search").toInt();
+        rows = c->preparedValue("SELECT COUNT(*) FROM sound_file").toInt();
+        if(indexed != rows) {
+            c->preparedExec("DELETE FROM sound_file_search");
+            c->preparedExec(
+                "INSERT INTO sound_file_search (rowid, name, relative_path, categories)"
+                " SELECT id, name, relative_path, " + SEARCH_CATEGORIES_OF.arg("sound_file.id") + " FROM sound_file"
+            );
+        }
+        else {
+            rows = -1;
+        }
+
+        c->commitTransaction();
+
+        return mode;
+    });
+
+    if(search_mode_ == SEARCH_LIKE) {
+        qDebug() << "NOTIFICATION: sqlite provides no full-text search";
+        qDebug() << " > sound file search falls back to LIKE matching";
+        return;
+    }
+
+    if(rows != -1) {
+        qDebug() << "NOTIFICATION: built sound file search index";
+        qDebug() << " > module:" << (search_mode_ == SEARCH_FTS5 ? "fts5" : "fts4");
+        qDebug() << " > rows:" << rows;
+    }
+    qDebug() << " > search index ready (ms):" << timer.elapsed();
+}
+
+bool DatabaseApi::buildSearchQuery(const QString &text, int limit, QString &qry_str, QVariantList &values) const
+{
+    // only letters & digits get indexed, so everything else separates words
+    QStringList words = text.split(QRegExp("[\\W_]+"), QString::SkipEmptyParts);
+    if(words.size() == 0 || limit <= 0)
+        return false;
+
+    if(search_mode_ == SEARCH_LIKE) {
+        // every word in name, relative path or category name
+        qry_str = "SELECT id, name, path, relative_path FROM sound_file WHERE ";
+        for(int i = 0; i < words.size(); ++i) {
+            if(i > 0)
+                qry_str += " AND ";
+            qry_str += "(name LIKE ? OR relative_path LIKE ? OR id IN ("
+                       "SELECT sound_file_category.sound_file_id FROM sound_file_category"
+                       " JOIN category ON category.id = sound_file_category.category_id"
+                       " WHERE category.name LIKE ?))";
+
+            QString pattern = "%" + words[i] + "%";
+            values << pattern << pattern << pattern;
+        }
+        qry_str += " ORDER BY name LIMIT ?";
+        values << limit;
+        return true;
+    }
+
+    // prefix match on each word, words are implicitly AND-ed.
+    // Quoted, so words like AND, OR, NOT or NEAR are searched instead of parsed as operators
+    QStringList terms;
+    foreach(QString const& word, words) {
+        QString quoted = QString(word).replace("\"", "\"\"");
+        if(search_mode_ == SEARCH_FTS5)
+            terms.append("\"" + quoted + "\"*");
+        else
+            terms.append("\"" + quoted + "*\"");  // fts4 takes prefix marker inside phrase only
+    }
+    values << terms.join(" ");
+
+    if(search_mode_ == SEARCH_FTS5) {
+        // hits in name weigh most, then relative path, then categories
+        qry_str = "SELECT sound_file.id, sound_file.name, sound_file.path, sound_file.relative_path FROM ("
+                  "SELECT rowid AS id, bm25(sound_file_search, 10.0, 2.0, 1.0) AS score"
+                  " FROM sound_file_search WHERE sound_file_search MATCH ? ORDER BY score LIMIT ?"
+                  ") AS hits JOIN sound_file ON sound_file.id = hits.id ORDER BY hits.score";
+    }
+    else {
+        // fts4 comes without ranking function, order by name instead
+        qry_str = "SELECT sound_file.id, sound_file.name, sound_file.path, sound_file.relative_path"
+                  " FROM sound_file_search JOIN sound_file ON sound_file.id = sound_file_search.docid"
+                  " WHERE sound_file_search MATCH ? ORDER BY sound_file.name LIMIT ?";
+    }
+    values << limit;
+
+    return true;
+}
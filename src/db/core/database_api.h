@@ -5,9 +5,78 @@
 
 #include <QFileInfo>
 #include <QList>
+#include <QPair>
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
 
 #include "sqlite_wrapper.h"
 
+/*
+ * Changes of the files below a resource directory,
+ * found by comparing it against its manifest (see Resources::Rescanner).
+*/
+struct SoundFileDiff {
+    // new files, with category to relate each one to (-1 for none)
+    QList<QFileInfo> added;
+    QList<int> added_category_ids;
+
+    // files with changed size or mtime (sound_file id, current state)
+    QList<QPair<int, QFileInfo> > modified;
+
+    // ids of sound_files gone from disk
+    QList<int> removed;
+
+    // files found at a new path, matched by fingerprint (sound_file id, new location)
+    QList<QPair<int, QFileInfo> > moved;
+
+    // all folders walked (path, mtime), replaces folder manifest
+    QList<QPair<QString, qint64> > folders;
+};
+
+/*
+ * New location of a sound_file, which is missing at its recorded path
+ * (see Resources::PathRelocator).
+*/
+struct SoundFileRelocation {
+    int id;
+    QFileInfo info;
+    QString relative_path;
+};
+
+/*
+ * Audio properties and tags of a sound file, read from its headers
+ * (see Resources::AudioMetadataReader). Values not found stay 0 (or empty).
+*/
+struct SoundFileMetadata {
+    int id;
+
+    // mtime of the file state metadata was read from (see getSoundFilesWithoutMetadata)
+    qint64 mtime;
+
+    qint64 duration_ms;
+    int sample_rate;
+    int channels;
+    int bitrate;    // kbit/s, average for VBR
+
+    // tags by lower case name (title, artist, album, genre, ...)
+    QVariantMap tags;
+
+    // content fingerprint (see Resources::PathFixer::computeFingerprint), empty if unreadable
+    QString fingerprint;
+
+    SoundFileMetadata()
+        : id(-1)
+        , mtime(0)
+        , duration_ms(0)
+        , sample_rate(0)
+        , channels(0)
+        , bitrate(0)
+        , tags()
+        , fingerprint()
+    {}
+};
+
 /*
  * Class that Provides interface to SqliteWrapper,
  * based on structure of application database.
@@ -18,12 +87,62 @@ class DatabaseApi : public SqliteWrapper
 public:
     DatabaseApi(QString const& db_path, QObject *parent = 0);
 
-    QSqlRelationalTableModel* getSoundFileTable();
-    QSqlRelationalTableModel* getCategoryTable();
-    QSqlRelationalTableModel* getSoundFileCategoryTable();
-    QSqlRelationalTableModel* getResourceDirTable();
-    QSqlRelationalTableModel* getImageDirTable();
-    QSqlRelationalTableModel* getPresetTable();
+    QList<QSqlRecord> const getSoundFileTable();
+    QList<QSqlRecord> const getCategoryTable();
+    QList<QSqlRecord> const getSoundFileCategoryTable();
+    QList<QSqlRecord> const getResourceDirTable();
+    QList<QSqlRecord> const getImageDirTable();
+    QList<QSqlRecord> const getPresetTable();
+
+    /* Selects sound_file table on database thread without blocking caller */
+    QFuture<QList<QSqlRecord> > getSoundFileTableAsync();
+
+    /* Gets number of rows in sound_file table */
+    int getSoundFileCount();
+
+    /*
+     * Gets up to limit rows (id, name, path, relative_path, duration_ms)
+     * of sound_file table with id greater than after_id, ordered by id.
+     * Seeks through the primary key, so cost does not grow with position in table.
+    */
+    QList<QSqlRecord> const getSoundFilePage(int after_id, int limit);
+
+    /* Gets ids of all sound_files, ordered by id */
+    QList<int> const getSoundFileIds();
+
+    /* Gets id of sound_file at given row (ordered by id). Returns -1 if none found. */
+    int getSoundFileIdAt(int row);
+
+    /* Gets row (ordered by id) of sound_file with given id. Returns -1 if none found. */
+    int getSoundFileRow(int id);
+
+    /*
+     * Gets number of sound_files with id less than each of given ids (ascending),
+     * i.e. the row each id has (or would have) ordered by id. Ids need not exist.
+     * Counts all ids within one pass over the primary key.
+    */
+    QList<int> const getSoundFileRows(QList<int> const& ids);
+
+    /* Gets highest id in sound_file table, 0 if table is empty */
+    int getSoundFileMaxId();
+
+    /* Gets rows with given ids from table referenced by index, ordered by id */
+    QList<QSqlRecord> const getRecords(TableIndex index, QList<int> const& ids);
+
+    /*
+     * Gets version of table referenced by index.
+     * The version increases with every write through this api,
+     * so models can skip refreshes while it is unchanged.
+    */
+    int getTableVersion(TableIndex index) const;
+
+    /*
+     * Collects ids of rows written in table referenced by index
+     * since given version (rows may have been inserted, updated or deleted).
+     * Returns false if the changes are not known row by row,
+     * e.g. the table got cleared, in which case the whole table has to be diffed.
+    */
+    bool getChangedIds(TableIndex index, int since_version, QSet<int>& ids) const;
 
     void insertSoundFile(QFileInfo const& info, ResourceDirRecord const& resource_dir);
     void insertCategory(QString const& name, int parent_id = -1);
@@ -32,6 +151,106 @@ public:
     void insertImageDir(QFileInfo const& info);
     void insertPreset(QString const& name, QString const& json);
 
+    /*
+     * Inserts all given sound files within one transaction,
+     * along with their sound_file_category relation to given category_ids
+     * (aligned with infos, -1 for none, may be empty).
+     * Returns ids of inserted rows, aligned with given infos.
+     * Returns an empty list if the transaction failed.
+    */
+    QList<int> const insertSoundFiles(QList<QFileInfo> const& infos, ResourceDirRecord const& resource_dir,
+                                      QList<int> const& category_ids = QList<int>());
+
+    /*
+     * Inserts all given relations (sound_file_id, category_id)
+     * within one transaction. Returns success.
+    */
+    bool insertSoundFileCategories(QList<QPair<int, int> > const& relations);
+
+    /* Renames category with given id. Returns success. */
+    bool updateCategoryName(int category_id, QString const& name);
+
+    /*
+     * Deletes rows with given ids from table referenced by index
+     * within one transaction. Returns success.
+    */
+    bool deleteRecords(TableIndex index, QList<int> const& ids);
+
+    /*
+     * Deletes sound_files with given ids along with their
+     * sound_file_category relations within one transaction.
+     * Returns success.
+    */
+    bool deleteSoundFiles(QList<int> const& ids);
+
+    /*
+     * Gets manifest (id, path, size, mtime, fingerprint) of all sound_files with path starting with given prefix.
+     * Size and mtime (ms since epoch) are recorded on insert, null for files imported before.
+     * Fingerprint is null until metadata of file got read.
+    */
+    QList<QSqlRecord> const getSoundFileManifest(QString const& prefix);
+
+    /* Gets modification time of file or folder as stored in manifests (ms since epoch) */
+    static qint64 getManifestTime(QFileInfo const& info);
+
+    /* Gets manifest (path, mtime) of folders walked by last rescan of resource directory */
+    QList<QSqlRecord> const getResourceFolders(int resource_dir_id);
+
+    /*
+     * Applies given diff below resource_dir within one transaction:
+     * deletes removed sound_files (with their relations), inserts added ones
+     * (with their relation), updates manifest of modified ones, relinks moved ones
+     * (keeping id and relations) and replaces the folder manifest.
+     * Returns success.
+    */
+    bool applySoundFileDiff(SoundFileDiff const& diff, ResourceDirRecord const& resource_dir);
+
+    /* Gets location (id, name, path, relative_path, size, fingerprint) of all sound_files, ordered by id */
+    QList<QSqlRecord> const getSoundFileLocations();
+
+    /*
+     * Moves sound_files to given locations within one transaction (keeping ids and relations),
+     * updating name, paths and manifest. Returns success.
+    */
+    bool relocateSoundFiles(QList<SoundFileRelocation> const& relocations);
+
+    /* Deletes folder manifest of resource directory. Returns success. */
+    bool deleteResourceFolders(int resource_dir_id);
+
+    /*
+     * Gets up to limit sound_files (id, path, mtime), which have no metadata
+     * or metadata read from an older state of the file (per manifest mtime).
+    */
+    QList<QSqlRecord> const getSoundFilesWithoutMetadata(int limit);
+
+    /* Gets number of sound_files without (current) metadata */
+    int getSoundFilesWithoutMetadataCount();
+
+    /*
+     * Stores metadata of sound_files within one transaction.
+     * Metadata is not tracked by the table change log (rows do not count as changed),
+     * metadataUpdated() gets signaled instead. Returns success.
+    */
+    bool updateSoundFileMetadata(QList<SoundFileMetadata> const& metadata);
+
+    /* Gets ids of all sound_files with given content fingerprint, ordered by id */
+    QList<int> const getSoundFileIdsByFingerprint(QString const& fingerprint);
+
+    /* Gets fingerprint of sound_file with given id, empty if none stored (yet) */
+    QString const getSoundFileFingerprint(int id);
+
+    /*
+     * Gets ids of sound_files sharing their fingerprint with another one,
+     * grouped by fingerprint (ordered by id within groups).
+    */
+    QList<QList<int> > const getDuplicateSoundFileIds();
+
+    /* Gets ids of all sound_files with duration within [min_ms, max_ms], ordered by id */
+    QList<int> const getSoundFileIdsByDuration(qint64 min_ms, qint64 max_ms);
+
+    /* Gets ids of all sound_files with path starting with given prefix, ordered by id */
+    QList<int> const getSoundFileIdsByPathPrefix(QString const& prefix);
+
     int getSoundFileId(QString const& path);
     int getResourceDirId(QString const& path);
     int getImageDirId(QString const& path);
@@ -48,11 +267,34 @@ public:
     QList<int> const getRelatedIds(TableIndex get_table, TableIndex have_table, int have_id);
 
     /*
-     * deletes all contents of the database
+     * Gets ids of all sound_files related to category with given id
+     * or any category below it (resolved in one recursive query).
+     * A category_id of -1 covers all categories.
+     * Ids are distinct and ordered ascending.
+    **/
+    QList<int> const getSoundFileIdsByCategoryTree(int category_id);
+
+    /*
+     * Searches sound_files by name, relative path and names of their categories.
+     * Every word of text has to match the start of a word in any of these.
+     * Returns up to limit rows (id, name, path, relative_path), best matches first.
+     * Returns no rows if text holds no words.
+    **/
+    QList<QSqlRecord> const searchSoundFiles(QString const& text, int limit = 100);
+    QFuture<QList<QSqlRecord> > searchSoundFilesAsync(QString const& text, int limit = 100);
+
+    /*
+     * deletes all contents of the database in one transaction.
+     * Returns success, database is left unchanged on failure.
     */
-    void deleteAll();
+    bool deleteAll();
 
 signals:
+    /* triggered after rows of table referenced by index have been written */
+    void tableChanged(TableIndex index);
+
+    /* triggered after metadata of given sound_files has been stored */
+    void metadataUpdated(QList<int> const& ids);
 
 public slots:
 
@@ -62,6 +304,61 @@ protected:
      * Returns NONE if non exists
     */
     TableIndex getRelationTable(TableIndex first, TableIndex second);
+
+    /* Logs write to rows with given ids of table referenced by index */
+    void markChanged(TableIndex index, QList<int> const& ids);
+    void markChanged(TableIndex index, int id);
+
+    /* Logs write to unknown rows of table referenced by index */
+    void markTableChanged(TableIndex index);
+
+    /*
+     * Applies all migrations (see database_api.cpp) not yet recorded
+     * in table schema_migration. Each migration runs in its own transaction
+     * and gets recorded along with it, so running this again is a no-op.
+    */
+    void runMigrations();
+
+    /*
+     * Creates full-text index sound_file_search (if missing) and the triggers
+     * keeping it in sync with sound_file, sound_file_category and category.
+     * Uses FTS5 if available, FTS4 otherwise. Falls back to plain LIKE
+     * matching if neither is compiled into sqlite.
+    */
+    void initSearchIndex();
+
+private:
+    enum SearchMode {
+        SEARCH_FTS5,
+        SEARCH_FTS4,
+        SEARCH_LIKE
+    };
+
+    /*
+     * Builds query and values searching for words of text (see searchSoundFiles).
+     * Returns false if text holds no words.
+    */
+    bool buildSearchQuery(QString const& text, int limit, QString& qry_str, QVariantList& values) const;
+
+    /*
+     * Bounded log of row writes per table.
+     * changes holds (version, id) pairs, all writes after
+     * base_version are logged.
+    */
+    struct TableChangeLog {
+        int version;
+        int base_version;
+        QList<QPair<int, int> > changes;
+
+        TableChangeLog()
+            : version(0)
+            , base_version(0)
+            , changes()
+        {}
+    };
+
+    QHash<int, TableChangeLog> change_logs_;
+    SearchMode search_mode_;
 };
 
 #endif // CORE_DATABASE_API_H
@@ -0,0 +1,250 @@
+#include "sqlite_connection.h"
+
+#include <QDebug>
+#include <QSqlError>
+#include <QElapsedTimer>
+
+SqliteConnection::SqliteConnection(const QString &connection_name, const QString &db_path,
+                                   const SqliteProfile &profile, bool read_only)
+    : connection_name_(connection_name)
+    , db_()
+    , profile_(profile)
+    , read_only_(read_only)
+    , statements_()
+    , last_insert_id_(-1)
+{
+    db_ = QSqlDatabase::addDatabase("QSQLITE", connection_name_);
+    db_.setDatabaseName(db_path);
+
+    // readers and writer may hold the db concurrently, wait for locks instead of failing
+    if(read_only_)
+        db_.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+    else
+        db_.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+}
+
+SqliteConnection::~SqliteConnection()
+{
+    close();
+    db_ = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connection_name_);
+}
+
+bool SqliteConnection::open()
+{
+    if(db_.isOpen()) {
+        qDebug() << "NOTIFICATION: database is already open";
+        return true;
+    }
+
+    if(db_.open()) {
+        qDebug() << "SUCCESS: connected to database";
+        qDebug() << " > connection:" << connection_name_;
+        applyProfile();
+        return true;
+    }
+
+    qDebug() << "FAILURE: could not open database";
+    qDebug() << " > connection:" << connection_name_;
+    qDebug() << " > Error:" << db_.lastError().text();
+    return false;
+}
+
+void SqliteConnection::close()
+{
+    clearStatements();
+    if(db_.isOpen())
+        db_.close();
+}
+
+bool SqliteConnection::isOpen() const
+{
+    return db_.isOpen();
+}
+
+const QString &SqliteConnection::getConnectionName() const
+{
+    return connection_name_;
+}
+
+bool SqliteConnection::isReadOnly() const
+{
+    return read_only_;
+}
+
+const QList<QSqlRecord> SqliteConnection::executeQuery(const QString &qry_str)
+{
+    QList<QSqlRecord> results;
+    if(!db_.isOpen()) {
+        qDebug() << "FAILURE: Database not open";
+        return results;
+    }
+
+    QSqlQuery qry(db_);
+    qry.setForwardOnly(true);
+    if(qry.exec(qry_str)) {
+        while(qry.next())
+            results.append(qry.record());
+    }
+    else {
+        qDebug() << "FAILURE: SQL Query failed to execute.";
+        qDebug() << " > Query:" << qry_str;
+        qDebug() << " > Error:" << qry.lastError().text();
+    }
+
+    return results;
+}
+
+const QList<QSqlRecord> SqliteConnection::preparedQuery(const QString &qry_str, const QVariantList &values)
+{
+    QList<QSqlRecord> results;
+
+    QSqlQuery* qry = getStatement(qry_str);
+    if(qry == 0 || !execStatement(qry, values))
+        return results;
+
+    while(qry->next())
+        results.append(qry->record());
+    qry->finish();
+
+    return results;
+}
+
+const QVariant SqliteConnection::preparedValue(const QString &qry_str, const QVariantList &values)
+{
+    QVariant value;
+
+    QSqlQuery* qry = getStatement(qry_str);
+    if(qry == 0 || !execStatement(qry, values))
+        return value;
+
+    if(qry->next())
+        value = qry->value(0);
+    qry->finish();
+
+    return value;
+}
+
+bool SqliteConnection::preparedExec(const QString &qry_str, const QVariantList &values)
+{
+    QSqlQuery* qry = getStatement(qry_str);
+    if(qry == 0 || !execStatement(qry, values))
+        return false;
+
+    QVariant id = qry->lastInsertId();
+    if(id.isValid())
+        last_insert_id_ = id.toInt();
+    qry->finish();
+
+    return true;
+}
+
+int SqliteConnection::lastInsertId() const
+{
+    return last_insert_id_;
+}
+
+bool SqliteConnection::beginTransaction()
+{
+    if(!db_.isOpen() || !db_.transaction()) {
+        qDebug() << "FAILURE: could not begin transaction";
+        qDebug() << " > Error:" << db_.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SqliteConnection::commitTransaction()
+{
+    if(!db_.commit()) {
+        qDebug() << "FAILURE: could not commit transaction";
+        qDebug() << " > Error:" << db_.lastError().text();
+        rollbackTransaction();
+        return false;
+    }
+    return true;
+}
+
+void SqliteConnection::rollbackTransaction()
+{
+    if(!db_.rollback()) {
+        qDebug() << "FAILURE: could not roll back transaction";
+        qDebug() << " > Error:" << db_.lastError().text();
+    }
+}
+
+QSqlQuery* SqliteConnection::getStatement(const QString &qry_str)
+{
+    QSqlQuery* qry = statements_.value(qry_str, 0);
+    if(qry != 0)
+        return qry;
+
+    if(!db_.isOpen()) {
+        qDebug() << "FAILURE: Database not open";
+        return 0;
+    }
+
+    qry = new QSqlQuery(db_);
+    qry->setForwardOnly(true);
+    if(!qry->prepare(qry_str)) {
+        qDebug() << "FAILURE: SQL statement could not be prepared.";
+        qDebug() << " > Query:" << qry_str;
+        qDebug() << " > Error:" << qry->lastError().text();
+        delete qry;
+        return 0;
+    }
+
+    statements_.insert(qry_str, qry);
+    return qry;
+}
+
+bool SqliteConnection::execStatement(QSqlQuery* qry, const QVariantList &values)
+{
+    for(int i = 0; i < values.size(); ++i)
+        qry->bindValue(i, values[i]);
+
+    if(!qry->exec()) {
+        qDebug() << "FAILURE: SQL Query failed to execute.";
+        qDebug() << " > Query:" << qry->lastQuery();
+        qDebug() << " > Error:" << qry->lastError().text();
+        qry->finish();
+        return false;
+    }
+
+    return true;
+}
+
+void SqliteConnection::clearStatements()
+{
+    foreach(QSqlQuery* qry, statements_)
+        delete qry;
+    statements_.clear();
+}
+
+void SqliteConnection::applyProfile()
+{
+    QElapsedTimer timer;
+
+    foreach(QString const& pragma, profile_.getPragmas()) {
+        // journal mode is a property of the db file, only writer sets it
+        if(read_only_ && pragma.startsWith("PRAGMA journal_mode"))
+            continue;
+
+        timer.start();
+
+        QSqlQuery qry(db_);
+        if(!qry.exec(pragma)) {
+            qDebug() << "FAILURE: could not apply pragma";
+            qDebug() << " > Pragma:" << pragma;
+            qDebug() << " > Error:" << qry.lastError().text();
+            continue;
+        }
+
+        // some pragmas report effective value (e.g. journal_mode)
+        QString value;
+        if(qry.next())
+            value = qry.value(0).toString();
+
+        qDebug() << " >" << pragma << value << "(ms:" << timer.elapsed() << ")";
+    }
+}
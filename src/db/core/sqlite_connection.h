@@ -0,0 +1,92 @@
+#ifndef DB_SQLITE_CONNECTION_H
+#define DB_SQLITE_CONNECTION_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QHash>
+#include <QVariantList>
+
+#include "db/core/sqlite_profile.h"
+
+/*
+ * Class owning one named connection to a Sqlite database.
+ * Keeps a cache of prepared statements, keyed by query string.
+ * Pragmas of given SqliteProfile are applied whenever the connection opens.
+ * A read-only connection refuses writes and skips pragmas changing the db file (journal_mode).
+ * Qt only allows a connection to be used on the thread that created it,
+ * so an instance has to be created, used and deleted on the same thread.
+*/
+class SqliteConnection
+{
+public:
+    SqliteConnection(QString const& connection_name, QString const& db_path,
+                     SqliteProfile const& profile = SqliteProfile(), bool read_only = false);
+    ~SqliteConnection();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    QString const& getConnectionName() const;
+    bool isReadOnly() const;
+
+    /* Executes given query string without caching the statement */
+    QList<QSqlRecord> const executeQuery(QString const& qry_str);
+
+    /*
+     * Performs query given by qry_str, binding values to its '?' placeholders.
+     * The statement is compiled once per query shape and cached,
+     * so repeated calls only rebind values.
+    */
+    QList<QSqlRecord> const preparedQuery(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /*
+     * Performs prepared query (see preparedQuery) and returns
+     * first column of first result row. Returns invalid QVariant if none found.
+    */
+    QVariant const preparedValue(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /*
+     * Executes prepared statement not returning rows (INSERT, UPDATE, DELETE).
+     * Returns success of execution.
+    */
+    bool preparedExec(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /* Returns id of row inserted by last successful preparedExec. -1 if none. */
+    int lastInsertId() const;
+
+    /*
+     * Transaction control for batched writes.
+     * Statements executed between begin and commit are written at once.
+    */
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
+private:
+    /*
+     * Gets cached statement compiled from given qry_str.
+     * Statement will be prepared and cached if none exists so far.
+     * Returns 0 if preparing fails.
+    */
+    QSqlQuery* getStatement(QString const& qry_str);
+
+    /* Binds values to given statement and executes it. Returns success. */
+    bool execStatement(QSqlQuery* qry, QVariantList const& values);
+
+    /* Deletes all cached statements (required before connection closes) */
+    void clearStatements();
+
+    /* Applies pragmas of profile_, logging time taken by each */
+    void applyProfile();
+
+    QString connection_name_;
+    QSqlDatabase db_;
+    SqliteProfile profile_;
+    bool read_only_;
+    QHash<QString, QSqlQuery*> statements_;
+    int last_insert_id_;
+};
+
+#endif // DB_SQLITE_CONNECTION_H
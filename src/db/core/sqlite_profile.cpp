@@ -0,0 +1,65 @@
+#include "sqlite_profile.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+
+SqliteProfile::SqliteProfile()
+    : journal_mode("WAL")
+    , synchronous("NORMAL")
+    , temp_store("MEMORY")
+    , mmap_size(256 * 1024 * 1024)
+    , cache_size(32 * 1024)
+{}
+
+const SqliteProfile SqliteProfile::load(const QString &ini_path)
+{
+    SqliteProfile profile;
+    if(!QFileInfo(ini_path).exists())
+        return profile;
+
+    QSettings settings(ini_path, QSettings::IniFormat);
+    settings.beginGroup("sqlite");
+
+    QString journal_mode = settings.value("journal_mode", profile.journal_mode).toString().toUpper();
+    if((QStringList() << "DELETE" << "TRUNCATE" << "PERSIST" << "MEMORY" << "WAL" << "OFF").contains(journal_mode))
+        profile.journal_mode = journal_mode;
+
+    QString synchronous = settings.value("synchronous", profile.synchronous).toString().toUpper();
+    if((QStringList() << "OFF" << "NORMAL" << "FULL" << "EXTRA").contains(synchronous))
+        profile.synchronous = synchronous;
+
+    QString temp_store = settings.value("temp_store", profile.temp_store).toString().toUpper();
+    if((QStringList() << "DEFAULT" << "FILE" << "MEMORY").contains(temp_store))
+        profile.temp_store = temp_store;
+
+    bool ok = false;
+    qint64 mmap_size = settings.value("mmap_size", profile.mmap_size).toLongLong(&ok);
+    if(ok && mmap_size >= 0)
+        profile.mmap_size = mmap_size;
+
+    int cache_size = settings.value("cache_size", profile.cache_size).toInt(&ok);
+    if(ok && cache_size > 0)
+        profile.cache_size = cache_size;
+
+    settings.endGroup();
+
+    qDebug() << "NOTIFICATION: loaded sqlite profile";
+    qDebug() << " > path:" << ini_path;
+
+    return profile;
+}
+
+const QStringList SqliteProfile::getPragmas() const
+{
+    QStringList pragmas;
+    pragmas << "PRAGMA journal_mode = " + journal_mode;
+    pragmas << "PRAGMA synchronous = " + synchronous;
+    pragmas << "PRAGMA temp_store = " + temp_store;
+    pragmas << "PRAGMA mmap_size = " + QString::number(mmap_size);
+
+    // negative values are read as KiB (instead of pages)
+    pragmas << "PRAGMA cache_size = -" + QString::number(cache_size);
+
+    return pragmas;
+}
@@ -0,0 +1,33 @@
+#ifndef DB_SQLITE_PROFILE_H
+#define DB_SQLITE_PROFILE_H
+
+#include <QString>
+#include <QStringList>
+
+/*
+ * Pragma settings applied to every connection once it is opened.
+ * Defaults favour read heavy use of a local library db:
+ * write-ahead log, relaxed syncing, memory mapped reads and a larger page cache.
+*/
+struct SqliteProfile
+{
+    SqliteProfile();
+
+    QString journal_mode;   // e.g. WAL, DELETE
+    QString synchronous;    // OFF, NORMAL, FULL
+    QString temp_store;     // DEFAULT, FILE, MEMORY
+    qint64 mmap_size;       // bytes, 0 disables memory mapping
+    int cache_size;         // KiB of page cache per connection
+
+    /*
+     * Gets default profile, overridden by values found in
+     * section [sqlite] of ini file at given path (if it exists).
+     * Keys equal member names. Invalid values are ignored.
+    */
+    static SqliteProfile const load(QString const& ini_path);
+
+    /* Gets PRAGMA statements applying this profile */
+    QStringList const getPragmas() const;
+};
+
+#endif // DB_SQLITE_PROFILE_H
@@ -1,42 +1,60 @@
 #include "sqlite_wrapper.h"
 
 #include <QDebug>
-#include <QSqlQuery>
-#include <QSqlError>
+#include <QThread>
+#include <QFileInfo>
 #include <QElapsedTimer>
-#include <QCoreApplication>
 
 SqliteWrapper::SqliteWrapper(QString const& db_path, QObject* parent):
     QObject(parent)
-  , db_()
+  , db_path_()
+  , connection_name_()
+  , profile_()
+  , pool_()
+  , connection_(0)
+  , db_thread_(0)
+  , read_connections_()
+  , read_open_failed_()
+  , read_pool_()
 {
+    pool_.setMaxThreadCount(1);
+    pool_.setExpiryTimeout(-1);
+
+    // idle reader threads expire (default timeout), taking their connection along
+    read_pool_.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+
     initDB(db_path);
 }
 
-QSqlRelationalTableModel* SqliteWrapper::getTable(TableIndex index)
+SqliteWrapper::~SqliteWrapper()
 {
-    if(!db_.isOpen() || index == NONE) {
-        qDebug() << "FAILURE: database not open";
-        return 0;
-    }
+    // connection has to be released on the thread owning it
+    std::function<bool()> release = [this]() {
+        delete connection_;
+        connection_ = 0;
+        return true;
+    };
+    QtConcurrent::run(&pool_, release).waitForFinished();
+    pool_.waitForDone();
+
+    // reader threads delete their connections as they finish,
+    // connection of destroying thread would outlive storage otherwise
+    read_pool_.waitForDone();
+    if(read_connections_.hasLocalData())
+        read_connections_.setLocalData(0);
+}
 
-    QSqlRelationalTableModel* model = new QSqlRelationalTableModel(this);
-    model->setTable(toString(index));
-    model->select();
+const QList<QSqlRecord> SqliteWrapper::getTable(TableIndex index)
+{
+    if(index == NONE)
+        return QList<QSqlRecord>();
 
-    QElapsedTimer timer;
-    timer.start();
-    while(model->canFetchMore()) {
-        model->fetchMore();
-        if(timer.elapsed() > 50) {
-            QCoreApplication::processEvents();
-            timer.start();
-            qDebug() << "NOTIFICATION: fetching more rows";
-            qDebug() << " > table name:" << model->tableName();
-        }
-    }
+    return preparedQuery("SELECT * FROM " + toString(index) + " ORDER BY id");
+}
 
-    return model;
+QFuture<QList<QSqlRecord> > SqliteWrapper::getTableAsync(TableIndex index)
+{
+    return preparedQueryAsync("SELECT * FROM " + toString(index) + " ORDER BY id");
 }
 
 const QList<QSqlRecord> SqliteWrapper::selectQuery(const QString &SELECT, const QString &FROM, const QString &WHERE)
@@ -77,29 +95,67 @@ void SqliteWrapper::deleteQuery(TableIndex index, const QString &WHERE)
     executeQuery(qry);
 }
 
-void SqliteWrapper::open()
+const QList<QSqlRecord> SqliteWrapper::preparedQuery(const QString &qry_str, const QVariantList &values)
 {
-    if(db_.isOpen()) {
-        qDebug() << "NOTIFICATION: database is already open";
-        return;
-    }
+    return callRead<QList<QSqlRecord> >([qry_str, values](SqliteConnection* c) -> QList<QSqlRecord> {
+        return c->preparedQuery(qry_str, values);
+    });
+}
 
-    if(db_.open()) {
-        qDebug() << "SUCCESS: connected to database";
-    }
-    else {
-        qDebug() << "FAILURE: could not open database";
-    }
+QFuture<QList<QSqlRecord> > SqliteWrapper::preparedQueryAsync(const QString &qry_str, const QVariantList &values)
+{
+    return callReadAsync<QList<QSqlRecord> >([qry_str, values](SqliteConnection* c) -> QList<QSqlRecord> {
+        return c->preparedQuery(qry_str, values);
+    });
+}
+
+const QVariant SqliteWrapper::preparedValue(const QString &qry_str, const QVariantList &values)
+{
+    return callRead<QVariant>([qry_str, values](SqliteConnection* c) -> QVariant {
+        return c->preparedValue(qry_str, values);
+    });
+}
+
+bool SqliteWrapper::preparedExec(const QString &qry_str, const QVariantList &values)
+{
+    return callSync<bool>([qry_str, values](SqliteConnection* c) -> bool {
+        return c->preparedExec(qry_str, values);
+    });
+}
+
+QFuture<bool> SqliteWrapper::preparedExecAsync(const QString &qry_str, const QVariantList &values)
+{
+    return callAsync<bool>([qry_str, values](SqliteConnection* c) -> bool {
+        return c->preparedExec(qry_str, values);
+    });
+}
+
+int SqliteWrapper::preparedInsert(const QString &qry_str, const QVariantList &values)
+{
+    return callSync<int>([qry_str, values](SqliteConnection* c) -> int {
+        if(!c->preparedExec(qry_str, values))
+            return -1;
+        return c->lastInsertId();
+    });
+}
+
+void SqliteWrapper::open()
+{
+    callSync<bool>([](SqliteConnection* c) -> bool {
+        return c->open();
+    });
 }
 
 void SqliteWrapper::close()
 {
-    if(db_.isOpen()) {
-        db_.close();
-    }
-    else {
-        qDebug() << "NOTIFICATION: database is not open";
-    }
+    callSync<bool>([](SqliteConnection* c) -> bool {
+        if(!c->isOpen()) {
+            qDebug() << "NOTIFICATION: database is not open";
+            return false;
+        }
+        c->close();
+        return true;
+    });
 }
 
 const QString SqliteWrapper::escape(const QString &str)
@@ -109,49 +165,60 @@ const QString SqliteWrapper::escape(const QString &str)
     return temp;
 }
 
+bool SqliteWrapper::isDatabaseThread() const
+{
+    return db_thread_.loadAcquire() == QThread::currentThread();
+}
+
 void SqliteWrapper::initDB(QString const& db_path)
 {
-    db_ = QSqlDatabase::addDatabase("QSQLITE");
-    db_.setDatabaseName(db_path);
+    db_path_ = db_path;
+    connection_name_ = "companion_db_" + QString::number((quintptr) this, 16);
 
     qDebug() << " > initializing db from:" << db_path;
 
+    profile_ = SqliteProfile::load(QFileInfo(db_path).absolutePath() + "/sqlite.ini");
+
+    QElapsedTimer timer;
+    timer.start();
     open();
+    qDebug() << " > db opened (ms):" << timer.elapsed();
 }
 
 const QList<QSqlRecord> SqliteWrapper::executeQuery(const QString & qry_str)
 {
-    QList<QSqlRecord> results;
-    if(!db_.isOpen()) {
-        qDebug() << "FAILURE: Database not open";
-        return results;
+    return callSync<QList<QSqlRecord> >([qry_str](SqliteConnection* c) -> QList<QSqlRecord> {
+        return c->executeQuery(qry_str);
+    });
+}
+
+SqliteConnection *SqliteWrapper::connection()
+{
+    if(connection_ == 0) {
+        connection_ = new SqliteConnection(connection_name_, db_path_, profile_);
+        db_thread_.storeRelease(QThread::currentThread());
     }
+    return connection_;
+}
 
-    QSqlQuery qry;
-    qry.prepare(qry_str);
-    qry.setForwardOnly(true);
-    if(qry.exec()) {
-        QElapsedTimer timer;
-        timer.start();
-        int i = 0;
-        while(qry.next()) {
-            results.append(qry.record());
-            ++i;
-            if(timer.elapsed() > 50) {
-                QCoreApplication::processEvents();
-                timer.start();
-                float progress = i / (float)qry.size();
-                qDebug() << "SELECTING " +
-                            QString::number(i) + "/" + QString::number(qry.size()) +
-                            " (" + QString::number( (int) (progress * 100) ) + "%)";
-            }
+SqliteConnection *SqliteWrapper::readConnection()
+{
+    if(!read_connections_.hasLocalData()) {
+        // opening failed before on this thread, do not retry on every read
+        if(read_open_failed_.localData())
+            return 0;
+
+        QString name = connection_name_ + "_read_" + QString::number((quintptr) QThread::currentThreadId(), 16);
+        SqliteConnection* c = new SqliteConnection(name, db_path_, profile_, true);
+        if(!c->open()) {
+            delete c;
+            read_open_failed_.setLocalData(true);
+            qDebug() << "FAILURE: could not open read connection, reading through database thread";
+            qDebug() << " > connection:" << name;
+            return 0;
         }
-    }
-    else {
-        qDebug() << "FAILURE: SQL Query failed to execute.";
-        qDebug() << " > Query:" << qry_str;
-        qDebug() << " > Error:" << qry.lastError().text();
+        read_connections_.setLocalData(c);
     }
 
-    return results;
+    return read_connections_.localData();
 }
@@ -2,24 +2,41 @@
 #define DB_SQLITE_WRAPPER_H
 
 #include <QObject>
-#include <QSqlDatabase>
-#include <QSqlRelationalTableModel>
 #include <QSqlRecord>
+#include <QVariantList>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QAtomicPointer>
+#include <QFuture>
+#include <QtConcurrent>
+
+#include <functional>
 
 #include "db/table_records.h"
+#include "db/core/sqlite_connection.h"
 
 /*
  * Class that can establish and manage connection to a Sqlite database.
  * Provides low-level access to data contained in db.
+ * All writes are performed on one dedicated database thread,
+ * which owns the (named) writer connection. Synchronous calls block the caller
+ * until the database thread is done, asynchronous calls return a QFuture.
+ * Reads (preparedQuery, preparedValue, getTable) run on the calling thread
+ * through a read-only connection owned by that thread, so any number of threads
+ * can read at once (concurrent with the writer in WAL mode).
+ * The connection is tuned by a SqliteProfile, which can be overridden
+ * by a sqlite.ini next to the database file.
 */
 class SqliteWrapper : public QObject
 {
     Q_OBJECT
 public:
     SqliteWrapper(QString const& db_path, QObject* parent = 0);
+    virtual ~SqliteWrapper();
 
-    /* Get a QSqlTableModel of a databse table identified by given TableIndex */
-    QSqlRelationalTableModel* getTable(TableIndex index);
+    /* Get all rows of a databse table identified by given TableIndex, ordered by id */
+    QList<QSqlRecord> const getTable(TableIndex index);
+    QFuture<QList<QSqlRecord> > getTableAsync(TableIndex index);
 
     /* Perform Select query with */
     QList<QSqlRecord> const selectQuery(QString const& SELECT, QString const& FROM, QString const& WHERE = "");
@@ -29,18 +46,129 @@ public:
 
     void deleteQuery(TableIndex index, QString const& WHERE);
 
+    /*
+     * Performs read-only query given by qry_str, binding values to its '?' placeholders.
+     * The statement is compiled once per query shape and cached on the connection,
+     * so repeated calls only rebind values.
+     * Runs on a read connection (see callRead), the async version on a reader pool thread.
+    */
+    QList<QSqlRecord> const preparedQuery(QString const& qry_str, QVariantList const& values = QVariantList());
+    QFuture<QList<QSqlRecord> > preparedQueryAsync(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /*
+     * Performs prepared read-only query (see preparedQuery) and returns
+     * first column of first result row. Returns invalid QVariant if none found.
+    */
+    QVariant const preparedValue(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /*
+     * Executes prepared statement not returning rows (INSERT, UPDATE, DELETE).
+     * Returns success of execution.
+    */
+    bool preparedExec(QString const& qry_str, QVariantList const& values = QVariantList());
+    QFuture<bool> preparedExecAsync(QString const& qry_str, QVariantList const& values = QVariantList());
+
+    /*
+     * Executes prepared INSERT statement (see preparedExec)
+     * and returns id of inserted row. Returns -1 on failure.
+    */
+    int preparedInsert(QString const& qry_str, QVariantList const& values = QVariantList());
+
     void open();
     void close();
 
     /* returns a safe version of given string as string value for sql query */
     static QString const escape(QString const& str);
 
+    /*
+     * Runs job on the database thread, passing the connection owned by it.
+     * Blocks until job is done and returns its result.
+     * Runs job directly, if called from the database thread.
+    */
+    template<typename T>
+    T callSync(std::function<T(SqliteConnection*)> const& job)
+    {
+        if(isDatabaseThread())
+            return job(connection());
+        return callAsync<T>(job).result();
+    }
+
+    /*
+     * Queues job on the database thread, passing the connection owned by it.
+     * Returns a future for the result of the job.
+    */
+    template<typename T>
+    QFuture<T> callAsync(std::function<T(SqliteConnection*)> const& job)
+    {
+        std::function<T()> task = [this, job]() { return job(connection()); };
+        return QtConcurrent::run(&pool_, task);
+    }
+
+    /*
+     * Runs job on calling thread, passing a read-only connection owned by that thread.
+     * The connection is opened on first call per thread and closed once the thread finishes.
+     * Runs job on writer connection, if called from the database thread (sees its uncommitted writes)
+     * or if no read connection can be opened.
+    */
+    template<typename T>
+    T callRead(std::function<T(SqliteConnection*)> const& job)
+    {
+        if(isDatabaseThread())
+            return job(connection());
+
+        SqliteConnection* c = readConnection();
+        if(c == 0)
+            return callSync<T>(job);
+
+        return job(c);
+    }
+
+    /* Queues read job (see callRead) on pool of reader threads */
+    template<typename T>
+    QFuture<T> callReadAsync(std::function<T(SqliteConnection*)> const& job)
+    {
+        std::function<T()> task = [this, job]() { return callRead<T>(job); };
+        return QtConcurrent::run(&read_pool_, task);
+    }
+
+    /* Returns true if called from the database thread */
+    bool isDatabaseThread() const;
+
 protected:
     void initDB(QString const&);
 
     QList<QSqlRecord> const executeQuery(QString const&);
 
-    QSqlDatabase db_;
+    /*
+     * Gets connection owned by database thread.
+     * Creates it on first call. Must only be called on database thread.
+    */
+    SqliteConnection* connection();
+
+    /*
+     * Gets read-only connection owned by calling thread.
+     * Creates it on first call per thread. Returns 0 if it cannot be opened,
+     * which is remembered for the calling thread.
+    */
+    SqliteConnection* readConnection();
+
+    QString db_path_;
+    QString connection_name_;
+
+    // pragmas applied to connection (see SqliteProfile)
+    SqliteProfile profile_;
+
+    // single, non-expiring thread running all database jobs
+    QThreadPool pool_;
+    SqliteConnection* connection_;
+    QAtomicPointer<QThread> db_thread_;
+
+    // read connection per thread, deleted as thread finishes.
+    // declared before read_pool_, so pool threads finish while storage still exists
+    QThreadStorage<SqliteConnection*> read_connections_;
+    // set for threads whose read connection could not be opened
+    QThreadStorage<bool> read_open_failed_;
+    QThreadPool read_pool_;
 };
 
 #endif // DB_SQLITE_WRAPPER_H
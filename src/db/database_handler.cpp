@@ -2,14 +2,18 @@
 
 #include <QDebug>
 #include <QElapsedTimer>
-#include <QCoreApplication>
-#include <QDebug>
+
+// number of sound files written per transaction on import
+static const int IMPORT_BATCH_SIZE = 1000;
 
 DatabaseHandler::DatabaseHandler(DatabaseApi* api, QObject *parent)
     : QObject(parent)
     , api_(api)
     , category_tree_model_(0)
     , sound_file_table_model_(0)
+    , sound_file_paged_model_(0)
+    , sound_file_search_model_(0)
+    , category_membership_index_(0)
     , resource_dir_table_model_(0)
     , image_dir_table_model_(0)
     , preset_table_model_(0)
@@ -45,11 +49,41 @@ SoundFileTableModel *DatabaseHandler::getSoundFileTableModel()
     return sound_file_table_model_;
 }
 
+SoundFilePagedModel *DatabaseHandler::getSoundFilePagedModel()
+{
+    if(sound_file_paged_model_ == 0) {
+        sound_file_paged_model_ = new SoundFilePagedModel(api_, this);
+        sound_file_paged_model_->select();
+    }
+
+    return sound_file_paged_model_;
+}
+
+SoundFileSearchModel *DatabaseHandler::getSoundFileSearchModel()
+{
+    if(sound_file_search_model_ == 0)
+        sound_file_search_model_ = new SoundFileSearchModel(api_, this);
+
+    return sound_file_search_model_;
+}
+
+CategoryMembershipIndex *DatabaseHandler::getCategoryMembershipIndex()
+{
+    if(category_membership_index_ == 0) {
+        category_membership_index_ = new CategoryMembershipIndex(api_, getCategoryTreeModel(), this);
+        category_membership_index_->select();
+    }
+
+    return category_membership_index_;
+}
+
 ResourceDirTableModel *DatabaseHandler::getResourceDirTableModel()
 {
     if(resource_dir_table_model_ == 0) {
         resource_dir_table_model_ = new ResourceDirTableModel(api_, this);
         resource_dir_table_model_->select();
+        connect(resource_dir_table_model_, SIGNAL(aboutToBeDeleted(ResourceDirRecord*)),
+                this, SLOT(onResourceDirAboutToBeDeleted(ResourceDirRecord*)));
     }
 
     return resource_dir_table_model_;
@@ -75,29 +109,29 @@ PresetTableModel *DatabaseHandler::getPresetTableModel()
     return preset_table_model_;
 }
 
-const QList<SoundFileRecord *> DatabaseHandler::getSoundFileRecordsByCategoryId(int category_id)
+const QList<SoundFileRecord> DatabaseHandler::getSoundFileRecordsByCategoryId(int category_id)
 {
-    QList<SoundFileRecord*> records;
-
-    QList<int> cat_ids = getCategoryTreeModel()->getSubCategoryIdsByCategoryId(category_id);
-    cat_ids.append(category_id);
-
-    foreach(int c_id, cat_ids) {
-        foreach(int s_id, api_->getRelatedIds(SOUND_FILE, CATEGORY, c_id))
-            records.append(getSoundFileTableModel()->getSoundFileById(s_id));
-    }
+    QList<int> ids = api_->getSoundFileIdsByCategoryTree(category_id);
+    return getSoundFileTableModel()->getSoundFilesByIds(ids);
+}
 
-    return records;
+const QList<SoundFileRecord> DatabaseHandler::getSoundFileRecordsByCategoryQuery(const QList<int> &all_of, const QList<int> &any_of, const QList<int> &none_of)
+{
+    QList<int> ids = getCategoryMembershipIndex()->query(all_of, any_of, none_of);
+    return getSoundFileTableModel()->getSoundFilesByIds(ids);
 }
 
-void DatabaseHandler::deleteAll()
+bool DatabaseHandler::deleteAll()
 {
-    api_->deleteAll();
+    if(!api_->deleteAll())
+        return false;
+
     getCategoryTreeModel()->update();
     getSoundFileTableModel()->update();
     getResourceDirTableModel()->update();
     getPresetTableModel()->update();
     getImageDirTableModel()->update();
+    return true;
 }
 
 void DatabaseHandler::addSoundFile(const QFileInfo& info, const ResourceDirRecord& resource_dir)
@@ -105,6 +139,25 @@ void DatabaseHandler::addSoundFile(const QFileInfo& info, const ResourceDirRecor
     getSoundFileTableModel()->addSoundFileRecord(info, resource_dir);
 }
 
+void DatabaseHandler::deleteSoundFiles(const QList<int> &ids)
+{
+    getSoundFileTableModel()->deleteSoundFiles(ids);
+}
+
+void DatabaseHandler::onResourceDirAboutToBeDeleted(ResourceDirRecord *rec)
+{
+    if(rec == 0)
+        return;
+
+    // trailing separator, so sibling dirs sharing a name prefix stay untouched
+    QString prefix = rec->path;
+    if(!prefix.endsWith("/"))
+        prefix += "/";
+
+    deleteSoundFiles(api_->getSoundFileIdsByPathPrefix(prefix));
+    api_->deleteResourceFolders(rec->id);
+}
+
 void DatabaseHandler::addCategory(QString name, CategoryRecord *parent)
 {
     int p_id = -1;
@@ -119,49 +172,84 @@ void DatabaseHandler::addSoundFileCategory(int sound_file_id, int category_id)
     api_->insertSoundFileCategory(sound_file_id, category_id);
 }
 
-void DatabaseHandler::insertSoundFilesAndCategories(const QList<Resources::SoundFile>& sound_files)
+void DatabaseHandler::importSoundFiles(const QList<Resources::SoundFile> &sound_files)
 {
-    emit progressChanged(0);
-    QCoreApplication::processEvents();
+    QHash<QString, int> category_ids;
+    for(int start = 0; start < sound_files.size(); start += IMPORT_BATCH_SIZE)
+        insertSoundFileBatch(sound_files.mid(start, IMPORT_BATCH_SIZE), category_ids);
+}
+
+void DatabaseHandler::insertSoundFileBatch(const QList<Resources::SoundFile> &batch, QHash<QString, int>& category_ids)
+{
+    if(batch.size() == 0)
+        return;
+
+    // group files by resource directory (in order of appearance),
+    // categories get resolved up front, so relations are written along with files
+    QList<ResourceDirRecord> resource_dirs;
+    QHash<QString, QList<QFileInfo> > infos_by_dir;
+    QHash<QString, QList<int> > category_ids_by_dir;
+    foreach(Resources::SoundFile const& sf, batch) {
+        ResourceDirRecord const& dir = sf.getResourceDir();
+        if(!infos_by_dir.contains(dir.path))
+            resource_dirs.append(dir);
+        infos_by_dir[dir.path].append(sf.getFileInfo());
+        category_ids_by_dir[dir.path].append(resolveCategoryId(sf.getCategoryPath(), category_ids));
+    }
 
-    QElapsedTimer timer;
-    timer.start();
+    // failed batches get logged (and rolled back) by model
+    foreach(ResourceDirRecord const& dir, resource_dirs)
+        getSoundFileTableModel()->addSoundFileRecords(infos_by_dir[dir.path], dir, category_ids_by_dir[dir.path]);
+}
 
-    CategoryRecord* cat = 0;
-    int i = 1;
-    foreach(Resources::SoundFile sf, sound_files) {
-        // check if sound_file already imported
-        SoundFileRecord* sf_rec = getSoundFileTableModel()->getSoundFileByPath(sf.getFileInfo().filePath());
-        if(sf_rec != 0)
-            continue;
+int DatabaseHandler::resolveCategoryId(const QStringList &path, QHash<QString, int> &category_ids)
+{
+    if(path.size() == 0)
+        return -1;
+
+    // resolve category once per path, insert if missing
+    QString key = path.join("/");
+    int cat_id = category_ids.value(key, -1);
+    if(cat_id != -1)
+        return cat_id;
+
+    CategoryRecord* cat = getCategoryTreeModel()->getCategoryByPath(path);
+    if(cat == 0) {
+        addCategory(path);
+        cat = getCategoryTreeModel()->getCategoryByPath(path);
+    }
+    if(cat == 0)
+        return -1;
 
-        // insert new sound_file into DB
-        addSoundFile(sf.getFileInfo(), sf.getResourceDir());
-        sf_rec = getSoundFileTableModel()->getLastSoundFileRecord();
+    category_ids.insert(key, cat->id);
+    return cat->id;
+}
 
-        // insert new category into DB
-        cat = getCategoryTreeModel()->getCategoryByPath(sf.getCategoryPath());
-        if(cat == 0) {
-            addCategory(sf.getCategoryPath());
-            cat = getCategoryTreeModel()->getCategoryByPath(sf.getCategoryPath());
-        }
+bool DatabaseHandler::applySoundFileDiff(const ResourceDirRecord &resource_dir, SoundFileDiff diff)
+{
+    // categories have to exist before files get related to them
+    QHash<QString, int> category_ids;
+    diff.added_category_ids.clear();
+    diff.added_category_ids.reserve(diff.added.size());
+    foreach(QFileInfo const& info, diff.added) {
+        Resources::SoundFile sf(info, resource_dir);
+        diff.added_category_ids.append(resolveCategoryId(sf.getCategoryPath(), category_ids));
+    }
 
-        // insert category sound_file relation into db
-        if(cat != 0)
-            addSoundFileCategory(sf_rec->id, cat->id);
+    if(!api_->applySoundFileDiff(diff, resource_dir))
+        return false;
 
-        if(timer.elapsed() > 100) {
-            int progress = (int) (i/(float)sound_files.size() * 100);
-            emit progressChanged(progress);
-            QCoreApplication::processEvents();
-            timer.start();
-        }
+    getSoundFileTableModel()->update();
+    return true;
+}
 
-        ++i;
-    }
+bool DatabaseHandler::relocateSoundFiles(const QList<SoundFileRelocation> &relocations)
+{
+    if(!api_->relocateSoundFiles(relocations))
+        return false;
 
-    emit progressChanged(100);
-    QCoreApplication::processEvents();
+    getSoundFileTableModel()->update();
+    return true;
 }
 
 void DatabaseHandler::addCategory(const QStringList &path)
@@ -4,11 +4,15 @@
 #include <QObject>
 
 #include <QSqlRelationalTableModel>
+#include <QHash>
 
 #include "core/database_api.h"
 #include "resources/sound_file.h"
 #include "model/category_tree_model.h"
 #include "model/sound_file_table_model.h"
+#include "model/sound_file_paged_model.h"
+#include "model/sound_file_search_model.h"
+#include "model/category_membership_index.h"
 #include "model/resource_dir_table_model.h"
 #include "model/image_dir_table_model.h"
 #include "model/preset_table_model.h"
@@ -27,24 +31,49 @@ public:
 
     CategoryTreeModel* getCategoryTreeModel();
     SoundFileTableModel* getSoundFileTableModel();
+
+    /*
+     * Gets model paging through whole sound library,
+     * without materializing all SoundFileRecords.
+    */
+    SoundFilePagedModel* getSoundFilePagedModel();
+
+    /* Gets model listing matches of a sound library search, fed while typing */
+    SoundFileSearchModel* getSoundFileSearchModel();
+
+    /* Gets in-memory index of category relations, built on first call */
+    CategoryMembershipIndex* getCategoryMembershipIndex();
+
     ResourceDirTableModel* getResourceDirTableModel();
     ImageDirTableModel* getImageDirTableModel();
     PresetTableModel* getPresetTableModel();
 
     /*
-     * Gets a list of SoundFileRecords,
-     * associated with Category referenced by given id.
+     * Gets a list of SoundFileRecord copies,
+     * associated with Category referenced by given id or any of its subcategories.
+     * Each SoundFileRecord is listed once, ordered by id.
     */
-    QList<SoundFileRecord*> const getSoundFileRecordsByCategoryId(int category_id = -1);
+    QList<SoundFileRecord> const getSoundFileRecordsByCategoryId(int category_id = -1);
+
+    /*
+     * Gets a list of SoundFileRecord copies related to (the subtrees of) all categories in all_of,
+     * any category in any_of and none of the categories in none_of,
+     * e.g. 'forest AND night NOT combat' (see CategoryMembershipIndex::query).
+     * Each SoundFileRecord is listed once, ordered by id.
+    */
+    QList<SoundFileRecord> const getSoundFileRecordsByCategoryQuery(QList<int> const& all_of,
+                                                                      QList<int> const& any_of = QList<int>(),
+                                                                      QList<int> const& none_of = QList<int>());
 
 signals:
     void progressChanged(int);
 
 public slots:
     /*
-    * deletes all contents of database
+    * deletes all contents of database.
+    * Returns success, models are left unchanged on failure.
     */
-    void deleteAll();
+    bool deleteAll();
 
     /*
      * Add SoundFile to DB
@@ -62,19 +91,59 @@ public slots:
     void addSoundFileCategory(int sound_file_id, int category_id);
 
     /*
-     * Inserts new SoundFiles based on list given.
+     * Inserts a batch of SoundFiles found by a running import.
      * Will also insert new Categories in case any SoundFile
      * describes a new path through the category tree.
     */
-    void insertSoundFilesAndCategories(QList<Resources::SoundFile> const&);
+    void importSoundFiles(QList<Resources::SoundFile> const&);
+
+    /*
+     * Deletes SoundFiles with given ids and their category relations
+     * in one transaction (see SoundFileTableModel::deleteSoundFiles).
+    */
+    void deleteSoundFiles(QList<int> const& ids);
+
+    /*
+     * Applies changes found by a rescan of given resource directory (see DatabaseApi::applySoundFileDiff).
+     * Categories of added files get resolved (and created if missing) first.
+     * Returns success.
+    */
+    bool applySoundFileDiff(ResourceDirRecord const& resource_dir, SoundFileDiff diff);
+
+    /*
+     * Moves sound files to new locations (see DatabaseApi::relocateSoundFiles).
+     * Returns success.
+    */
+    bool relocateSoundFiles(QList<SoundFileRelocation> const& relocations);
+
+private slots:
+    /* Deletes all SoundFiles located in resource dir about to be deleted */
+    void onResourceDirAboutToBeDeleted(ResourceDirRecord* rec);
 
 private:
     void addCategory(QStringList const& path);
 
+    /*
+     * Inserts given SoundFiles along with their category relations,
+     * one transaction per resource directory in batch.
+     * category_ids caches resolved category ids by joined category path.
+    */
+    void insertSoundFileBatch(QList<Resources::SoundFile> const& batch, QHash<QString, int>& category_ids);
+
+    /*
+     * Gets id of category at given path, inserting missing categories.
+     * category_ids caches resolved category ids by joined category path.
+     * Returns -1 for the empty path or if category could not be created.
+    */
+    int resolveCategoryId(QStringList const& path, QHash<QString, int>& category_ids);
+
     DatabaseApi* api_;
 
     CategoryTreeModel* category_tree_model_;
     SoundFileTableModel* sound_file_table_model_;
+    SoundFilePagedModel* sound_file_paged_model_;
+    SoundFileSearchModel* sound_file_search_model_;
+    CategoryMembershipIndex* category_membership_index_;
     ResourceDirTableModel* resource_dir_table_model_;
     ImageDirTableModel* image_dir_table_model_;
     PresetTableModel* preset_table_model_;
@@ -0,0 +1,221 @@
+#include "category_closure.h"
+
+#include <QPair>
+#include <QRegExp>
+#include <QtAlgorithms>
+
+// separates names within a path key
+static const QChar PATH_SEPARATOR = QChar(0x1e);
+
+// separates words within a normalized name
+static const QChar WORD_SEPARATOR = QChar(0x1f);
+
+CategoryClosure::CategoryClosure()
+    : nodes_()
+    , order_()
+    , order_dirty_(false)
+    , roots_()
+    , path_lookup_()
+{}
+
+void CategoryClosure::build(const QList<CategoryRecord*> &roots)
+{
+    clear();
+
+    foreach(CategoryRecord* root, roots)
+        visit(root, 0, "");
+
+    order_dirty_ = true;
+}
+
+void CategoryClosure::clear()
+{
+    nodes_.clear();
+    order_.clear();
+    order_dirty_ = false;
+    roots_.clear();
+    path_lookup_.clear();
+}
+
+bool CategoryClosure::add(const CategoryRecord &category)
+{
+    if(nodes_.contains(category.id))
+        return false;
+
+    int parent = category.parent_id > 0 ? category.parent_id : 0;
+    if(parent != 0 && !nodes_.contains(parent))
+        return false;
+
+    Node node;
+    node.parent = parent;
+    node.enter = -1;
+    node.exit = -1;
+    node.name = category.name;
+    node.path_key = childKey(parent == 0 ? "" : nodes_[parent].path_key, category.name);
+    nodes_.insert(category.id, node);
+
+    // positions get renumbered once for all categories added (see updateOrder)
+    if(parent == 0)
+        roots_.append(category.id);
+    else
+        nodes_[parent].children.append(category.id);
+    order_dirty_ = true;
+
+    insertPath(node.path_key, category.id);
+
+    return true;
+}
+
+void CategoryClosure::rename(int id, const QString &name)
+{
+    if(!nodes_.contains(id))
+        return;
+
+    nodes_[id].name = name;
+    updateOrder();
+
+    // path keys of whole subtree change, renew them in depth-first order (parents first)
+    int first = nodes_[id].enter;
+    int last = nodes_[id].exit;
+    for(int i = first; i <= last; ++i) {
+        Node& node = nodes_[order_[i]];
+        QString parent_key = node.parent == 0 ? "" : nodes_[node.parent].path_key;
+        node.path_key = childKey(parent_key, node.name);
+    }
+
+    // renamed paths may have shadowed (or been shadowed by) equal paths elsewhere
+    path_lookup_.clear();
+    foreach(int c_id, order_)
+        insertPath(nodes_[c_id].path_key, c_id);
+}
+
+bool CategoryClosure::contains(int id) const
+{
+    return nodes_.contains(id);
+}
+
+const QList<int> CategoryClosure::getDescendantIds(int id) const
+{
+    QList<int> ids;
+    updateOrder();
+
+    if(id == -1) {
+        ids.reserve(order_.size());
+        foreach(int c_id, order_)
+            ids.append(c_id);
+        return ids;
+    }
+
+    if(!nodes_.contains(id))
+        return ids;
+
+    Node const& node = nodes_[id];
+    ids.reserve(node.exit - node.enter);
+    for(int i = node.enter + 1; i <= node.exit; ++i)
+        ids.append(order_[i]);
+
+    return ids;
+}
+
+bool CategoryClosure::isDescendant(int id, int ancestor_id) const
+{
+    if(id == ancestor_id || !nodes_.contains(id) || !nodes_.contains(ancestor_id))
+        return false;
+
+    updateOrder();
+
+    Node const& node = nodes_[id];
+    Node const& ancestor = nodes_[ancestor_id];
+    return ancestor.enter < node.enter && node.exit <= ancestor.exit;
+}
+
+int CategoryClosure::getIdByPath(const QStringList &path) const
+{
+    if(path.size() == 0)
+        return 0;
+
+    QString key;
+    foreach(QString const& name, path)
+        key = childKey(key, name);
+
+    return path_lookup_.value(key, -1);
+}
+
+const QString CategoryClosure::normalizeName(const QString &name)
+{
+    // equal word sets are equal names
+    QStringList words = name.split(QRegExp("-|\\s")).toSet().toList();
+    qSort(words);
+    return words.join(WORD_SEPARATOR);
+}
+
+void CategoryClosure::visit(CategoryRecord *category, int parent, const QString &parent_key)
+{
+    Node node;
+    node.parent = parent;
+    node.enter = -1;
+    node.exit = -1;
+    node.name = category->name;
+    node.path_key = childKey(parent_key, category->name);
+
+    if(parent == 0)
+        roots_.append(category->id);
+    else
+        nodes_[parent].children.append(category->id);
+
+    nodes_.insert(category->id, node);
+    insertPath(node.path_key, category->id);
+
+    foreach(CategoryRecord* child, category->children)
+        visit(child, category->id, node.path_key);
+}
+
+void CategoryClosure::updateOrder() const
+{
+    if(!order_dirty_)
+        return;
+
+    order_.clear();
+    order_.reserve(nodes_.size());
+
+    // depth-first walk without recursion, exit gets set once all descendants got appended
+    typedef QPair<int, int> Entry; // id, index of next child to visit
+    QVector<Entry> stack;
+    foreach(int root, roots_) {
+        stack.append(Entry(root, 0));
+        nodes_[root].enter = order_.size();
+        order_.append(root);
+
+        while(!stack.isEmpty()) {
+            int id = stack.last().first;
+            int next = stack.last().second;
+            QList<int> const& children = nodes_[id].children;
+            if(next < children.size()) {
+                int child = children[next];
+                stack.last().second = next + 1;
+                nodes_[child].enter = order_.size();
+                order_.append(child);
+                stack.append(Entry(child, 0));
+            }
+            else {
+                nodes_[id].exit = order_.size() - 1;
+                stack.removeLast();
+            }
+        }
+    }
+
+    order_dirty_ = false;
+}
+
+const QString CategoryClosure::childKey(const QString &parent_key, const QString &name)
+{
+    if(parent_key.isEmpty())
+        return normalizeName(name);
+    return parent_key + PATH_SEPARATOR + normalizeName(name);
+}
+
+void CategoryClosure::insertPath(const QString &key, int id)
+{
+    if(!path_lookup_.contains(key))
+        path_lookup_.insert(key, id);
+}
@@ -0,0 +1,93 @@
+#ifndef DB_MODEL_CATEGORY_CLOSURE_H
+#define DB_MODEL_CATEGORY_CLOSURE_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include "db/table_records.h"
+
+/*
+ * Precomputed hierarchy lookups of a category tree.
+ * Categories are kept in depth-first (Euler tour) order, so each category
+ * spans one interval of that order holding itself and all of its descendants.
+ * Path lookups go through a hash of normalized name paths
+ * (names compared as in CategoryTreeModel::equalCategoryName).
+ * Added categories get linked in right away, the order is renumbered once
+ * on the next query needing it, so adding many categories stays linear.
+ * Anything else than adding or renaming requires build().
+*/
+class CategoryClosure
+{
+public:
+    CategoryClosure();
+
+    /* Rebuilds closure from given top level categories (and their children) */
+    void build(QList<CategoryRecord*> const& roots);
+
+    void clear();
+
+    /*
+     * Adds category as last child of its parent (parent_id <= 0 for top level).
+     * Returns false if category is known already or parent is unknown.
+    */
+    bool add(CategoryRecord const& category);
+
+    /* Sets name of category, updating paths of its subtree */
+    void rename(int id, QString const& name);
+
+    bool contains(int id) const;
+
+    /* Gets ids of all descendants of category (depth-first order), all categories for id -1 */
+    QList<int> const getDescendantIds(int id) const;
+
+    /*
+     * Returns true if category id lies below category ancestor_id.
+     * Compares depth-first intervals, constant time once order is up to date.
+    */
+    bool isDescendant(int id, int ancestor_id) const;
+
+    /*
+     * Gets id of category at given name path (top level name first).
+     * Returns -1 if none found, 0 for the empty path (root).
+    */
+    int getIdByPath(QStringList const& path) const;
+
+    /* Gets key names are compared by (word order, ' ' and '-' do not matter) */
+    static QString const normalizeName(QString const& name);
+
+private:
+    struct Node {
+        int parent;
+        int enter;   // position in order_
+        int exit;    // position of last descendant in order_
+        QString name;
+        QString path_key;
+        QList<int> children;
+    };
+
+    /* Links subtree of category below parent (used by build) */
+    void visit(CategoryRecord* category, int parent, QString const& parent_key);
+
+    /* Renumbers order_ (and enter/exit of all nodes) if categories got added since */
+    void updateOrder() const;
+
+    /* Builds path key of child named name below parent_key */
+    static QString const childKey(QString const& parent_key, QString const& name);
+
+    /* Registers path key for id, first category wins on equal keys */
+    void insertPath(QString const& key, int id);
+
+    // order_ and enter/exit of nodes get renumbered lazily (see updateOrder)
+    mutable QHash<int, Node> nodes_;
+    mutable QVector<int> order_;
+    mutable bool order_dirty_;
+
+    // top level categories in order
+    QList<int> roots_;
+
+    QHash<QString, int> path_lookup_;
+};
+
+#endif // DB_MODEL_CATEGORY_CLOSURE_H
@@ -0,0 +1,195 @@
+#include "category_membership_index.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+CategoryMembershipIndex::CategoryMembershipIndex(DatabaseApi* api, CategoryTreeModel* categories, QObject* parent)
+    : QObject(parent)
+    , api_(api)
+    , categories_(categories)
+    , members_()
+    , sound_files_()
+    , sound_file_version_(-1)
+    , relation_version_(-1)
+{}
+
+void CategoryMembershipIndex::select()
+{
+    if(api_ == 0) {
+        qDebug() << "FAILURE: cannot select CategoryMembershipIndex";
+        qDebug() << " > (DB::Api*) api is null";
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // versions are taken before reading, writes racing the read get applied again on next update
+    sound_file_version_ = api_->getTableVersion(SOUND_FILE);
+    relation_version_ = api_->getTableVersion(SOUND_FILE_CATEGORY);
+
+    QHash<int, QList<int> > related;
+    foreach(QSqlRecord const& rec, api_->getSoundFileCategoryTable())
+        related[rec.value("category_id").toInt()].append(rec.value("sound_file_id").toInt());
+
+    members_.clear();
+    members_.reserve(related.size());
+    QHash<int, QList<int> >::const_iterator it;
+    for(it = related.constBegin(); it != related.constEnd(); ++it)
+        members_.insert(it.key(), SoundFileBitmap::fromList(it.value()));
+
+    sound_files_ = SoundFileBitmap::fromList(api_->getSoundFileIds());
+
+    qDebug() << "NOTIFICATION: CategoryMembershipIndex built in" << timer.elapsed() << "ms";
+    logMemoryReport();
+}
+
+const SoundFileBitmap CategoryMembershipIndex::getSubtree(int category_id)
+{
+    update();
+
+    SoundFileBitmap result;
+
+    if(category_id == -1) {
+        foreach(SoundFileBitmap const& members, members_)
+            result |= members;
+        return result;
+    }
+
+    result = members_.value(category_id);
+    if(categories_ != 0) {
+        foreach(int id, categories_->getDescendantIdsByCategoryId(category_id)) {
+            if(members_.contains(id))
+                result |= members_[id];
+        }
+    }
+
+    return result;
+}
+
+const QList<int> CategoryMembershipIndex::query(const QList<int> &all_of, const QList<int> &any_of, const QList<int> &none_of)
+{
+    update();
+
+    if(categories_ != 0)
+        categories_->update();
+
+    SoundFileBitmap result;
+
+    if(all_of.isEmpty() && any_of.isEmpty()) {
+        result = sound_files_;
+    }
+    else {
+        for(int i = 0; i < all_of.size(); ++i) {
+            result = i == 0 ? getSubtree(all_of[i]) : result & getSubtree(all_of[i]);
+            if(result.isEmpty())
+                return QList<int>();
+        }
+
+        if(!any_of.isEmpty()) {
+            SoundFileBitmap any;
+            foreach(int id, any_of)
+                any |= getSubtree(id);
+            result = all_of.isEmpty() ? any : result & any;
+        }
+    }
+
+    if(!none_of.isEmpty() && !result.isEmpty()) {
+        SoundFileBitmap none;
+        foreach(int id, none_of)
+            none |= getSubtree(id);
+        result = result.andNot(none);
+    }
+
+    return result.toList();
+}
+
+qint64 CategoryMembershipIndex::memoryUsage() const
+{
+    qint64 bytes = sound_files_.memoryUsage();
+
+    foreach(SoundFileBitmap const& members, members_)
+        bytes += sizeof(int) + sizeof(SoundFileBitmap) + members.memoryUsage();
+    bytes += members_.capacity() * sizeof(void*);
+
+    return bytes;
+}
+
+void CategoryMembershipIndex::update()
+{
+    if(api_ == 0)
+        return;
+
+    // nothing written since last refresh
+    if(api_->getTableVersion(SOUND_FILE) == sound_file_version_
+            && api_->getTableVersion(SOUND_FILE_CATEGORY) == relation_version_)
+        return;
+
+    if(!applyChanges())
+        select();
+}
+
+bool CategoryMembershipIndex::applyChanges()
+{
+    int sound_file_version = api_->getTableVersion(SOUND_FILE);
+    int relation_version = api_->getTableVersion(SOUND_FILE_CATEGORY);
+
+    QSet<int> file_ids;
+    QSet<int> relation_ids;
+    if(!api_->getChangedIds(SOUND_FILE, sound_file_version_, file_ids))
+        return false;
+    if(!api_->getChangedIds(SOUND_FILE_CATEGORY, relation_version_, relation_ids))
+        return false;
+
+    // a missing relation row got deleted, the pair it held is not known anymore
+    QList<QSqlRecord> relations = api_->getRecords(SOUND_FILE_CATEGORY, relation_ids.toList());
+    if(relations.size() != relation_ids.size())
+        return false;
+
+    QList<QSqlRecord> files = api_->getRecords(SOUND_FILE, file_ids.toList());
+
+    foreach(QSqlRecord const& rec, files) {
+        int id = rec.value("id").toInt();
+        sound_files_.add(id);
+        file_ids.remove(id);
+    }
+
+    foreach(QSqlRecord const& rec, relations)
+        members_[rec.value("category_id").toInt()].add(rec.value("sound_file_id").toInt());
+
+    // ids left have no row anymore
+    if(!file_ids.isEmpty())
+        removeSoundFiles(SoundFileBitmap::fromList(file_ids.toList()));
+
+    sound_file_version_ = sound_file_version;
+    relation_version_ = relation_version;
+
+    return true;
+}
+
+void CategoryMembershipIndex::removeSoundFiles(const SoundFileBitmap &removed)
+{
+    sound_files_ = sound_files_.andNot(removed);
+
+    QHash<int, SoundFileBitmap>::iterator it = members_.begin();
+    while(it != members_.end()) {
+        it.value() = it.value().andNot(removed);
+        if(it.value().isEmpty())
+            it = members_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void CategoryMembershipIndex::logMemoryReport() const
+{
+    int relations = 0;
+    foreach(SoundFileBitmap const& members, members_)
+        relations += members.cardinality();
+
+    qDebug() << "NOTIFICATION: CategoryMembershipIndex memory report";
+    qDebug() << " > categories:" << members_.size();
+    qDebug() << " > sound files:" << sound_files_.cardinality();
+    qDebug() << " > relations:" << relations;
+    qDebug() << " > index (KiB):" << memoryUsage() / 1024;
+}
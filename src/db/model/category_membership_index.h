@@ -0,0 +1,80 @@
+#ifndef DB_MODEL_CATEGORY_MEMBERSHIP_INDEX_H
+#define DB_MODEL_CATEGORY_MEMBERSHIP_INDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+
+#include "db/core/database_api.h"
+#include "db/model/category_tree_model.h"
+#include "db/model/sound_file_bitmap.h"
+
+/*
+ * In-memory index of the sound_file_category table.
+ * Holds one SoundFileBitmap of related sound_file ids per category,
+ * so combinations of categories (and their subtrees) resolve through
+ * set operations instead of db queries.
+ * The index follows writes through the api change log. Row-wise changes are
+ * applied in place, anything else (e.g. cleared tables, deleted relations)
+ * rebuilds it from db.
+ * Updates happen lazily, on the first query after a write.
+*/
+class CategoryMembershipIndex : public QObject
+{
+    Q_OBJECT
+public:
+    CategoryMembershipIndex(DatabaseApi* api, CategoryTreeModel* categories, QObject* parent = 0);
+
+    /* Reads all relations from db and rebuilds the index */
+    void select();
+
+    /*
+     * Gets ids of sound_files related to category with given id
+     * or any category below it. Covers all categorized sound_files for id -1.
+    */
+    SoundFileBitmap const getSubtree(int category_id);
+
+    /*
+     * Gets ids of sound_files related to the subtree (see getSubtree)
+     * of every category in all_of, of at least one category in any_of
+     * and of no category in none_of. Empty lists do not restrict.
+     * With all_of and any_of empty, none_of is applied to all sound_files.
+     * Ids are ordered ascending.
+    */
+    QList<int> const query(QList<int> const& all_of, QList<int> const& any_of = QList<int>(), QList<int> const& none_of = QList<int>());
+
+    /* Approximate heap memory held by this index (bytes) */
+    qint64 memoryUsage() const;
+
+public slots:
+    /* Applies writes to sound_file and sound_file_category since last update */
+    void update();
+
+private:
+    /*
+     * Applies changed rows of sound_file and sound_file_category in place.
+     * Returns false if changes are not known row by row or relations got deleted.
+    */
+    bool applyChanges();
+
+    /* Removes given sound_file ids from all bitmaps */
+    void removeSoundFiles(SoundFileBitmap const& removed);
+
+    /* Logs size of index after rebuild */
+    void logMemoryReport() const;
+
+    DatabaseApi* api_;
+    CategoryTreeModel* categories_;
+
+    // directly related sound_file ids by category id
+    QHash<int, SoundFileBitmap> members_;
+
+    // all sound_file ids (categorized or not)
+    SoundFileBitmap sound_files_;
+
+    // versions of sound_file and sound_file_category index was built from
+    int sound_file_version_;
+    int relation_version_;
+};
+
+#endif // DB_MODEL_CATEGORY_MEMBERSHIP_INDEX_H
@@ -5,23 +5,22 @@
 
 CategoryTreeModel::CategoryTreeModel(DatabaseApi* api, QObject* parent)
     : QStandardItemModel(parent)
-    , table_model_(0)
     , api_(api)
     , categories_()
     , category_to_item_()
+    , closure_()
     , editable_(true)
+    , version_(-1)
 {}
 
 void CategoryTreeModel::select()
 {
-    table_model_ = api_->getCategoryTable();
-    connect(table_model_, SIGNAL(rowsInserted(QModelIndex,int,int)),
-            this, SLOT(dbRowsInserted(QModelIndex,int,int)));
     connect(this, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)),
-            this, SLOT(onDataChanged(QModelIndex,QModelIndex,QVector<int>)));
+            this, SLOT(onDataChanged(QModelIndex,QModelIndex,QVector<int>)),
+            Qt::UniqueConnection);
 
-    if(table_model_)
-        createModel();
+    version_ = api_->getTableVersion(CATEGORY);
+    createModel(api_->getCategoryTable());
 }
 
 void CategoryTreeModel::setEditable(bool editable)
@@ -48,7 +47,7 @@ CategoryRecord* CategoryTreeModel::getCategoryByItem(QStandardItem* item)
 
 CategoryRecord* CategoryTreeModel::getCategoryByPath(const QStringList& path)
 {
-    return getCategoryByItem(getItemByPath(path));
+    return getCategoryById(closure_.getIdByPath(path));
 }
 
 CategoryRecord* CategoryTreeModel::getCategoryById(int rid)
@@ -77,29 +76,14 @@ QStandardItem* CategoryTreeModel::getItemByCategory(CategoryRecord* category)
 
 QStandardItem* CategoryTreeModel::getItemByPath(const QStringList &path)
 {
-    QStandardItem* item = invisibleRootItem();
-    QString name = "";
-    bool found_item = true;
-    foreach(QString cat, path) {
-        found_item = false;
-        for(int child = 0; child < item->rowCount(); ++child) {
-            name = getCategoryByItem(item->child(child))->name;
-            if(equalCategoryName(name, cat)) {
-                item = item->child(child);
-                found_item  = true;
-                break;
-            }
-        }
-        if(!found_item)
-            break;
-    }
+    int id = closure_.getIdByPath(path);
 
-    if(found_item)
-        return item;
+    // empty path
+    if(id == 0)
+        return invisibleRootItem();
 
-    return 0;
+    return getItemByCategory(getCategoryById(id));
 }
-
 const QStringList CategoryTreeModel::getSubCategoryNamesByItem(QStandardItem* item)
 {
     QStringList list;
@@ -146,6 +130,16 @@ const QList<int> CategoryTreeModel::getSubCategoryIdsByCategoryId(int id)
     return getSubCategoryIdsByItem(getItemByCategory(getCategoryById(id)));
 }
 
+const QList<int> CategoryTreeModel::getDescendantIdsByCategoryId(int id)
+{
+    return closure_.getDescendantIds(id);
+}
+
+bool CategoryTreeModel::isSubCategory(int id, int ancestor_id) const
+{
+    return closure_.isDescendant(id, ancestor_id);
+}
+
 bool CategoryTreeModel::equalCategoryName(const QString &left, const QString &right)
 {
     return left.split(QRegExp("-|\\s")).toSet() == right.split(QRegExp("-|\\s")).toSet();
@@ -163,51 +157,45 @@ bool CategoryTreeModel::exists(const QString &name, CategoryRecord* parent)
 
 void CategoryTreeModel::update()
 {
-    table_model_->select();
-    createModel();
-    emit updated();
-}
+    // nothing written since last build
+    int version = api_->getTableVersion(CATEGORY);
+    if(version == version_)
+        return;
 
-void CategoryTreeModel::dbRowsInserted(QModelIndex, int, int)
-{
-    createModel();
+    // categories only got added (e.g. import), extend tree in place
+    QSet<int> ids;
+    if(api_->getChangedIds(CATEGORY, version_, ids) && insertCategories(api_->getRecords(CATEGORY, ids.toList()), ids)) {
+        version_ = version;
+        emit updated();
+        return;
+    }
+
+    version_ = version;
+    createModel(api_->getCategoryTable());
+    emit updated();
 }
 
 void CategoryTreeModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex&, const QVector<int>&)
 {
-    QMap<QString, int> attribute_col;
-    attribute_col["id"] = -1;
-    attribute_col["name"] = -1;
-    for(int col = 0; col < table_model_->columnCount(); ++col) {
-        QString header_name = table_model_->headerData(col, Qt::Horizontal, Qt::DisplayRole).toString();
-        attribute_col[header_name] = col;
-    }
-
     QString name = topLeft.data(Qt::DisplayRole).toString();
     int rid = topLeft.data(Qt::UserRole).toInt();
 
-    for(int row = 0; row < table_model_->rowCount(); ++row) {
-        QModelIndex index = table_model_->index(row,attribute_col["id"]);
-        if(index.data().toInt() == rid) {
-            QModelIndex index = table_model_->index(row,attribute_col["name"]);
-            table_model_->setData(index, name);
-            table_model_->submit();
-        }
+    CategoryRecord* category = getCategoryById(rid);
+    if(category == 0 || category->name.compare(name) == 0)
+        return;
+
+    if(api_->updateCategoryName(rid, name)) {
+        category->name = name;
+        closure_.rename(rid, name);
+
+        // tree already shows the new name
+        version_ = api_->getTableVersion(CATEGORY);
     }
 }
 
-void CategoryTreeModel::createModel()
+void CategoryTreeModel::createModel(QList<QSqlRecord> const& rows)
 {
-    QMap<QString, int> attribute_col;
-    attribute_col["id"] = -1;
-    attribute_col["name"] = -1;
-    attribute_col["parent_id"] = -1;
-    for(int col = 0; col < table_model_->columnCount(); ++col) {
-        QString header_name = table_model_->headerData(col, Qt::Horizontal, Qt::DisplayRole).toString();
-        attribute_col[header_name] = col;
-    }
-
-    if(attribute_col["id"] == -1 || attribute_col["name"] == -1){
+    if(rows.size() > 0 && (rows[0].indexOf("id") == -1 || rows[0].indexOf("name") == -1)) {
         qDebug() << "FAILURE: incomplete category table.";
         return;
     }
@@ -221,16 +209,12 @@ void CategoryTreeModel::createModel()
 
     QList<CategoryRecord*> root_categories;
 
-    for(int row = 0; row < table_model_->rowCount(); ++row) {
-        QModelIndex index;
+    foreach(QSqlRecord const& row, rows) {
         CategoryRecord* category = new CategoryRecord;
 
-        index = table_model_->index(row, attribute_col["id"]);
-        category->id = table_model_->data(index).toInt();
-        index = table_model_->index(row, attribute_col["name"]);
-        category->name = table_model_->data(index).toString();
-        index = table_model_->index(row, attribute_col["parent_id"]);
-        category->parent_id = table_model_->data(index).toInt();
+        category->id = row.value("id").toInt();
+        category->name = row.value("name").toString();
+        category->parent_id = row.value("parent_id").toInt();
 
         categories_[category->id] = category;
 
@@ -254,6 +238,8 @@ void CategoryTreeModel::createModel()
 
     QStandardItem* parentItem = invisibleRootItem();
     setChildItems(parentItem, root_categories);
+
+    closure_.build(root_categories);
 }
 
 void CategoryTreeModel::setChildItems(QStandardItem* item, QList<CategoryRecord*> children)
@@ -271,3 +257,49 @@ void CategoryTreeModel::setChildItems(QStandardItem* item, QList<CategoryRecord*
         }
     }
 }
+
+bool CategoryTreeModel::insertCategories(const QList<QSqlRecord> &rows, const QSet<int> &ids)
+{
+    // deleted rows
+    if(rows.size() != ids.size())
+        return false;
+
+    // only new categories below known (or preceding new) parents
+    QSet<int> batch_ids;
+    foreach(QSqlRecord const& row, rows) {
+        int id = row.value("id").toInt();
+        int parent_id = row.value("parent_id").toInt();
+        if(categories_.contains(id))
+            return false;
+        if(parent_id > 0 && !categories_.contains(parent_id) && !batch_ids.contains(parent_id))
+            return false;
+        batch_ids.insert(id);
+    }
+
+    foreach(QSqlRecord const& row, rows) {
+        CategoryRecord* category = new CategoryRecord;
+
+        category->id = row.value("id").toInt();
+        category->name = row.value("name").toString();
+        category->parent_id = row.value("parent_id").toInt();
+
+        categories_[category->id] = category;
+
+        QStandardItem* parent_item = invisibleRootItem();
+        if(category->parent_id > 0) {
+            category->parent = categories_[category->parent_id];
+            category->parent->children.append(category);
+            parent_item = getItemByCategory(category->parent);
+        }
+
+        QStandardItem* item = new QStandardItem;
+        item->setData(category->id, Qt::UserRole);
+        item->setData(category->name, Qt::DisplayRole);
+        parent_item->appendRow(item);
+
+        category_to_item_[category] = item;
+        closure_.add(*category);
+    }
+
+    return true;
+}
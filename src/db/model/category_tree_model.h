@@ -2,18 +2,20 @@
 #define DB_MODEL_CATEGORY_TREE_MODEL_H
 
 #include <QStandardItemModel>
-#include <QSqlRelationalTableModel>
+#include <QSqlRecord>
 
 #include "db/table_records.h"
 #include "db/core/database_api.h"
+#include "db/model/category_closure.h"
 
 /*
  * Class derived from QStandartItemModel
- * contains an instance of QSqlRelationalTableModel
- * which refers to a hierarchical category db table.
+ * reads the rows of a hierarchical category db table.
  * This class will recursively transfer given table into
  * an n-dimensional QStandardItemModel, which can be connected
  * to a QTreeView. Convinience functions ease data access.
+ * Hierarchy and path lookups are answered by a CategoryClosure,
+ * built along with the tree and extended as categories get added.
 */
 
 class CategoryTreeModel : public QStandardItemModel
@@ -90,7 +92,14 @@ public:
     /* Gets all subcategory ids of given CategoryRecord */
     QList<int> const getSubCategoryIdsByCategoryId(int);
 
-    /* Adds a CategoryRecord to this model and  **/
+    /*
+     * Gets ids of all categories below category with given id (any depth).
+     * Returns ids of all categories for id -1.
+    */
+    QList<int> const getDescendantIdsByCategoryId(int id);
+
+    /* Returns true if category with given id lies below category ancestor_id (any depth) */
+    bool isSubCategory(int id, int ancestor_id) const;
 
     /*
      * Compares given Category names.
@@ -103,9 +112,8 @@ public:
     bool exists(QString const& name, CategoryRecord* parent);
 
 public slots:
-    /* Reselects and builds the CategoryTreeModel **/
+    /* Reselects and builds the CategoryTreeModel, if Category table changed since last build **/
     void update();
-    void dbRowsInserted(QModelIndex,int, int);
     void onDataChanged(QModelIndex const& topLeft,
                        QModelIndex const& bottomRight,
                        QVector<int> const& roles);
@@ -114,8 +122,8 @@ signals:
     void updated();
 
 private:
-    /* build this model based on underlying QSqlrelationalTableModel. **/
-    void createModel();
+    /* build this model based on given rows of Category table. **/
+    void createModel(QList<QSqlRecord> const& rows);
 
     /*
      * Recursive function setting all child QStandardItems for given QStandardItem.
@@ -124,15 +132,23 @@ private:
     **/
     void setChildItems(QStandardItem* item, QList<CategoryRecord*> children);
 
-    // underlying QSqlrelationalTableModel referencing DB Category table.
-    QSqlRelationalTableModel* table_model_;
+    /*
+     * Adds categories of given rows to tree, if they are all new
+     * and their parents are known (ids lists all ids rows were read for).
+     * Returns false without changing anything otherwise.
+    */
+    bool insertCategories(QList<QSqlRecord> const& rows, QSet<int> const& ids);
 
     DatabaseApi* api_;
 
     QMap<int, CategoryRecord*> categories_;
     QMap<CategoryRecord*, QStandardItem*> category_to_item_;
+    CategoryClosure closure_;
 
     bool editable_;
+
+    // version of Category table this model was built from
+    int version_;
 };
 
 #endif // DB_MODEL_CATEGORY_TREE_MODEL_H
@@ -0,0 +1,122 @@
+#include "id_ordered_table_model.h"
+
+#include <QMap>
+#include <QtAlgorithms>
+
+IdOrderedTableModel::IdOrderedTableModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{}
+
+IdOrderedTableModel::~IdOrderedTableModel()
+{}
+
+void IdOrderedTableModel::mergeChanges(DatabaseApi* api, TableIndex table, int& version)
+{
+    // nothing written since last refresh
+    int current = api->getTableVersion(table);
+    if(current == version)
+        return;
+
+    QSet<int> ids;
+    QList<QSqlRecord> rows;
+    if(api->getChangedIds(table, version, ids)) {
+        rows = api->getRecords(table, ids.toList());
+    }
+    else {
+        rows = api->getTable(table);
+        ids.reserve(rowCount() + rows.size());
+        for(int row = 0; row < rowCount(); ++row)
+            ids.insert(rowId(row));
+        foreach(QSqlRecord const& row, rows)
+            ids.insert(row.value("id").toInt());
+    }
+
+    mergeRows(rows, ids);
+    version = current;
+}
+
+void IdOrderedTableModel::mergeRows(const QList<QSqlRecord> &rows, const QSet<int> &ids)
+{
+    QMap<int, QSqlRecord> fetched;
+    foreach(QSqlRecord const& row, rows)
+        fetched.insert(row.value("id").toInt(), row);
+
+    // update changed rows, collect deleted ones
+    QList<int> removed_rows;
+    foreach(int id, ids) {
+        int row = findRow(id);
+        if(row == -1)
+            continue;
+
+        if(!fetched.contains(id)) {
+            removed_rows.append(row);
+            continue;
+        }
+
+        if(updateRow(row, fetched.take(id)))
+            emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+    }
+
+    if(removed_rows.size() > 0) {
+        qSort(removed_rows);
+        removeDeletedRows(removed_rows);
+    }
+
+    // insert remaining (new) rows, keeping rows ordered by id
+    QMap<int, QSqlRecord>::const_iterator it = fetched.constBegin();
+    while(it != fetched.constEnd()) {
+        int pos = getInsertRow(it.key());
+
+        // collect all new rows falling in between same neighbours
+        QList<QSqlRecord> batch;
+        while(it != fetched.constEnd() && (pos == rowCount() || it.key() < rowId(pos))) {
+            batch.append(it.value());
+            ++it;
+        }
+
+        beginInsertRows(QModelIndex(), pos, pos + batch.size() - 1);
+        insertRecords(pos, batch);
+        endInsertRows();
+    }
+}
+
+int IdOrderedTableModel::getInsertRow(int id) const
+{
+    int low = 0;
+    int high = rowCount();
+    while(low < high) {
+        int mid = (low + high) / 2;
+        if(rowId(mid) < id)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+int IdOrderedTableModel::findRow(int id) const
+{
+    int row = getInsertRow(id);
+    if(row < rowCount() && rowId(row) == id)
+        return row;
+    return -1;
+}
+
+void IdOrderedTableModel::removeRowRuns(const QList<int> &rows)
+{
+    // back to front so preceding rows keep their position
+    int i = rows.size() - 1;
+    while(i >= 0) {
+        int last = rows[i];
+        int first = last;
+        while(i > 0 && rows[i - 1] == first - 1) {
+            --i;
+            --first;
+        }
+        --i;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        eraseRows(first, last - first + 1);
+        endRemoveRows();
+    }
+}
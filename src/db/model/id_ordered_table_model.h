@@ -0,0 +1,64 @@
+#ifndef DB_MODEL_ID_ORDERED_TABLE_MODEL_H
+#define DB_MODEL_ID_ORDERED_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QSet>
+#include "db/core/database_api.h"
+
+/*
+ * Base class of table models holding the rows of one db table ordered by id.
+ * Applies rows written since last refresh (see DatabaseApi::getChangedIds)
+ * as rowsInserted/rowsRemoved/dataChanged, so views keep their state.
+ * Derived classes provide how their rows get read, compared and stored.
+*/
+class IdOrderedTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit IdOrderedTableModel(QObject *parent = 0);
+    virtual ~IdOrderedTableModel();
+
+protected:
+    /*
+     * Applies rows of given table written since version onto model
+     * and sets version to current table version.
+     * Diffs the whole table if changes are not known row by row.
+     * Does nothing if table is unchanged.
+    */
+    void mergeChanges(DatabaseApi* api, TableIndex table, int& version);
+
+    /*
+     * Applies given rows onto model.
+     * ids lists all ids rows were read for, ids missing in rows got deleted.
+    */
+    void mergeRows(QList<QSqlRecord> const& rows, QSet<int> const& ids);
+
+    /* Gets row a record with given id has to be inserted at (rows are ordered by id) */
+    int getInsertRow(int id) const;
+
+    /* Gets row of given id. Returns -1 if none found. */
+    int findRow(int id) const;
+
+    /*
+     * Removes given rows (ascending) in contiguous runs, back to front,
+     * announcing each run to views (see eraseRows).
+    */
+    void removeRowRuns(QList<int> const& rows);
+
+    /* Gets id of record at given row */
+    virtual int rowId(int row) const = 0;
+
+    /* Sets record at given row from values. Returns true if any value changed. */
+    virtual bool updateRow(int row, QSqlRecord const& values) = 0;
+
+    /* Stores records read from given rows starting at row (inside beginInsertRows/endInsertRows) */
+    virtual void insertRecords(int row, QList<QSqlRecord> const& rows) = 0;
+
+    /* Signals deletion of records at given rows (ascending) and removes them */
+    virtual void removeDeletedRows(QList<int> const& rows) = 0;
+
+    /* Drops count records starting at first (inside beginRemoveRows/endRemoveRows) */
+    virtual void eraseRows(int first, int count) = 0;
+};
+
+#endif // DB_MODEL_ID_ORDERED_TABLE_MODEL_H
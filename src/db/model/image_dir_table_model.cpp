@@ -1,13 +1,12 @@
 #include "image_dir_table_model.h"
 
-#include <QCoreApplication>
 #include <QDebug>
 
 ImageDirTableModel::ImageDirTableModel(DatabaseApi* api, QObject* parent)
-    : QAbstractTableModel(parent)
+    : IdOrderedTableModel(parent)
     , api_(api)
-    , source_model_(0)
     , records_()
+    , version_(-1)
 {}
 
 ImageDirTableModel::~ImageDirTableModel()
@@ -112,20 +111,18 @@ bool ImageDirTableModel::removeRow(int row, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(rec);
-        QCoreApplication::processEvents();
 
-        // remove from source
-        if(!source_model_->removeRow(row, QModelIndex()))
+        // remove from db
+        if(!api_->deleteRecords(IMAGE_DIRECTORY, QList<int>() << rec->id))
             return false;
 
         // remove from storage & delete pointer
+        beginRemoveRows(QModelIndex(), row, row);
         records_.removeAt(row);
+        endRemoveRows();
         delete rec;
         rec = 0;
 
-        // call super class function
-        QAbstractTableModel::removeRow(row, QModelIndex());
-
         return true;
     }
 
@@ -150,15 +147,19 @@ bool ImageDirTableModel::removeRows(int row, int count, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(recs);
-        QCoreApplication::processEvents();
 
-        // remove from source model
-        if(!source_model_->removeRows(row, count, QModelIndex()))
+        // remove from db
+        QList<int> ids;
+        foreach(ImageDirRecord* rec, recs)
+            ids.append(rec->id);
+        if(!api_->deleteRecords(IMAGE_DIRECTORY, ids))
             return false;
 
         // remove from storage
+        beginRemoveRows(QModelIndex(), row, row+count);
         for(int i = row+count; i >= row; --i)
             records_.removeAt(i);
+        endRemoveRows();
 
         // delete pointers
         while(recs.size() > 0) {
@@ -168,9 +169,6 @@ bool ImageDirTableModel::removeRows(int row, int count, const QModelIndex&)
             recs.pop_front();
         }
 
-        // call super class function
-        QAbstractTableModel::removeRows(row, count, QModelIndex());
-
         return true;
     }
 
@@ -179,7 +177,10 @@ bool ImageDirTableModel::removeRows(int row, int count, const QModelIndex&)
 
 void ImageDirTableModel::update()
 {
-    select();
+    if(api_ == 0)
+        return;
+
+    mergeChanges(api_, IMAGE_DIRECTORY, version_);
 }
 
 void ImageDirTableModel::select()
@@ -190,31 +191,23 @@ void ImageDirTableModel::select()
         return;
     }
 
+    beginResetModel();
+
     if(records_.size() > 0)
         clear();
 
-    source_model_ = api_->getImageDirTable();
+    version_ = api_->getTableVersion(IMAGE_DIRECTORY);
+    QList<QSqlRecord> rows = api_->getImageDirTable();
 
-    int c_id = source_model_->fieldIndex("id");
-    int c_path = source_model_->fieldIndex("path");
-    for(int row = 0; row < source_model_->rowCount(); ++row) {
+    foreach(QSqlRecord const& row, rows) {
         ImageDirRecord* rec = new ImageDirRecord;
-
-        // set id
-        QModelIndex index = source_model_->index(row, c_id);
-        rec->id = source_model_->data(index).toInt();
-
-        // set path
-        index = source_model_->index(row, c_path);
-        rec->path = source_model_->data(index).toString();
+        readRow(row, rec);
 
         // add to list of records
         records_.append(rec);
     }
 
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
-    emit dataChanged(index(0,0), index(rowCount(), columnCount()));
+    endResetModel();
 }
 
 int ImageDirTableModel::getRowByImageDir(ImageDirRecord *rec)
@@ -285,10 +278,10 @@ void ImageDirTableModel::addImageDirRecord(const QFileInfo &info)
         return;
     }
 
+    // new ids are highest, so record goes last
+    beginInsertRows(QModelIndex(), records_.size(), records_.size());
     records_.append(new ImageDirRecord(id, info.fileName(), info.filePath()));
-
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
+    endInsertRows();
 }
 
 const QList<ImageDirRecord *> &ImageDirTableModel::getImageDirs() const
@@ -308,6 +301,54 @@ void ImageDirTableModel::deleteImageDir(int id)
         removeRow(row);
 }
 
+bool ImageDirTableModel::readRow(const QSqlRecord &row, ImageDirRecord *rec)
+{
+    int id = row.value("id").toInt();
+    QString path = row.value("path").toString();
+
+    bool changed = rec->id != id || rec->path != path;
+
+    rec->id = id;
+    rec->path = path;
+
+    return changed;
+}
+
+int ImageDirTableModel::rowId(int row) const
+{
+    return records_[row]->id;
+}
+
+bool ImageDirTableModel::updateRow(int row, const QSqlRecord &values)
+{
+    return readRow(values, records_[row]);
+}
+
+void ImageDirTableModel::insertRecords(int row, const QList<QSqlRecord> &rows)
+{
+    for(int i = 0; i < rows.size(); ++i) {
+        ImageDirRecord* rec = new ImageDirRecord;
+        readRow(rows[i], rec);
+        records_.insert(row + i, rec);
+    }
+}
+
+void ImageDirTableModel::removeDeletedRows(const QList<int> &rows)
+{
+    QList<ImageDirRecord*> recs;
+    foreach(int row, rows)
+        recs.append(records_[row]);
+    emit aboutToBeDeleted(recs);
+
+    removeRowRuns(rows);
+}
+
+void ImageDirTableModel::eraseRows(int first, int count)
+{
+    for(int row = first + count - 1; row >= first; --row)
+        delete records_.takeAt(row);
+}
+
 bool ImageDirTableModel::indexIsValid(const QModelIndex & index) const
 {
     return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
@@ -1,13 +1,12 @@
 #include "preset_table_model.h"
 
-#include <QCoreApplication>
 #include <QDebug>
 
 PresetTableModel::PresetTableModel(DatabaseApi* api, QObject* parent)
-    : QAbstractTableModel(parent)
+    : IdOrderedTableModel(parent)
     , api_(api)
-    , source_model_(0)
     , records_()
+    , version_(-1)
 {}
 
 PresetTableModel::~PresetTableModel()
@@ -120,20 +119,18 @@ bool PresetTableModel::removeRow(int row, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(rec);
-        QCoreApplication::processEvents();
 
-        // remove from source
-        if(!source_model_->removeRow(row, QModelIndex()))
+        // remove from db
+        if(!api_->deleteRecords(PRESET, QList<int>() << rec->id))
             return false;
 
         // remove from storage & delete pointer
+        beginRemoveRows(QModelIndex(), row, row);
         records_.removeAt(row);
+        endRemoveRows();
         delete rec;
         rec = 0;
 
-        // call super class function
-        QAbstractTableModel::removeRow(row, QModelIndex());
-
         return true;
     }
 
@@ -158,15 +155,19 @@ bool PresetTableModel::removeRows(int row, int count, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(recs);
-        QCoreApplication::processEvents();
 
-        // remove from source model
-        if(!source_model_->removeRows(row, count, QModelIndex()))
+        // remove from db
+        QList<int> ids;
+        foreach(PresetRecord* rec, recs)
+            ids.append(rec->id);
+        if(!api_->deleteRecords(PRESET, ids))
             return false;
 
         // remove from storage
+        beginRemoveRows(QModelIndex(), row, row+count);
         for(int i = row+count; i >= row; --i)
             records_.removeAt(i);
+        endRemoveRows();
 
         // delete pointers
         while(recs.size() > 0) {
@@ -176,9 +177,6 @@ bool PresetTableModel::removeRows(int row, int count, const QModelIndex&)
             recs.pop_front();
         }
 
-        // call super class function
-        QAbstractTableModel::removeRows(row, count, QModelIndex());
-
         return true;
     }
 
@@ -187,7 +185,10 @@ bool PresetTableModel::removeRows(int row, int count, const QModelIndex&)
 
 void PresetTableModel::update()
 {
-    select();
+    if(api_ == 0)
+        return;
+
+    mergeChanges(api_, PRESET, version_);
 }
 
 void PresetTableModel::select()
@@ -198,36 +199,23 @@ void PresetTableModel::select()
         return;
     }
 
+    beginResetModel();
+
     if(records_.size() > 0)
         clear();
 
-    source_model_ = api_->getPresetTable();
+    version_ = api_->getTableVersion(PRESET);
+    QList<QSqlRecord> rows = api_->getPresetTable();
 
-    int c_id = source_model_->fieldIndex("id");
-    int c_name = source_model_->fieldIndex("name");
-    int c_json = source_model_->fieldIndex("json");
-    for(int row = 0; row < source_model_->rowCount(); ++row) {
+    foreach(QSqlRecord const& row, rows) {
         PresetRecord* rec = new PresetRecord;
-
-        // set id
-        QModelIndex index = source_model_->index(row, c_id);
-        rec->id = source_model_->data(index).toInt();
-
-        // set name
-        index = source_model_->index(row, c_name);
-        rec->name = source_model_->data(index).toString();
-
-        // set json
-        index = source_model_->index(row, c_json);
-        rec->json = source_model_->data(index).toString();
+        readRow(row, rec);
 
         // add to list of records
         records_.append(rec);
     }
 
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
-    emit dataChanged(index(0,0), index(rowCount(), columnCount()));
+    endResetModel();
 }
 
 int PresetTableModel::getRowByPreset(PresetRecord *rec)
@@ -286,10 +274,10 @@ void PresetTableModel::addPresetRecord(const QString& name, const QString& json)
         return;
     }
 
+    // new ids are highest, so record goes last
+    beginInsertRows(QModelIndex(), records_.size(), records_.size());
     records_.append(new PresetRecord(id, name, json));
-
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
+    endInsertRows();
 }
 
 const QList<PresetRecord *> &PresetTableModel::getPresets() const
@@ -309,6 +297,56 @@ void PresetTableModel::deletePreset(int id)
         removeRow(row);
 }
 
+bool PresetTableModel::readRow(const QSqlRecord &row, PresetRecord *rec)
+{
+    int id = row.value("id").toInt();
+    QString name = row.value("name").toString();
+    QString json = row.value("json").toString();
+
+    bool changed = rec->id != id || rec->name != name || rec->json != json;
+
+    rec->id = id;
+    rec->name = name;
+    rec->json = json;
+
+    return changed;
+}
+
+int PresetTableModel::rowId(int row) const
+{
+    return records_[row]->id;
+}
+
+bool PresetTableModel::updateRow(int row, const QSqlRecord &values)
+{
+    return readRow(values, records_[row]);
+}
+
+void PresetTableModel::insertRecords(int row, const QList<QSqlRecord> &rows)
+{
+    for(int i = 0; i < rows.size(); ++i) {
+        PresetRecord* rec = new PresetRecord;
+        readRow(rows[i], rec);
+        records_.insert(row + i, rec);
+    }
+}
+
+void PresetTableModel::removeDeletedRows(const QList<int> &rows)
+{
+    QList<PresetRecord*> recs;
+    foreach(int row, rows)
+        recs.append(records_[row]);
+    emit aboutToBeDeleted(recs);
+
+    removeRowRuns(rows);
+}
+
+void PresetTableModel::eraseRows(int first, int count)
+{
+    for(int row = first + count - 1; row >= first; --row)
+        delete records_.takeAt(row);
+}
+
 bool PresetTableModel::indexIsValid(const QModelIndex & index) const
 {
     return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
@@ -1,13 +1,12 @@
 #include "resource_dir_table_model.h"
 
-#include <QCoreApplication>
 #include <QDebug>
 
 ResourceDirTableModel::ResourceDirTableModel(DatabaseApi* api, QObject* parent)
-    : QAbstractTableModel(parent)
+    : IdOrderedTableModel(parent)
     , api_(api)
-    , source_model_(0)
     , records_()
+    , version_(-1)
 {}
 
 ResourceDirTableModel::~ResourceDirTableModel()
@@ -120,20 +119,18 @@ bool ResourceDirTableModel::removeRow(int row, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(rec);
-        QCoreApplication::processEvents();
 
-        // remove from source
-        if(!source_model_->removeRow(row, QModelIndex()))
+        // remove from db
+        if(!api_->deleteRecords(RESOURCE_DIRECTORY, QList<int>() << rec->id))
             return false;
 
         // remove from storage & delete pointer
+        beginRemoveRows(QModelIndex(), row, row);
         records_.removeAt(row);
+        endRemoveRows();
         delete rec;
         rec = 0;
 
-        // call super class function
-        QAbstractTableModel::removeRow(row, QModelIndex());
-
         return true;
     }
 
@@ -158,15 +155,19 @@ bool ResourceDirTableModel::removeRows(int row, int count, const QModelIndex&)
 
         // signal deletion
         emit aboutToBeDeleted(recs);
-        QCoreApplication::processEvents();
 
-        // remove from source model
-        if(!source_model_->removeRows(row, count, QModelIndex()))
+        // remove from db
+        QList<int> ids;
+        foreach(ResourceDirRecord* rec, recs)
+            ids.append(rec->id);
+        if(!api_->deleteRecords(RESOURCE_DIRECTORY, ids))
             return false;
 
         // remove from storage
+        beginRemoveRows(QModelIndex(), row, row+count);
         for(int i = row+count; i >= row; --i)
             records_.removeAt(i);
+        endRemoveRows();
 
         // delete pointers
         while(recs.size() > 0) {
@@ -176,9 +177,6 @@ bool ResourceDirTableModel::removeRows(int row, int count, const QModelIndex&)
             recs.pop_front();
         }
 
-        // call super class function
-        QAbstractTableModel::removeRows(row, count, QModelIndex());
-
         return true;
     }
 
@@ -187,7 +185,10 @@ bool ResourceDirTableModel::removeRows(int row, int count, const QModelIndex&)
 
 void ResourceDirTableModel::update()
 {
-    select();
+    if(api_ == 0)
+        return;
+
+    mergeChanges(api_, RESOURCE_DIRECTORY, version_);
 }
 
 void ResourceDirTableModel::select()
@@ -198,36 +199,23 @@ void ResourceDirTableModel::select()
         return;
     }
 
+    beginResetModel();
+
     if(records_.size() > 0)
         clear();
 
-    source_model_ = api_->getResourceDirTable();
+    version_ = api_->getTableVersion(RESOURCE_DIRECTORY);
+    QList<QSqlRecord> rows = api_->getResourceDirTable();
 
-    int c_id = source_model_->fieldIndex("id");
-    int c_name = source_model_->fieldIndex("name");
-    int c_path = source_model_->fieldIndex("path");
-    for(int row = 0; row < source_model_->rowCount(); ++row) {
+    foreach(QSqlRecord const& row, rows) {
         ResourceDirRecord* rec = new ResourceDirRecord;
-
-        // set id
-        QModelIndex index = source_model_->index(row, c_id);
-        rec->id = source_model_->data(index).toInt();
-
-        // set name
-        index = source_model_->index(row, c_name);
-        rec->name = source_model_->data(index).toString();
-
-        // set path
-        index = source_model_->index(row, c_path);
-        rec->path = source_model_->data(index).toString();
+        readRow(row, rec);
 
         // add to list of records
         records_.append(rec);
     }
 
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
-    emit dataChanged(index(0,0), index(rowCount(), columnCount()));
+    endResetModel();
 }
 
 int ResourceDirTableModel::getRowByResourceDir(ResourceDirRecord *rec)
@@ -298,10 +286,10 @@ void ResourceDirTableModel::addResourceDirRecord(const QFileInfo &info)
         return;
     }
 
+    // new ids are highest, so record goes last
+    beginInsertRows(QModelIndex(), records_.size(), records_.size());
     records_.append(new ResourceDirRecord(id, info.fileName(), info.filePath()));
-
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
+    endInsertRows();
 }
 
 const QList<ResourceDirRecord *> &ResourceDirTableModel::getResourceDirs() const
@@ -321,6 +309,56 @@ void ResourceDirTableModel::deleteResourceDir(int id)
         removeRow(row);
 }
 
+bool ResourceDirTableModel::readRow(const QSqlRecord &row, ResourceDirRecord *rec)
+{
+    int id = row.value("id").toInt();
+    QString name = row.value("name").toString();
+    QString path = row.value("path").toString();
+
+    bool changed = rec->id != id || rec->name != name || rec->path != path;
+
+    rec->id = id;
+    rec->name = name;
+    rec->path = path;
+
+    return changed;
+}
+
+int ResourceDirTableModel::rowId(int row) const
+{
+    return records_[row]->id;
+}
+
+bool ResourceDirTableModel::updateRow(int row, const QSqlRecord &values)
+{
+    return readRow(values, records_[row]);
+}
+
+void ResourceDirTableModel::insertRecords(int row, const QList<QSqlRecord> &rows)
+{
+    for(int i = 0; i < rows.size(); ++i) {
+        ResourceDirRecord* rec = new ResourceDirRecord;
+        readRow(rows[i], rec);
+        records_.insert(row + i, rec);
+    }
+}
+
+void ResourceDirTableModel::removeDeletedRows(const QList<int> &rows)
+{
+    QList<ResourceDirRecord*> recs;
+    foreach(int row, rows)
+        recs.append(records_[row]);
+    emit aboutToBeDeleted(recs);
+
+    removeRowRuns(rows);
+}
+
+void ResourceDirTableModel::eraseRows(int first, int count)
+{
+    for(int row = first + count - 1; row >= first; --row)
+        delete records_.takeAt(row);
+}
+
 bool ResourceDirTableModel::indexIsValid(const QModelIndex & index) const
 {
     return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
@@ -1,11 +1,12 @@
 #ifndef DB_MODEL_RESOURCE_DIR_TABLE_MODEL_H
 #define DB_MODEL_RESOURCE_DIR_TABLE_MODEL_H
 
-#include <QAbstractTableModel>
+#include <QSet>
 #include "db/core/database_api.h"
 #include "db/table_records.h"
+#include "db/model/id_ordered_table_model.h"
 
-class ResourceDirTableModel : public QAbstractTableModel
+class ResourceDirTableModel : public IdOrderedTableModel
 {
     Q_OBJECT
 public:
@@ -44,7 +45,12 @@ public:
 
     //// end inheritted functions
 
-    /* Update model with data from db */
+    /*
+     * Update model with data from db.
+     * Only rows written since last refresh are re-read and
+     * signaled (rowsInserted/rowsRemoved/dataChanged), so views keep their state.
+     * Does nothing if table is unchanged.
+    */
     void update();
 
     /* Fills model with data from SoundFile database table **/
@@ -108,9 +114,24 @@ private:
     /* Clears all ResourceDirRecords from records **/
     void clear();
 
+    /* Sets fields of rec from given row. Returns true if any value changed. */
+    bool readRow(QSqlRecord const& row, ResourceDirRecord* rec);
+
+    //// IdOrderedTableModel functions - see base class for description
+
+    int rowId(int row) const;
+
+    bool updateRow(int row, QSqlRecord const& values);
+
+    void insertRecords(int row, QList<QSqlRecord> const& rows);
+
+    void removeDeletedRows(QList<int> const& rows);
+
+    void eraseRows(int first, int count);
+
     DatabaseApi* api_;
-    QSqlRelationalTableModel* source_model_;
     QList<ResourceDirRecord*> records_;
+    int version_;
 };
 
 #endif // DB_MODEL_RESOURCE_DIR_TABLE_MODEL_H
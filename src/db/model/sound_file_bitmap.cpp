@@ -0,0 +1,460 @@
+#include "sound_file_bitmap.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <iterator>
+
+// entries a container holds as sorted array, before switching to a bitmap
+static const int ARRAY_MAX = 4096;
+
+// 64 bit words of a bitmap container (65536 bits)
+static const int BITMAP_WORDS = 1024;
+
+// approximate bytes of a QVector besides its elements
+static const int VECTOR_OVERHEAD = sizeof(QArrayData) + 16;
+
+SoundFileBitmap::Container::Container()
+    : key(0)
+    , cardinality(0)
+    , array()
+    , bits()
+{}
+
+bool SoundFileBitmap::Container::isBitmap() const
+{
+    return !bits.isEmpty();
+}
+
+bool SoundFileBitmap::Container::contains(quint16 low) const
+{
+    if(isBitmap())
+        return (bits[low >> 6] >> (low & 63)) & 1;
+
+    QVector<quint16>::const_iterator it = std::lower_bound(array.begin(), array.end(), low);
+    return it != array.end() && *it == low;
+}
+
+void SoundFileBitmap::Container::add(quint16 low)
+{
+    if(isBitmap()) {
+        quint64 mask = (quint64) 1 << (low & 63);
+        if(bits[low >> 6] & mask)
+            return;
+        bits[low >> 6] |= mask;
+        ++cardinality;
+        return;
+    }
+
+    QVector<quint16>::iterator it = std::lower_bound(array.begin(), array.end(), low);
+    if(it != array.end() && *it == low)
+        return;
+    array.insert(it, low);
+    ++cardinality;
+    normalize();
+}
+
+void SoundFileBitmap::Container::remove(quint16 low)
+{
+    if(isBitmap()) {
+        quint64 mask = (quint64) 1 << (low & 63);
+        if(!(bits[low >> 6] & mask))
+            return;
+        bits[low >> 6] &= ~mask;
+        --cardinality;
+        normalize();
+        return;
+    }
+
+    QVector<quint16>::iterator it = std::lower_bound(array.begin(), array.end(), low);
+    if(it == array.end() || *it != low)
+        return;
+    array.erase(it);
+    --cardinality;
+}
+
+void SoundFileBitmap::Container::normalize()
+{
+    if(isBitmap() && cardinality <= ARRAY_MAX) {
+        array.clear();
+        array.reserve(cardinality);
+        for(int w = 0; w < BITMAP_WORDS; ++w) {
+            quint64 word = bits[w];
+            while(word != 0) {
+                int bit = qCountTrailingZeroBits(word);
+                array.append((quint16) ((w << 6) | bit));
+                word &= word - 1;
+            }
+        }
+        bits.clear();
+        bits.squeeze();
+    }
+    else if(!isBitmap() && cardinality > ARRAY_MAX) {
+        bits.fill(0, BITMAP_WORDS);
+        foreach(quint16 low, array)
+            bits[low >> 6] |= (quint64) 1 << (low & 63);
+        array.clear();
+        array.squeeze();
+    }
+}
+
+SoundFileBitmap::SoundFileBitmap()
+    : containers_()
+{}
+
+const SoundFileBitmap SoundFileBitmap::fromList(const QList<int> &ids)
+{
+    QList<int> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+
+    // sorted ids fill containers front to back, array appends stay cheap
+    SoundFileBitmap set;
+    foreach(int id, sorted) {
+        if(id < 0)
+            continue;
+
+        quint16 key = (quint16) (id >> 16);
+        quint16 low = (quint16) (id & 0xFFFF);
+
+        if(set.containers_.isEmpty() || set.containers_.last().key != key) {
+            Container c;
+            c.key = key;
+            set.containers_.append(c);
+        }
+
+        Container& c = set.containers_.last();
+        if(!c.isBitmap() && c.cardinality > 0 && c.array.last() == low)
+            continue;
+        if(!c.isBitmap() && c.cardinality < ARRAY_MAX) {
+            c.array.append(low);
+            ++c.cardinality;
+        }
+        else {
+            c.add(low);
+        }
+    }
+
+    return set;
+}
+
+void SoundFileBitmap::add(int id)
+{
+    if(id < 0)
+        return;
+
+    quint16 key = (quint16) (id >> 16);
+    int pos = findContainer(key);
+    if(pos == containers_.size() || containers_[pos].key != key) {
+        Container c;
+        c.key = key;
+        containers_.insert(pos, c);
+    }
+
+    containers_[pos].add((quint16) (id & 0xFFFF));
+}
+
+void SoundFileBitmap::remove(int id)
+{
+    if(id < 0)
+        return;
+
+    quint16 key = (quint16) (id >> 16);
+    int pos = findContainer(key);
+    if(pos == containers_.size() || containers_[pos].key != key)
+        return;
+
+    containers_[pos].remove((quint16) (id & 0xFFFF));
+    if(containers_[pos].cardinality == 0)
+        containers_.remove(pos);
+}
+
+bool SoundFileBitmap::contains(int id) const
+{
+    if(id < 0)
+        return false;
+
+    quint16 key = (quint16) (id >> 16);
+    int pos = findContainer(key);
+    if(pos == containers_.size() || containers_[pos].key != key)
+        return false;
+
+    return containers_[pos].contains((quint16) (id & 0xFFFF));
+}
+
+int SoundFileBitmap::cardinality() const
+{
+    int count = 0;
+    foreach(Container const& c, containers_)
+        count += c.cardinality;
+    return count;
+}
+
+bool SoundFileBitmap::isEmpty() const
+{
+    return containers_.isEmpty();
+}
+
+void SoundFileBitmap::clear()
+{
+    containers_.clear();
+}
+
+const QList<int> SoundFileBitmap::toList() const
+{
+    QList<int> ids;
+    ids.reserve(cardinality());
+
+    foreach(Container const& c, containers_) {
+        int high = (int) c.key << 16;
+        if(c.isBitmap()) {
+            for(int w = 0; w < BITMAP_WORDS; ++w) {
+                quint64 word = c.bits[w];
+                while(word != 0) {
+                    ids.append(high | (w << 6) | qCountTrailingZeroBits(word));
+                    word &= word - 1;
+                }
+            }
+        }
+        else {
+            foreach(quint16 low, c.array)
+                ids.append(high | low);
+        }
+    }
+
+    return ids;
+}
+
+const SoundFileBitmap SoundFileBitmap::operator&(const SoundFileBitmap &other) const
+{
+    SoundFileBitmap result;
+
+    int i = 0;
+    int j = 0;
+    while(i < containers_.size() && j < other.containers_.size()) {
+        quint16 left = containers_[i].key;
+        quint16 right = other.containers_[j].key;
+        if(left < right) {
+            ++i;
+        }
+        else if(right < left) {
+            ++j;
+        }
+        else {
+            Container c = intersect(containers_[i], other.containers_[j]);
+            if(c.cardinality > 0)
+                result.containers_.append(c);
+            ++i;
+            ++j;
+        }
+    }
+
+    return result;
+}
+
+const SoundFileBitmap SoundFileBitmap::operator|(const SoundFileBitmap &other) const
+{
+    SoundFileBitmap result;
+    result.containers_.reserve(qMax(containers_.size(), other.containers_.size()));
+
+    int i = 0;
+    int j = 0;
+    while(i < containers_.size() || j < other.containers_.size()) {
+        if(j == other.containers_.size() || (i < containers_.size() && containers_[i].key < other.containers_[j].key)) {
+            result.containers_.append(containers_[i++]);
+        }
+        else if(i == containers_.size() || other.containers_[j].key < containers_[i].key) {
+            result.containers_.append(other.containers_[j++]);
+        }
+        else {
+            result.containers_.append(unite(containers_[i], other.containers_[j]));
+            ++i;
+            ++j;
+        }
+    }
+
+    return result;
+}
+
+const SoundFileBitmap SoundFileBitmap::andNot(const SoundFileBitmap &other) const
+{
+    SoundFileBitmap result;
+    result.containers_.reserve(containers_.size());
+
+    int j = 0;
+    foreach(Container const& c, containers_) {
+        while(j < other.containers_.size() && other.containers_[j].key < c.key)
+            ++j;
+
+        if(j == other.containers_.size() || other.containers_[j].key != c.key) {
+            result.containers_.append(c);
+            continue;
+        }
+
+        Container rest = subtract(c, other.containers_[j]);
+        if(rest.cardinality > 0)
+            result.containers_.append(rest);
+    }
+
+    return result;
+}
+
+SoundFileBitmap &SoundFileBitmap::operator|=(const SoundFileBitmap &other)
+{
+    *this = *this | other;
+    return *this;
+}
+
+bool SoundFileBitmap::operator==(const SoundFileBitmap &other) const
+{
+    if(containers_.size() != other.containers_.size())
+        return false;
+
+    // containers are normalized, so equal sets share storage kinds
+    for(int i = 0; i < containers_.size(); ++i) {
+        Container const& left = containers_[i];
+        Container const& right = other.containers_[i];
+        if(left.key != right.key || left.cardinality != right.cardinality)
+            return false;
+        if(left.array != right.array || left.bits != right.bits)
+            return false;
+    }
+
+    return true;
+}
+
+qint64 SoundFileBitmap::memoryUsage() const
+{
+    qint64 bytes = containers_.capacity() * sizeof(Container);
+
+    foreach(Container const& c, containers_) {
+        if(c.isBitmap())
+            bytes += VECTOR_OVERHEAD + c.bits.capacity() * sizeof(quint64);
+        else if(c.array.capacity() > 0)
+            bytes += VECTOR_OVERHEAD + c.array.capacity() * sizeof(quint16);
+    }
+
+    return bytes;
+}
+
+int SoundFileBitmap::findContainer(quint16 key) const
+{
+    int lo = 0;
+    int hi = containers_.size();
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        if(containers_[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+const SoundFileBitmap::Container SoundFileBitmap::intersect(const Container &left, const Container &right)
+{
+    Container c;
+    c.key = left.key;
+
+    if(left.isBitmap() && right.isBitmap()) {
+        c.bits.resize(BITMAP_WORDS);
+        for(int w = 0; w < BITMAP_WORDS; ++w) {
+            c.bits[w] = left.bits[w] & right.bits[w];
+            c.cardinality += qPopulationCount(c.bits[w]);
+        }
+        c.normalize();
+        return c;
+    }
+
+    // probe array entries against the other container
+    if(!left.isBitmap() && right.isBitmap()) {
+        foreach(quint16 low, left.array) {
+            if(right.contains(low))
+                c.array.append(low);
+        }
+    }
+    else if(left.isBitmap() && !right.isBitmap()) {
+        foreach(quint16 low, right.array) {
+            if(left.contains(low))
+                c.array.append(low);
+        }
+    }
+    else {
+        std::set_intersection(
+            left.array.begin(), left.array.end(),
+            right.array.begin(), right.array.end(),
+            std::back_inserter(c.array)
+        );
+    }
+
+    c.cardinality = c.array.size();
+    return c;
+}
+
+const SoundFileBitmap::Container SoundFileBitmap::unite(const Container &left, const Container &right)
+{
+    Container c;
+    c.key = left.key;
+
+    if(!left.isBitmap() && !right.isBitmap() && left.cardinality + right.cardinality <= ARRAY_MAX) {
+        c.array.reserve(left.cardinality + right.cardinality);
+        std::set_union(
+            left.array.begin(), left.array.end(),
+            right.array.begin(), right.array.end(),
+            std::back_inserter(c.array)
+        );
+        c.cardinality = c.array.size();
+        return c;
+    }
+
+    c.bits.fill(0, BITMAP_WORDS);
+    fillBits(left, c.bits);
+    fillBits(right, c.bits);
+    for(int w = 0; w < BITMAP_WORDS; ++w)
+        c.cardinality += qPopulationCount(c.bits[w]);
+    c.normalize();
+
+    return c;
+}
+
+const SoundFileBitmap::Container SoundFileBitmap::subtract(const Container &left, const Container &right)
+{
+    Container c;
+    c.key = left.key;
+
+    if(!left.isBitmap()) {
+        foreach(quint16 low, left.array) {
+            if(!right.contains(low))
+                c.array.append(low);
+        }
+        c.cardinality = c.array.size();
+        return c;
+    }
+
+    c.bits = left.bits;
+    if(right.isBitmap()) {
+        for(int w = 0; w < BITMAP_WORDS; ++w)
+            c.bits[w] &= ~right.bits[w];
+    }
+    else {
+        foreach(quint16 low, right.array)
+            c.bits[low >> 6] &= ~((quint64) 1 << (low & 63));
+    }
+
+    for(int w = 0; w < BITMAP_WORDS; ++w)
+        c.cardinality += qPopulationCount(c.bits[w]);
+    c.normalize();
+
+    return c;
+}
+
+void SoundFileBitmap::fillBits(const Container &c, QVector<quint64> &bits)
+{
+    if(c.isBitmap()) {
+        for(int w = 0; w < BITMAP_WORDS; ++w)
+            bits[w] |= c.bits[w];
+        return;
+    }
+
+    foreach(quint16 low, c.array)
+        bits[low >> 6] |= (quint64) 1 << (low & 63);
+}
@@ -0,0 +1,78 @@
+#ifndef DB_MODEL_SOUND_FILE_BITMAP_H
+#define DB_MODEL_SOUND_FILE_BITMAP_H
+
+#include <QVector>
+#include <QList>
+
+/*
+ * Compressed set of (non-negative) ids, roaring bitmap style.
+ * Ids are split into a 16 bit key and a 16 bit low part.
+ * Each key holds one container, which stores its low parts either as
+ * sorted array (sparse) or as 65536 bit bitmap (dense, > 4096 entries).
+ * Set operations work container by container, so cost is bound by
+ * the number of stored ids, not by the id range.
+*/
+class SoundFileBitmap
+{
+public:
+    SoundFileBitmap();
+
+    /* Builds set of given ids (any order, duplicates allowed) */
+    static SoundFileBitmap const fromList(QList<int> const& ids);
+
+    void add(int id);
+    void remove(int id);
+    bool contains(int id) const;
+
+    int cardinality() const;
+    bool isEmpty() const;
+    void clear();
+
+    /* Gets all ids, ascending */
+    QList<int> const toList() const;
+
+    /* Intersection, union and difference (this without other) */
+    SoundFileBitmap const operator&(SoundFileBitmap const& other) const;
+    SoundFileBitmap const operator|(SoundFileBitmap const& other) const;
+    SoundFileBitmap const andNot(SoundFileBitmap const& other) const;
+
+    SoundFileBitmap& operator|=(SoundFileBitmap const& other);
+
+    bool operator==(SoundFileBitmap const& other) const;
+
+    /* Approximate heap memory held by this set (bytes) */
+    qint64 memoryUsage() const;
+
+private:
+    struct Container {
+        Container();
+
+        bool isBitmap() const;
+        bool contains(quint16 low) const;
+        void add(quint16 low);
+        void remove(quint16 low);
+
+        /* Converts to array or bitmap storage, depending on cardinality */
+        void normalize();
+
+        quint16 key;
+        int cardinality;
+        QVector<quint16> array;   // sorted, used while cardinality <= ARRAY_MAX
+        QVector<quint64> bits;    // 1024 words, used above
+    };
+
+    /* Gets position of container with given key, or where it would be inserted */
+    int findContainer(quint16 key) const;
+
+    static Container const intersect(Container const& left, Container const& right);
+    static Container const unite(Container const& left, Container const& right);
+    static Container const subtract(Container const& left, Container const& right);
+
+    /* Sets bits of all entries of container in given 1024 word bitmap */
+    static void fillBits(Container const& c, QVector<quint64>& bits);
+
+    // containers ordered by key, none empty
+    QVector<Container> containers_;
+};
+
+#endif // DB_MODEL_SOUND_FILE_BITMAP_H
@@ -0,0 +1,424 @@
+#include "sound_file_paged_model.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+// number of rows read from db and announced to views at once
+static const int PAGE_SIZE = 256;
+
+// number of pages kept in memory
+static const int MAX_CACHED_PAGES = 16;
+
+SoundFilePagedModel::SoundFilePagedModel(DatabaseApi* api, QObject* parent)
+    : QAbstractTableModel(parent)
+    , api_(api)
+    , row_count_(0)
+    , fetched_rows_(0)
+    , page_size_(PAGE_SIZE)
+    , version_(-1)
+    , last_id_(0)
+    , update_pending_(false)
+    , pages_(MAX_CACHED_PAGES)
+    , page_after_ids_()
+{
+    if(api_ != 0) {
+        connect(api_, SIGNAL(tableChanged(TableIndex)),
+                this, SLOT(onTableChanged(TableIndex)));
+        connect(api_, SIGNAL(metadataUpdated(QList<int> const&)),
+                this, SLOT(onMetadataUpdated(QList<int> const&)));
+    }
+}
+
+SoundFilePagedModel::~SoundFilePagedModel()
+{}
+
+int SoundFilePagedModel::columnCount(const QModelIndex&) const
+{
+    return 2; // (id/path/), name
+}
+
+int SoundFilePagedModel::rowCount(const QModelIndex& parent) const
+{
+    if(parent.isValid())
+        return 0;
+
+    return fetched_rows_;
+}
+
+QVariant SoundFilePagedModel::data(const QModelIndex &index, int role) const
+{
+    if(!indexIsValid(index))
+        return QVariant();
+
+    Page* page = getPage(index.row() / page_size_);
+    int offset = index.row() % page_size_;
+    if(page == 0 || offset >= page->size())
+        return QVariant();
+
+    SoundFileRecord const& rec = page->at(offset).record;
+    qint64 duration_ms = page->at(offset).duration_ms;
+
+    if(index.column() == 0) {
+        if(role == Qt::DisplayRole)
+            return QVariant("");
+        else if(role == Qt::UserRole || role == Qt::EditRole)
+            return QVariant(rec.id);
+        else if(role == Qt::UserRole+1 || role == Qt::ToolTipRole)
+            return QVariant(rec.path);
+    }
+    else if(index.column() == 1) {
+        if(role == Qt::DisplayRole || role == Qt::EditRole)
+            return QVariant(rec.name);
+        else if(role == Qt::UserRole+2)
+            return QVariant(duration_ms);
+        else if(role == Qt::ToolTipRole) {
+            if(duration_ms <= 0)
+                return QVariant(rec.path);
+            QString length = QDateTime::fromTime_t(qRound(duration_ms/1000.0f)).toUTC().toString("mm:ss");
+            return QVariant(rec.path + " (" + length + ")");
+        }
+    }
+
+    return QVariant();
+}
+
+QVariant SoundFilePagedModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    // horizontal header (attribute names)
+    if(orientation == Qt::Horizontal) {
+        if(section < 0 || section >= columnCount())
+            return QVariant();
+
+        if(role == Qt::DisplayRole) {
+            if(section == 0)
+                return QVariant("Path");
+            else if(section == 1)
+                return QVariant("Name");
+        }
+    }
+
+    // vertical header (number of record)
+    else {
+        if(section < 0 || section >= rowCount())
+            return QVariant();
+        if(role == Qt::DisplayRole || role == Qt::EditRole)
+            return QVariant(section);
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags SoundFilePagedModel::flags(const QModelIndex &index) const
+{
+    if(!indexIsValid(index))
+        return Qt::ItemIsEnabled;
+
+    return QAbstractTableModel::flags(index) & (~Qt::ItemIsEditable);
+}
+
+bool SoundFilePagedModel::canFetchMore(const QModelIndex &parent) const
+{
+    if(parent.isValid())
+        return false;
+
+    return fetched_rows_ < row_count_;
+}
+
+void SoundFilePagedModel::fetchMore(const QModelIndex &parent)
+{
+    if(parent.isValid())
+        return;
+
+    int remaining = row_count_ - fetched_rows_;
+    if(remaining <= 0)
+        return;
+
+    int count = qMin(remaining, page_size_);
+    beginInsertRows(QModelIndex(), fetched_rows_, fetched_rows_ + count - 1);
+    fetched_rows_ += count;
+    endInsertRows();
+}
+
+void SoundFilePagedModel::select()
+{
+    if(api_ == 0) {
+        qDebug() << "FAILURE: cannot select SoundFilePagedModel";
+        qDebug() << " > (DB::Api*) api is null";
+        return;
+    }
+
+    beginResetModel();
+
+    version_ = api_->getTableVersion(SOUND_FILE);
+    row_count_ = api_->getSoundFileCount();
+    last_id_ = api_->getSoundFileMaxId();
+
+    clearPages();
+
+    fetched_rows_ = qMin(row_count_, page_size_);
+
+    endResetModel();
+}
+
+const SoundFileRecord SoundFilePagedModel::getSoundFileByRow(int row) const
+{
+    if(row < 0 || row >= row_count_)
+        return SoundFileRecord();
+
+    Page* page = getPage(row / page_size_);
+    int offset = row % page_size_;
+    if(page == 0 || offset >= page->size())
+        return SoundFileRecord();
+
+    return page->at(offset).record;
+}
+
+const SoundFileRecord SoundFilePagedModel::getSoundFileById(int id)
+{
+    if(api_ == 0)
+        return SoundFileRecord();
+
+    QList<QSqlRecord> rows = api_->getRecords(SOUND_FILE, QList<int>() << id);
+    if(rows.size() == 0)
+        return SoundFileRecord();
+
+    return SoundFileRecord(
+        rows[0].value("id").toInt(),
+        rows[0].value("name").toString(),
+        rows[0].value("path").toString(),
+        rows[0].value("relative_path").toString()
+    );
+}
+
+int SoundFilePagedModel::getRowById(int id)
+{
+    if(api_ == 0)
+        return -1;
+
+    return api_->getSoundFileRow(id);
+}
+
+void SoundFilePagedModel::setPageSize(int rows)
+{
+    if(rows < 1 || rows == page_size_)
+        return;
+
+    page_size_ = rows;
+
+    // page boundaries moved
+    if(version_ != -1)
+        select();
+}
+
+void SoundFilePagedModel::setMaxCachedPages(int pages)
+{
+    pages_.setMaxCost(qMax(1, pages));
+}
+
+void SoundFilePagedModel::update()
+{
+    update_pending_ = false;
+
+    if(api_ == 0)
+        return;
+
+    // nothing written since last refresh
+    int version = api_->getTableVersion(SOUND_FILE);
+    if(version == version_)
+        return;
+
+    QSet<int> ids;
+    if(!api_->getChangedIds(SOUND_FILE, version_, ids) || !applyChanges(ids)) {
+        select();
+        return;
+    }
+
+    version_ = version;
+}
+
+void SoundFilePagedModel::onMetadataUpdated(const QList<int> &ids)
+{
+    if(ids.size() == 0 || fetched_rows_ == 0)
+        return;
+
+    // cached pages hold outdated durations, rows and ids stay the same
+    pages_.clear();
+    emit dataChanged(index(0, 0), index(fetched_rows_ - 1, columnCount() - 1));
+}
+
+void SoundFilePagedModel::onTableChanged(TableIndex index)
+{
+    if(index != SOUND_FILE || update_pending_)
+        return;
+
+    // writes come in bursts (e.g. import batches), refresh once control returns to event loop
+    update_pending_ = true;
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+}
+
+bool SoundFilePagedModel::applyChanges(const QSet<int> &ids)
+{
+    QList<int> changed = ids.toList();
+    qSort(changed);
+
+    QSet<int> existing;
+    foreach(QSqlRecord const& row, api_->getRecords(SOUND_FILE, changed))
+        existing.insert(row.value("id").toInt());
+
+    // ids above last_id_ got inserted (at end of table), others existed before
+    QList<int> removed;
+    QList<int> updated;
+    QList<int> inserted;
+    foreach(int id, changed) {
+        if(existing.contains(id))
+            (id > last_id_ ? inserted : updated).append(id);
+        else if(id <= last_id_)
+            removed.append(id);
+    }
+
+    // ids reused by db (or log gaps) do not add up, can only be resolved by reselect
+    int row_count = api_->getSoundFileCount();
+    if(row_count_ - removed.size() + inserted.size() != row_count)
+        return false;
+
+    QList<int> known = removed + updated;
+    qSort(known);
+    QList<int> rows_before = api_->getSoundFileRows(known);
+
+    // rows before removal are rows in table now, plus removed ids preceding them
+    QList<int> removed_rows;
+    QList<int> updated_rows;
+    int removed_before = 0;
+    for(int i = 0; i < known.size(); ++i) {
+        if(removed_before < removed.size() && removed[removed_before] == known[i]) {
+            removed_rows.append(rows_before[i] + removed_before);
+            ++removed_before;
+        }
+        else {
+            updated_rows.append(rows_before[i]);
+        }
+    }
+
+    // all cached pages may have shifted
+    row_count_ -= removed.size();
+    clearPages();
+    removeFetchedRows(removed_rows);
+
+    bool all_fetched = fetched_rows_ == row_count_;
+
+    // new rows go last, announce them now if views reached the end already
+    if(inserted.size() > 0) {
+        row_count_ = row_count;
+        last_id_ = inserted.last();
+        clearPages();
+
+        if(all_fetched) {
+            int count = qMin(inserted.size(), page_size_);
+            beginInsertRows(QModelIndex(), fetched_rows_, fetched_rows_ + count - 1);
+            fetched_rows_ += count;
+            endInsertRows();
+        }
+    }
+
+    // updated rows keep their position, refresh contiguous runs of fetched ones
+    int i = 0;
+    while(i < updated_rows.size() && updated_rows[i] < fetched_rows_) {
+        int first = updated_rows[i];
+        int last = first;
+        while(i + 1 < updated_rows.size() && updated_rows[i + 1] == last + 1 && last + 1 < fetched_rows_) {
+            ++i;
+            ++last;
+        }
+        ++i;
+
+        emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+    }
+
+    return true;
+}
+
+void SoundFilePagedModel::removeFetchedRows(const QList<int> &rows)
+{
+    // contiguous runs, back to front so preceding rows keep their position
+    int i = rows.size() - 1;
+    while(i >= 0) {
+        int last = rows[i];
+        int first = last;
+        while(i > 0 && rows[i - 1] == first - 1) {
+            --i;
+            --first;
+        }
+        --i;
+
+        // rows not fetched yet have never been announced to views
+        last = qMin(last, fetched_rows_ - 1);
+        if(first > last)
+            continue;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        fetched_rows_ -= last - first + 1;
+        endRemoveRows();
+    }
+}
+
+void SoundFilePagedModel::clearPages()
+{
+    pages_.clear();
+
+    int page_count = (row_count_ + page_size_ - 1) / page_size_;
+    page_after_ids_.fill(-1, page_count);
+}
+
+SoundFilePagedModel::Page* SoundFilePagedModel::getPage(int page) const
+{
+    if(page < 0 || page >= page_after_ids_.size())
+        return 0;
+
+    Page* p = pages_.object(page);
+    if(p != 0)
+        return p;
+
+    int after_id = getPageStartAfterId(page);
+    if(after_id == -1)
+        return 0;
+
+    QList<QSqlRecord> rows = api_->getSoundFilePage(after_id, page_size_);
+
+    p = new Page;
+    p->reserve(rows.size());
+    foreach(QSqlRecord const& row, rows) {
+        Row r;
+        r.record = SoundFileRecord(
+            row.value(0).toInt(),
+            row.value(1).toString(),
+            row.value(2).toString(),
+            row.value(3).toString()
+        );
+        r.duration_ms = row.value(4).toLongLong();
+        p->append(r);
+    }
+
+    // remember where next page starts, spares seeking it by row
+    if(p->size() == page_size_ && page + 1 < page_after_ids_.size())
+        page_after_ids_[page + 1] = p->last().record.id;
+
+    pages_.insert(page, p);
+    return p;
+}
+
+int SoundFilePagedModel::getPageStartAfterId(int page) const
+{
+    // ids start at 1
+    if(page == 0)
+        return 0;
+
+    if(page_after_ids_[page] == -1)
+        page_after_ids_[page] = api_->getSoundFileIdAt(page * page_size_ - 1);
+
+    return page_after_ids_[page];
+}
+
+bool SoundFilePagedModel::indexIsValid(const QModelIndex & index) const
+{
+    return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
+}
@@ -0,0 +1,141 @@
+#ifndef DB_MODEL_SOUND_FILE_PAGED_MODEL_H
+#define DB_MODEL_SOUND_FILE_PAGED_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QSet>
+#include <QVector>
+
+#include "db/core/database_api.h"
+#include "db/table_records.h"
+
+/*
+ * Read-only model of the SoundFile database table,
+ * which never holds the whole table in memory.
+ * Rows are announced to views in windows (see canFetchMore/fetchMore)
+ * and read from db in pages on first access. Only a bounded number of
+ * pages is kept, least recently used pages get dropped.
+ * Ids and rows are resolved through the db index.
+ * Column 0 holds id (Qt::UserRole) and path (Qt::UserRole+1),
+ * column 1 holds the name and duration in ms (Qt::UserRole+2, 0 if unknown)
+ * (layout used by SoundListPlaybackView).
+ * Stored metadata (see DatabaseApi::metadataUpdated) refreshes fetched rows, without reset.
+ * Writes to SoundFile table are applied row by row from the db change log
+ * (rowsRemoved/rowsInserted/dataChanged), so views keep scroll position and selection.
+*/
+class SoundFilePagedModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit SoundFilePagedModel(DatabaseApi* api, QObject *parent = 0);
+    ~SoundFilePagedModel();
+
+    //// inheritted functions (from pure virtual BC) - see docs for description
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const;
+
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    bool canFetchMore(const QModelIndex &parent) const;
+
+    void fetchMore(const QModelIndex &parent);
+
+    //// end inheritted functions
+
+    /* Counts rows of SoundFile table and resets model to its first window **/
+    void select();
+
+    /*
+     * Gets SoundFileRecord at given row.
+     * Returns record with id -1 if row is invalid.
+    */
+    SoundFileRecord const getSoundFileByRow(int row) const;
+
+    /*
+     * Gets SoundFileRecord with given id, resolved through db.
+     * Returns record with id -1 if none found.
+    */
+    SoundFileRecord const getSoundFileById(int id);
+
+    /*
+     * Gets row of SoundFileRecord with given id.
+     * Returns -1 if none found.
+    */
+    int getRowById(int id);
+
+    /* Sets number of rows read from db (and announced to views) at once */
+    void setPageSize(int rows);
+
+    /* Sets number of pages kept in memory */
+    void setMaxCachedPages(int pages);
+
+public slots:
+    /*
+     * Applies rows of SoundFile table written since last refresh.
+     * Reselects model if changes are not known row by row.
+    */
+    void update();
+
+private slots:
+    void onTableChanged(TableIndex index);
+    void onMetadataUpdated(QList<int> const& ids);
+
+private:
+    struct Row {
+        SoundFileRecord record;
+        qint64 duration_ms;
+    };
+
+    typedef QVector<Row> Page;
+
+    /*
+     * Gets page with given number, reading it from db if not cached.
+     * Returns 0 if page is out of range.
+    */
+    Page* getPage(int page) const;
+
+    /* Gets id the page with given number starts after */
+    int getPageStartAfterId(int page) const;
+
+    /*
+     * Applies given ids written since last refresh onto rows.
+     * Returns false if they do not add up to current table, model needs a select then.
+    */
+    bool applyChanges(QSet<int> const& ids);
+
+    /* Announces removal of given rows (ascending), as far as fetched by views */
+    void removeFetchedRows(QList<int> const& rows);
+
+    /* Drops cached pages and page starts, after rows moved */
+    void clearPages();
+
+    /* validates existance of given QModelIndex for this model **/
+    bool indexIsValid(const QModelIndex&) const;
+
+    DatabaseApi* api_;
+
+    // rows in table, rows announced to views so far
+    int row_count_;
+    int fetched_rows_;
+
+    int page_size_;
+    int version_;
+
+    // highest id seen in table, ids above did not exist at last refresh
+    int last_id_;
+    bool update_pending_;
+
+    mutable QCache<int, Page> pages_;
+
+    // id each page starts after (-1 if not known yet), one entry per page
+    mutable QVector<int> page_after_ids_;
+};
+
+#endif // DB_MODEL_SOUND_FILE_PAGED_MODEL_H
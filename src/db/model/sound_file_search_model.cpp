@@ -0,0 +1,215 @@
+#include "sound_file_search_model.h"
+
+#include <QDebug>
+
+// maximum number of matches listed
+static const int SEARCH_LIMIT = 200;
+
+// pause in input (ms) awaited before searching
+static const int SEARCH_DELAY = 150;
+
+SoundFileSearchModel::SoundFileSearchModel(DatabaseApi* api, QObject* parent)
+    : QAbstractTableModel(parent)
+    , api_(api)
+    , query_()
+    , running_query_()
+    , limit_(SEARCH_LIMIT)
+    , search_pending_(false)
+    , delay_timer_(0)
+    , search_watcher_(0)
+    , matches_()
+{
+    delay_timer_ = new QTimer(this);
+    delay_timer_->setSingleShot(true);
+    delay_timer_->setInterval(SEARCH_DELAY);
+    connect(delay_timer_, SIGNAL(timeout()),
+            this, SLOT(search()));
+
+    search_watcher_ = new QFutureWatcher<QList<QSqlRecord> >(this);
+    connect(search_watcher_, SIGNAL(finished()),
+            this, SLOT(onSearchFinished()));
+
+    if(api_ != 0) {
+        connect(api_, SIGNAL(tableChanged(TableIndex)),
+                this, SLOT(onTableChanged(TableIndex)));
+    }
+}
+
+SoundFileSearchModel::~SoundFileSearchModel()
+{
+    search_watcher_->waitForFinished();
+}
+
+int SoundFileSearchModel::columnCount(const QModelIndex&) const
+{
+    return 2; // (id/path/), name
+}
+
+int SoundFileSearchModel::rowCount(const QModelIndex& parent) const
+{
+    if(parent.isValid())
+        return 0;
+
+    return matches_.size();
+}
+
+QVariant SoundFileSearchModel::data(const QModelIndex &index, int role) const
+{
+    if(!indexIsValid(index))
+        return QVariant();
+
+    SoundFileRecord const& rec = matches_[index.row()];
+
+    if(index.column() == 0) {
+        if(role == Qt::DisplayRole)
+            return QVariant("");
+        else if(role == Qt::UserRole || role == Qt::EditRole)
+            return QVariant(rec.id);
+        else if(role == Qt::UserRole+1 || role == Qt::ToolTipRole)
+            return QVariant(rec.path);
+    }
+    else if(index.column() == 1) {
+        if(role == Qt::DisplayRole || role == Qt::EditRole)
+            return QVariant(rec.name);
+        else if(role == Qt::ToolTipRole)
+            return QVariant(rec.path);
+    }
+
+    return QVariant();
+}
+
+QVariant SoundFileSearchModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    // horizontal header (attribute names)
+    if(orientation == Qt::Horizontal) {
+        if(section < 0 || section >= columnCount())
+            return QVariant();
+
+        if(role == Qt::DisplayRole) {
+            if(section == 0)
+                return QVariant("Path");
+            else if(section == 1)
+                return QVariant("Name");
+        }
+    }
+
+    // vertical header (rank of match)
+    else {
+        if(section < 0 || section >= rowCount())
+            return QVariant();
+        if(role == Qt::DisplayRole || role == Qt::EditRole)
+            return QVariant(section);
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags SoundFileSearchModel::flags(const QModelIndex &index) const
+{
+    if(!indexIsValid(index))
+        return Qt::ItemIsEnabled;
+
+    return QAbstractTableModel::flags(index) & (~Qt::ItemIsEditable);
+}
+
+const QString &SoundFileSearchModel::getQuery() const
+{
+    return query_;
+}
+
+void SoundFileSearchModel::setLimit(int limit)
+{
+    limit_ = qMax(1, limit);
+}
+
+void SoundFileSearchModel::setDelay(int ms)
+{
+    delay_timer_->setInterval(qMax(0, ms));
+}
+
+const SoundFileRecord SoundFileSearchModel::getSoundFileByRow(int row) const
+{
+    if(row < 0 || row >= matches_.size())
+        return SoundFileRecord();
+
+    return matches_[row];
+}
+
+void SoundFileSearchModel::setQuery(const QString &text)
+{
+    QString query = text.trimmed();
+    if(query == query_)
+        return;
+
+    query_ = query;
+
+    // nothing to wait for
+    if(query_.isEmpty()) {
+        delay_timer_->stop();
+        search();
+        return;
+    }
+
+    delay_timer_->start();
+}
+
+void SoundFileSearchModel::search()
+{
+    delay_timer_->stop();
+
+    if(api_ == 0)
+        return;
+
+    // search again once running search is done
+    if(search_watcher_->isRunning()) {
+        search_pending_ = true;
+        return;
+    }
+
+    search_pending_ = false;
+    running_query_ = query_;
+    search_watcher_->setFuture(api_->searchSoundFilesAsync(running_query_, limit_));
+}
+
+void SoundFileSearchModel::onSearchFinished()
+{
+    // query changed meanwhile, result is outdated
+    if(search_pending_) {
+        search();
+        return;
+    }
+
+    QList<QSqlRecord> rows = search_watcher_->result();
+
+    beginResetModel();
+
+    matches_.clear();
+    matches_.reserve(rows.size());
+    foreach(QSqlRecord const& row, rows) {
+        matches_.append(SoundFileRecord(
+            row.value(0).toInt(),
+            row.value(1).toString(),
+            row.value(2).toString(),
+            row.value(3).toString()
+        ));
+    }
+
+    endResetModel();
+
+    emit searched(running_query_, matches_.size());
+}
+
+void SoundFileSearchModel::onTableChanged(TableIndex index)
+{
+    if(index != SOUND_FILE && index != CATEGORY && index != SOUND_FILE_CATEGORY)
+        return;
+
+    // refresh listed matches, once writes have settled
+    if(!query_.isEmpty())
+        delay_timer_->start();
+}
+
+bool SoundFileSearchModel::indexIsValid(const QModelIndex & index) const
+{
+    return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
+}
@@ -0,0 +1,85 @@
+#ifndef DB_MODEL_SOUND_FILE_SEARCH_MODEL_H
+#define DB_MODEL_SOUND_FILE_SEARCH_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QVector>
+
+#include "db/core/database_api.h"
+#include "db/table_records.h"
+
+/*
+ * Read-only model listing best matches of a sound_file search (see DatabaseApi::searchSoundFiles).
+ * Meant to be fed while typing: setQuery() waits for a short pause in input,
+ * then searches on the database thread. Only one search runs at a time,
+ * input arriving meanwhile is searched once the running search is done.
+ * Column layout equals SoundFilePagedModel (used by SoundListPlaybackView).
+*/
+class SoundFileSearchModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit SoundFileSearchModel(DatabaseApi* api, QObject *parent = 0);
+    ~SoundFileSearchModel();
+
+    //// inheritted functions (from pure virtual BC) - see docs for description
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const;
+
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    //// end inheritted functions
+
+    QString const& getQuery() const;
+
+    /* Sets maximum number of matches listed */
+    void setLimit(int limit);
+
+    /* Sets pause in input (ms) awaited before searching */
+    void setDelay(int ms);
+
+    /*
+     * Gets SoundFileRecord at given row.
+     * Returns record with id -1 if row is invalid.
+    */
+    SoundFileRecord const getSoundFileByRow(int row) const;
+
+public slots:
+    /* Sets text to search for. Empty text clears model. */
+    void setQuery(QString const& text);
+
+    /* Searches for current query right away */
+    void search();
+
+signals:
+    /* triggered once matches for query have been filled in */
+    void searched(QString const& query, int matches);
+
+private slots:
+    void onSearchFinished();
+    void onTableChanged(TableIndex index);
+
+private:
+    /* validates existance of given QModelIndex for this model **/
+    bool indexIsValid(const QModelIndex&) const;
+
+    DatabaseApi* api_;
+    QString query_;
+    QString running_query_;
+    int limit_;
+    bool search_pending_;
+
+    QTimer* delay_timer_;
+    QFutureWatcher<QList<QSqlRecord> >* search_watcher_;
+    QVector<SoundFileRecord> matches_;
+};
+
+#endif // DB_MODEL_SOUND_FILE_SEARCH_MODEL_H
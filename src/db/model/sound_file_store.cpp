@@ -0,0 +1,312 @@
+#include "sound_file_store.h"
+
+#include "db/table_records.h"
+
+// approximate bookkeeping bytes of a heap allocation
+static const int MALLOC_OVERHEAD = 16;
+
+// approximate bytes of a QString besides its characters
+static const int STRING_OVERHEAD = sizeof(QArrayData) + MALLOC_OVERHEAD;
+
+// approximate bytes of a QHash node besides key and value
+static const int HASH_NODE_OVERHEAD = sizeof(void*) + sizeof(uint) + MALLOC_OVERHEAD;
+
+// released characters tolerated in name buffer before it gets rewritten
+static const int MIN_UNUSED_CHARS = 4096;
+
+SoundFileStore::SoundFileStore()
+    : rows_()
+    , dirs_()
+    , dir_lookup_()
+    , components_()
+    , component_lookup_()
+    , odd_relative_paths_()
+    , chars_()
+    , chars_unused_(0)
+{}
+
+int SoundFileStore::size() const
+{
+    return rows_.size();
+}
+
+void SoundFileStore::reserve(int rows)
+{
+    rows_.reserve(rows);
+}
+
+void SoundFileStore::clear()
+{
+    rows_.clear();
+    dirs_.clear();
+    dir_lookup_.clear();
+    components_.clear();
+    component_lookup_.clear();
+    odd_relative_paths_.clear();
+    chars_.clear();
+    chars_unused_ = 0;
+}
+
+void SoundFileStore::insert(int pos, int id, const QString &name, const QString &path, const QString &relative_path)
+{
+    Row row;
+    fillRow(row, id, name, path, relative_path);
+    rows_.insert(pos, row);
+}
+
+void SoundFileStore::append(int id, const QString &name, const QString &path, const QString &relative_path)
+{
+    insert(rows_.size(), id, name, path, relative_path);
+}
+
+void SoundFileStore::remove(int pos, int count)
+{
+    if(pos < 0 || count <= 0 || pos + count > rows_.size())
+        return;
+
+    for(int i = pos; i < pos + count; ++i)
+        releaseRow(rows_[i]);
+    rows_.remove(pos, count);
+
+    if(chars_unused_ > MIN_UNUSED_CHARS && chars_unused_ > chars_.size() / 2)
+        compactChars();
+}
+
+void SoundFileStore::remove(const QList<int> &positions)
+{
+    if(positions.size() == 0)
+        return;
+
+    // shift kept rows down over removed ones
+    int write = positions.first();
+    int next = 0;
+    for(int read = positions.first(); read < rows_.size(); ++read) {
+        if(next < positions.size() && positions[next] == read) {
+            releaseRow(rows_[read]);
+            ++next;
+            continue;
+        }
+        rows_[write++] = rows_[read];
+    }
+    rows_.resize(write);
+
+    if(chars_unused_ > MIN_UNUSED_CHARS && chars_unused_ > chars_.size() / 2)
+        compactChars();
+}
+
+bool SoundFileStore::set(int pos, int id, const QString &name, const QString &path, const QString &relative_path)
+{
+    if(this->id(pos) == id && this->name(pos) == name && this->path(pos) == path && relativePath(pos) == relative_path)
+        return false;
+
+    releaseRow(rows_[pos]);
+    fillRow(rows_[pos], id, name, path, relative_path);
+
+    return true;
+}
+
+int SoundFileStore::id(int pos) const
+{
+    return rows_[pos].id;
+}
+
+const QString SoundFileStore::name(int pos) const
+{
+    Row const& row = rows_[pos];
+    return chars_.mid(row.name_offset, row.name_length);
+}
+
+const QString SoundFileStore::path(int pos) const
+{
+    Row const& row = rows_[pos];
+    QString const& prefix = components_[dirs_[rootDir(row.dir)].component];
+    return prefix + storedRelativePath(row);
+}
+
+const QString SoundFileStore::relativePath(int pos) const
+{
+    Row const& row = rows_[pos];
+    if(odd_relative_paths_.size() > 0 && odd_relative_paths_.contains(row.id))
+        return odd_relative_paths_.value(row.id);
+    return storedRelativePath(row);
+}
+
+qint64 SoundFileStore::memoryUsage() const
+{
+    qint64 bytes = 0;
+
+    bytes += rows_.capacity() * sizeof(Row);
+    bytes += dirs_.capacity() * sizeof(DirNode);
+    bytes += chars_.capacity() * sizeof(QChar);
+
+    bytes += dir_lookup_.size() * (sizeof(quint64) + sizeof(int) + HASH_NODE_OVERHEAD);
+    bytes += dir_lookup_.capacity() * sizeof(void*);
+
+    foreach(QString const& component, components_)
+        bytes += sizeof(void*) + STRING_OVERHEAD + component.capacity() * sizeof(QChar);
+    bytes += component_lookup_.size() * (sizeof(QString) + sizeof(int) + HASH_NODE_OVERHEAD);
+    bytes += component_lookup_.capacity() * sizeof(void*);
+
+    foreach(QString const& rel_path, odd_relative_paths_)
+        bytes += sizeof(int) + sizeof(QString) + HASH_NODE_OVERHEAD + STRING_OVERHEAD + rel_path.capacity() * sizeof(QChar);
+
+    return bytes;
+}
+
+int SoundFileStore::dirCount() const
+{
+    return dirs_.size();
+}
+
+qint64 SoundFileStore::recordMemoryUsage() const
+{
+    qint64 bytes = 0;
+
+    for(int pos = 0; pos < rows_.size(); ++pos) {
+        // list slot and record allocation
+        bytes += sizeof(void*) + sizeof(SoundFileRecord) + MALLOC_OVERHEAD;
+
+        // name, path and relative path each hold an own string allocation
+        bytes += 3 * STRING_OVERHEAD;
+        bytes += (name(pos).size() + path(pos).size() + relativePath(pos).size() + 3) * sizeof(QChar);
+    }
+
+    return bytes;
+}
+
+void SoundFileStore::fillRow(Row &row, int id, const QString &name, const QString &path, const QString &relative_path)
+{
+    row.id = id;
+
+    // relative path has to be tail of path, so only the prefix needs storing
+    QString prefix;
+    QString rel_path;
+    if(path.endsWith(relative_path)) {
+        prefix = path.left(path.size() - relative_path.size());
+        rel_path = relative_path;
+    }
+    else {
+        rel_path = path;
+        odd_relative_paths_.insert(id, relative_path);
+    }
+
+    int dir = internDir(-1, internComponent(prefix));
+    QString file = rel_path;
+
+    int slash = rel_path.lastIndexOf('/');
+    if(slash != -1) {
+        file = rel_path.mid(slash + 1);
+        foreach(QString const& part, rel_path.left(slash).split('/'))
+            dir = internDir(dir, internComponent(part));
+    }
+
+    row.dir = dir;
+    row.name_offset = appendChars(name);
+    row.name_length = name.size();
+
+    if(file == name) {
+        row.file_offset = -1;
+        row.file_length = 0;
+    }
+    else {
+        row.file_offset = appendChars(file);
+        row.file_length = file.size();
+    }
+}
+
+void SoundFileStore::releaseRow(const Row &row)
+{
+    chars_unused_ += row.name_length + row.file_length;
+    if(odd_relative_paths_.size() > 0)
+        odd_relative_paths_.remove(row.id);
+}
+
+int SoundFileStore::appendChars(const QString &str)
+{
+    int offset = chars_.size();
+    chars_.append(str);
+    return offset;
+}
+
+void SoundFileStore::compactChars()
+{
+    QString chars;
+    chars.reserve(chars_.size() - chars_unused_);
+
+    for(int pos = 0; pos < rows_.size(); ++pos) {
+        Row& row = rows_[pos];
+
+        int offset = chars.size();
+        chars.append(chars_.midRef(row.name_offset, row.name_length));
+        row.name_offset = offset;
+
+        if(row.file_offset != -1) {
+            offset = chars.size();
+            chars.append(chars_.midRef(row.file_offset, row.file_length));
+            row.file_offset = offset;
+        }
+    }
+
+    chars_ = chars;
+    chars_unused_ = 0;
+}
+
+int SoundFileStore::internComponent(const QString &component)
+{
+    int idx = component_lookup_.value(component, -1);
+    if(idx != -1)
+        return idx;
+
+    idx = components_.size();
+    components_.append(component);
+    component_lookup_.insert(component, idx);
+    return idx;
+}
+
+int SoundFileStore::internDir(int parent, int component)
+{
+    quint64 key = ((quint64) (quint32) (parent + 1) << 32) | (quint32) component;
+
+    int idx = dir_lookup_.value(key, -1);
+    if(idx != -1)
+        return idx;
+
+    DirNode node;
+    node.parent = parent;
+    node.component = component;
+
+    idx = dirs_.size();
+    dirs_.append(node);
+    dir_lookup_.insert(key, idx);
+    return idx;
+}
+
+const QString SoundFileStore::storedRelativePath(const Row &row) const
+{
+    QString file = row.file_offset == -1
+            ? chars_.mid(row.name_offset, row.name_length)
+            : chars_.mid(row.file_offset, row.file_length);
+
+    // file directly in resource dir, without separator
+    if(dirs_[row.dir].parent == -1)
+        return file;
+
+    return dirPath(row.dir) + "/" + file;
+}
+
+const QString SoundFileStore::dirPath(int dir) const
+{
+    QStringList parts;
+    while(dirs_[dir].parent != -1) {
+        parts.prepend(components_[dirs_[dir].component]);
+        dir = dirs_[dir].parent;
+    }
+    return parts.join("/");
+}
+
+int SoundFileStore::rootDir(int dir) const
+{
+    while(dirs_[dir].parent != -1)
+        dir = dirs_[dir].parent;
+    return dir;
+}
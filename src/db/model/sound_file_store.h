@@ -0,0 +1,114 @@
+#ifndef DB_MODEL_SOUND_FILE_STORE_H
+#define DB_MODEL_SOUND_FILE_STORE_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/*
+ * Compact, value-typed storage of sound_file rows.
+ * Rows live in one contiguous array of small fixed-size entries.
+ * Paths are not stored as strings: a row references an interned directory node,
+ * which is either a resource directory prefix or a folder name below its parent node.
+ * File names share one character buffer.
+ * Full name, path and relative path are rebuilt on access.
+*/
+class SoundFileStore
+{
+public:
+    SoundFileStore();
+
+    int size() const;
+
+    void reserve(int rows);
+    void clear();
+
+    /*
+     * Inserts row at given position.
+     * relative_path has to be the tail of path (path = resource dir + relative_path).
+    */
+    void insert(int pos, int id, QString const& name, QString const& path, QString const& relative_path);
+    void append(int id, QString const& name, QString const& path, QString const& relative_path);
+
+    /* Removes count rows starting at pos */
+    void remove(int pos, int count = 1);
+
+    /* Removes rows at given positions (ascending, unique) in one pass */
+    void remove(QList<int> const& positions);
+
+    /* Sets values of row at pos. Returns true if any value changed. */
+    bool set(int pos, int id, QString const& name, QString const& path, QString const& relative_path);
+
+    int id(int pos) const;
+    QString const name(int pos) const;
+    QString const path(int pos) const;
+    QString const relativePath(int pos) const;
+
+    /* Approximate heap memory held by this store (bytes) */
+    qint64 memoryUsage() const;
+
+    /* Number of interned directory nodes */
+    int dirCount() const;
+
+    /*
+     * Approximate heap memory the same rows take as
+     * individually allocated SoundFileRecords (bytes).
+    */
+    qint64 recordMemoryUsage() const;
+
+private:
+    struct Row {
+        int id;
+        int dir;
+        int name_offset;
+        int name_length;
+        // file part of path, -1 offset if it equals name
+        int file_offset;
+        int file_length;
+    };
+
+    struct DirNode {
+        int parent;
+        int component;
+    };
+
+    /* Fills row from given values, interning path */
+    void fillRow(Row& row, int id, QString const& name, QString const& path, QString const& relative_path);
+
+    /* Marks characters held by row as unused */
+    void releaseRow(Row const& row);
+
+    /* Appends str to shared character buffer. Returns its offset. */
+    int appendChars(QString const& str);
+
+    /* Rewrites character buffer without released characters */
+    void compactChars();
+
+    int internComponent(QString const& component);
+    int internDir(int parent, int component);
+
+    /* Builds relative path of row from its dir node and file part */
+    QString const storedRelativePath(Row const& row) const;
+
+    /* Builds relative directory part of path for given dir node */
+    QString const dirPath(int dir) const;
+
+    /* Gets root node (resource dir prefix) of given dir node */
+    int rootDir(int dir) const;
+
+    QVector<Row> rows_;
+    QVector<DirNode> dirs_;
+    QHash<quint64, int> dir_lookup_;
+    QStringList components_;
+    QHash<QString, int> component_lookup_;
+
+    // relative paths, which are not the tail of their path (by id)
+    QHash<int, QString> odd_relative_paths_;
+
+    // shared buffer of names, chars_unused_ counts characters of removed rows
+    QString chars_;
+    int chars_unused_;
+};
+
+#endif // DB_MODEL_SOUND_FILE_STORE_H
@@ -1,14 +1,28 @@
 #include "sound_file_table_model.h"
 
-#include <QCoreApplication>
 #include <QDebug>
+#include <QSet>
+#include <QStringList>
+#include <QtAlgorithms>
+
+// number of separate row ranges removed at once, before views get reset instead
+static const int MAX_REMOVE_RUNS = 16;
 
 SoundFileTableModel::SoundFileTableModel(DatabaseApi* api, QObject* parent)
-    : QAbstractTableModel(parent)
+    : IdOrderedTableModel(parent)
     , api_(api)
-    , source_model_(0)
-    , records_()
-{}
+    , select_watcher_(0)
+    , select_pending_(false)
+    , store_()
+    , views_()
+    , path_hashes_()
+    , relative_path_hashes_()
+    , version_(-1)
+{
+    select_watcher_ = new QFutureWatcher<QList<QSqlRecord> >(this);
+    connect(select_watcher_, SIGNAL(finished()),
+            this, SLOT(onSelectFinished()));
+}
 
 SoundFileTableModel::~SoundFileTableModel()
 {
@@ -22,7 +36,7 @@ int SoundFileTableModel::columnCount(const QModelIndex&) const
 
 int SoundFileTableModel::rowCount(const QModelIndex&) const
 {
-    return records_.size();
+    return store_.size();
 }
 
 QVariant SoundFileTableModel::data(const QModelIndex &index, int role) const
@@ -32,15 +46,15 @@ QVariant SoundFileTableModel::data(const QModelIndex &index, int role) const
 
     if(role == Qt::DisplayRole) {
         if(index.column() == 0)
-            return QVariant(records_[index.row()]->name);
+            return QVariant(store_.name(index.row()));
         else if(index.column() == 1)
-            return QVariant(records_[index.row()]->path);
+            return QVariant(store_.path(index.row()));
     }
     else if(role == Qt::EditRole) {
         if(index.column() == 0)
-            return QVariant(records_[index.row()]->id);
+            return QVariant(store_.id(index.row()));
         else if(index.column() == 1)
-            return QVariant(records_[index.row()]->path);
+            return QVariant(store_.path(index.row()));
     }
 
     return QVariant();
@@ -111,33 +125,29 @@ bool SoundFileTableModel::removeColumns(int, int, const QModelIndex&)
 
 bool SoundFileTableModel::removeRow(int row, const QModelIndex&)
 {
-    if(row < 0)
+    if(row < 0 || row >= store_.size())
         return false;
 
-    // collect SOundFileRecord being deleted
-    SoundFileRecord* rec = getSoundFileByRow(row);
-    if(rec != 0) {
-
-        // signal deletion
-        emit aboutToBeDeleted(rec);
-        QCoreApplication::processEvents();
+    int id = store_.id(row);
 
-        // remove from source
-        if(!source_model_->removeRow(row, QModelIndex()))
-            return false;
+    // remove from db (along with category relations),
+    // views are only told about deletions that happened
+    if(!api_->deleteSoundFiles(QList<int>() << id))
+        return false;
 
-        // remove from storage & delete pointer
-        records_.removeAt(row);
-        delete rec;
-        rec = 0;
+    // signal deletion
+    emit aboutToBeDeleted(getView(row));
 
-        // call super class function
-        QAbstractTableModel::removeRow(row, QModelIndex());
+    // remove from storage & indexes
+    beginRemoveRows(QModelIndex(), row, row);
+    unindexRow(row);
+    store_.remove(row);
+    endRemoveRows();
 
-        return true;
-    }
+    // delete pointer
+    releaseView(id);
 
-    return false;
+    return true;
 }
 
 bool SoundFileTableModel::removeRows(int row, int count, const QModelIndex&)
@@ -145,39 +155,33 @@ bool SoundFileTableModel::removeRows(int row, int count, const QModelIndex&)
     if(count < 0 || row < 0)
         return false;
 
-    if(row < records_.size() && row+count < records_.size()) {
+    if(row < store_.size() && row+count < store_.size()) {
 
-        // collect all SoundFileRecords being deleted
-        QList<SoundFileRecord*> recs;
-        for(int i = row; i <= row+count; ++i) {
-            SoundFileRecord* rec = getSoundFileByRow(i);
-            if(rec == 0)
-                return false;
-            recs.append(rec);
-        }
-
-        // signal deletion
-        emit aboutToBeDeleted(recs);
-        QCoreApplication::processEvents();
+        QList<int> ids;
+        for(int i = row; i <= row+count; ++i)
+            ids.append(store_.id(i));
 
-        // remove from source model
-        if(!source_model_->removeRows(row, count, QModelIndex()))
+        // remove from db (along with category relations),
+        // views are only told about deletions that happened
+        if(!api_->deleteSoundFiles(ids))
             return false;
 
-        // remove from storage
-        for(int i = row+count; i >= row; --i)
-            records_.removeAt(i);
+        // collect all SoundFileRecords being deleted & signal deletion
+        QList<SoundFileRecord*> recs;
+        for(int i = row; i <= row+count; ++i)
+            recs.append(getView(i));
+        emit aboutToBeDeleted(recs);
 
-        // delete pointers
-        while(recs.size() > 0) {
-            SoundFileRecord* rec = recs.first();
-            delete rec;
-            rec = 0;
-            recs.pop_front();
-        }
+        // remove from storage & indexes
+        beginRemoveRows(QModelIndex(), row, row+count);
+        for(int i = row; i <= row+count; ++i)
+            unindexRow(i);
+        store_.remove(row, count+1);
+        endRemoveRows();
 
-        // call super class function
-        QAbstractTableModel::removeRows(row, count, QModelIndex());
+        // delete pointers
+        foreach(int id, ids)
+            releaseView(id);
 
         return true;
     }
@@ -187,7 +191,11 @@ bool SoundFileTableModel::removeRows(int row, int count, const QModelIndex&)
 
 void SoundFileTableModel::update()
 {
-    select();
+    if(api_ == 0)
+        return;
+
+    waitForSelect();
+    mergeChanges(api_, SOUND_FILE, version_);
 }
 
 void SoundFileTableModel::select()
@@ -198,88 +206,149 @@ void SoundFileTableModel::select()
         return;
     }
 
-    if(records_.size() > 0)
-        clear();
+    // rows get filled in by onSelectFinished(), once db thread is done
+    version_ = api_->getTableVersion(SOUND_FILE);
+    select_pending_ = true;
+    select_watcher_->setFuture(api_->getSoundFileTableAsync());
+}
 
-    source_model_ = api_->getSoundFileTable();
+bool SoundFileTableModel::isSelecting() const
+{
+    return select_pending_;
+}
 
-    int c_id = source_model_->fieldIndex("id");
-    int c_name = source_model_->fieldIndex("name");
-    int c_path = source_model_->fieldIndex("path");
-    int c_rel_path = source_model_->fieldIndex("relative_path");
-    for(int row = 0; row < source_model_->rowCount(); ++row) {
-        SoundFileRecord* rec = new SoundFileRecord;
+void SoundFileTableModel::waitForSelect()
+{
+    if(!select_pending_)
+        return;
 
-        // set id
-        QModelIndex index = source_model_->index(row, c_id);
-        rec->id = source_model_->data(index).toInt();
+    select_watcher_->waitForFinished();
+    onSelectFinished();
+}
 
-        // set name
-        index = source_model_->index(row, c_name);
-        rec->name = source_model_->data(index).toString();
+void SoundFileTableModel::onSelectFinished()
+{
+    // result may already have been applied by waitForSelect()
+    if(!select_pending_)
+        return;
+    select_pending_ = false;
 
-        // set path
-        index = source_model_->index(row, c_path);
-        rec->path = source_model_->data(index).toString();
+    QList<QSqlRecord> rows = select_watcher_->result();
 
-        // set relative path
-        index = source_model_->index(row, c_rel_path);
-        rec->relative_path = source_model_->data(index).toString();
+    beginResetModel();
 
-        // add to list of records
-        records_.append(rec);
+    if(store_.size() > 0)
+        clear();
+
+    if(rows.size() > 0) {
+        int c_id = rows[0].indexOf("id");
+        int c_name = rows[0].indexOf("name");
+        int c_path = rows[0].indexOf("path");
+        int c_rel_path = rows[0].indexOf("relative_path");
+
+        store_.reserve(rows.size());
+        path_hashes_.reserve(rows.size());
+        relative_path_hashes_.reserve(rows.size());
+        foreach(QSqlRecord const& row, rows) {
+            int id = row.value(c_id).toInt();
+            QString path = row.value(c_path).toString();
+            QString rel_path = row.value(c_rel_path).toString();
+
+            store_.append(id, row.value(c_name).toString(), path, rel_path);
+            indexRow(id, path, rel_path);
+        }
     }
 
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
-    emit dataChanged(index(0,0), index(rowCount(), columnCount()));
+    endResetModel();
+
+    logMemoryReport();
+
+    emit selected();
 }
 
 int SoundFileTableModel::getRowBySoundFile(SoundFileRecord *rec)
 {
-    for(int row = 0; row < records_.size(); ++row) {
-        if(records_[row] == rec)
-            return row;
-    }
-    return -1;
+    waitForSelect();
+
+    // only records handed out by this model have a row
+    if(rec == 0 || views_.value(rec->id, 0) != rec)
+        return -1;
+
+    return findRow(rec->id);
 }
 
 SoundFileRecord *SoundFileTableModel::getSoundFileByPath(const QString &path)
 {
-    foreach(SoundFileRecord* rec, records_) {
-        if(rec->path.compare(path) == 0)
-            return rec;
-    }
-
-    return 0;
+    waitForSelect();
+    return getView(findRowByPath(path));
 }
 
 SoundFileRecord *SoundFileTableModel::getSoundFileById(int id)
 {
-    foreach(SoundFileRecord* rec, records_) {
-        if(rec->id == id)
-            return rec;
-    }
+    waitForSelect();
+    return getView(findRow(id));
+}
 
-    return 0;
+const QList<SoundFileRecord> SoundFileTableModel::getSoundFilesByIds(const QList<int> &ids)
+{
+    waitForSelect();
+
+    QList<SoundFileRecord> recs;
+    recs.reserve(ids.size());
+    foreach(int id, ids) {
+        int row = findRow(id);
+        if(row != -1)
+            recs.append(SoundFileRecord(id, store_.name(row), store_.path(row), store_.relativePath(row)));
+    }
+    return recs;
 }
 
 SoundFileRecord *SoundFileTableModel::getSoundFileByRow(int row)
 {
-    if(row < rowCount())
-        return records_[row];
-
-    return 0;
+    return getView(row);
 }
 
 QList<SoundFileRecord *> const SoundFileTableModel::getSoundFilesByRelativePath(const QString &rel_path)
 {
-    QList<SoundFileRecord*> sound_files;
-    foreach(SoundFileRecord* rec, records_) {
-        if(rec->relative_path.compare(rel_path) == 0)
-            sound_files.append(rec);
+    waitForSelect();
+
+    // keep row order, so callers picking the first match stay deterministic
+    QList<int> rows;
+    foreach(int id, relative_path_hashes_.values(qHash(rel_path))) {
+        int row = findRow(id);
+        if(row != -1 && store_.relativePath(row) == rel_path)
+            rows.append(row);
     }
-    return sound_files;
+    qSort(rows);
+
+    QList<SoundFileRecord*> recs;
+    foreach(int row, rows)
+        recs.append(getView(row));
+    return recs;
+}
+
+QList<SoundFileRecord *> const SoundFileTableModel::getSoundFilesByFingerprint(const QString &fingerprint)
+{
+    QList<SoundFileRecord*> recs;
+    if(api_ == 0 || fingerprint.isEmpty())
+        return recs;
+
+    waitForSelect();
+    foreach(int id, api_->getSoundFileIdsByFingerprint(fingerprint)) {
+        SoundFileRecord* rec = getView(findRow(id));
+        if(rec != 0)
+            recs.append(rec);
+    }
+
+    return recs;
+}
+
+const QString SoundFileTableModel::getFingerprintById(int id) const
+{
+    if(api_ == 0)
+        return QString();
+
+    return api_->getSoundFileFingerprint(id);
 }
 
 SoundFileRecord *SoundFileTableModel::getLastSoundFileRecord()
@@ -304,41 +373,127 @@ void SoundFileTableModel::addSoundFileRecord(const QFileInfo& info, const Resour
         return;
     }
 
-    api_->insertSoundFile(info, resource_dir);
-
-    int id = api_->getSoundFileId(info.filePath());
-    if(id == -1) {
+    if(addSoundFileRecords(QList<QFileInfo>() << info, resource_dir).size() == 0) {
         qDebug() << "FAILURE: Unknown error adding SoundFileRecord";
         qDebug() << " > path:" << info.filePath();
-        return;
+    }
+}
+
+const QList<SoundFileRecord *> SoundFileTableModel::addSoundFileRecords(const QList<QFileInfo> &infos, const ResourceDirRecord &resource_dir,
+                                                                        const QList<int> &category_ids)
+{
+    QList<SoundFileRecord*> added;
+
+    // a pending select would otherwise drop records added below
+    waitForSelect();
+
+    // filter batch against known paths and duplicates within batch
+    QSet<QString> batch_paths;
+    batch_paths.reserve(infos.size());
+    QList<QFileInfo> new_infos;
+    QList<int> new_category_ids;
+    for(int i = 0; i < infos.size(); ++i) {
+        QString path = infos[i].filePath();
+        if(batch_paths.contains(path) || !path.startsWith(resource_dir.path) || findRowByPath(path) != -1)
+            continue;
+        batch_paths.insert(path);
+        new_infos.append(infos[i]);
+        new_category_ids.append(i < category_ids.size() ? category_ids[i] : -1);
     }
 
-    QString rel_path = info.filePath();
-    rel_path.remove(0, resource_dir.path.size());
+    if(new_infos.size() == 0)
+        return added;
 
-    records_.append(new SoundFileRecord(id, info.fileName(), info.filePath(), rel_path));
+    QList<int> ids = api_->insertSoundFiles(new_infos, resource_dir, new_category_ids);
+    if(ids.size() != new_infos.size()) {
+        qDebug() << "FAILURE: could not insert SoundFileRecord batch";
+        qDebug() << " > batch size:" << new_infos.size();
+        return added;
+    }
 
-    emit layoutAboutToBeChanged();
-    emit layoutChanged();
+    // new ids are highest, so rows go last
+    int first = store_.size();
+    beginInsertRows(QModelIndex(), first, first + new_infos.size() - 1);
+    for(int i = 0; i < new_infos.size(); ++i) {
+        QString path = new_infos[i].filePath();
+        QString rel_path = path;
+        rel_path.remove(0, resource_dir.path.size());
+
+        store_.append(ids[i], new_infos[i].fileName(), path, rel_path);
+        indexRow(ids[i], path, rel_path);
+    }
+    endInsertRows();
+
+    for(int row = first; row < store_.size(); ++row)
+        added.append(getView(row));
+
+    return added;
 }
 
-const QList<SoundFileRecord *> &SoundFileTableModel::getSoundFiles() const
+const QList<SoundFileRecord> SoundFileTableModel::getSoundFiles() const
 {
-    return records_;
+    QList<SoundFileRecord> recs;
+    recs.reserve(store_.size());
+    for(int row = 0; row < store_.size(); ++row)
+        recs.append(SoundFileRecord(store_.id(row), store_.name(row), store_.path(row), store_.relativePath(row)));
+    return recs;
 }
 
-void SoundFileTableModel::deleteSoundFile(int id)
+bool SoundFileTableModel::deleteSoundFiles(const QList<int> &ids)
 {
-    SoundFileRecord* rec = getSoundFileById(id);
-    if(rec == 0)
-        return;
+    waitForSelect();
 
-    int row = getRowBySoundFile(rec);
+    QList<int> unique_ids = ids.toSet().toList();
+    if(unique_ids.size() == 0)
+        return true;
+
+    QList<int> rows;
+    foreach(int id, unique_ids) {
+        int row = findRow(id);
+        if(row != -1)
+            rows.append(row);
+    }
+    qSort(rows);
+
+    // views are only told about deletions that happened
+    if(!api_->deleteSoundFiles(unique_ids))
+        return false;
+
+    // signal deletion once for whole set
+    if(rows.size() > 0) {
+        QList<SoundFileRecord*> recs;
+        foreach(int row, rows)
+            recs.append(getView(row));
+        emit aboutToBeDeleted(recs);
+    }
+
+    removeStoredRows(rows);
+    return true;
+}
+
+void SoundFileTableModel::deleteSoundFile(int id)
+{
+    int row = findRow(id);
 
     if(row != -1)
         removeRow(row);
 }
 
+void SoundFileTableModel::logMemoryReport() const
+{
+    qint64 store_bytes = store_.memoryUsage();
+    qint64 record_bytes = store_.recordMemoryUsage();
+
+    qDebug() << "NOTIFICATION: SoundFileTableModel memory report";
+    qDebug() << " > rows:" << store_.size();
+    qDebug() << " > interned directories:" << store_.dirCount();
+    qDebug() << " > record store (KiB):" << store_bytes / 1024;
+    qDebug() << " > same rows as SoundFileRecords (KiB):" << record_bytes / 1024;
+    if(store_bytes > 0)
+        qDebug() << " > ratio:" << (double) record_bytes / store_bytes;
+    qDebug() << " > materialized SoundFileRecords:" << views_.size();
+}
+
 bool SoundFileTableModel::indexIsValid(const QModelIndex & index) const
 {
     return index.isValid() && index.row() < rowCount() && index.column() < columnCount();
@@ -346,9 +501,146 @@ bool SoundFileTableModel::indexIsValid(const QModelIndex & index) const
 
 void SoundFileTableModel::clear()
 {
-    while(records_.size() > 0) {
-        SoundFileRecord* rec = records_.front();
-        records_.pop_front();
-        delete rec;
+    path_hashes_.clear();
+    relative_path_hashes_.clear();
+
+    qDeleteAll(views_);
+    views_.clear();
+
+    store_.clear();
+}
+
+SoundFileRecord *SoundFileTableModel::getView(int row)
+{
+    if(row < 0 || row >= store_.size())
+        return 0;
+
+    int id = store_.id(row);
+    SoundFileRecord* rec = views_.value(id, 0);
+    if(rec == 0) {
+        rec = new SoundFileRecord(id, store_.name(row), store_.path(row), store_.relativePath(row));
+        views_.insert(id, rec);
+    }
+
+    return rec;
+}
+
+void SoundFileTableModel::releaseView(int id)
+{
+    SoundFileRecord* rec = views_.take(id);
+    delete rec;
+}
+
+int SoundFileTableModel::findRowByPath(const QString &path) const
+{
+    foreach(int id, path_hashes_.values(qHash(path))) {
+        int row = findRow(id);
+        if(row != -1 && store_.path(row) == path)
+            return row;
+    }
+    return -1;
+}
+
+void SoundFileTableModel::indexRow(int id, const QString &path, const QString &rel_path)
+{
+    path_hashes_.insert(qHash(path), id);
+    relative_path_hashes_.insert(qHash(rel_path), id);
+}
+
+void SoundFileTableModel::unindexRow(int row)
+{
+    int id = store_.id(row);
+    path_hashes_.remove(qHash(store_.path(row)), id);
+    relative_path_hashes_.remove(qHash(store_.relativePath(row)), id);
+}
+
+int SoundFileTableModel::rowId(int row) const
+{
+    return store_.id(row);
+}
+
+bool SoundFileTableModel::updateRow(int row, const QSqlRecord &values)
+{
+    int id = store_.id(row);
+    QString name = values.value("name").toString();
+    QString path = values.value("path").toString();
+    QString rel_path = values.value("relative_path").toString();
+
+    if(store_.name(row) == name && store_.path(row) == path && store_.relativePath(row) == rel_path)
+        return false;
+
+    unindexRow(row);
+    store_.set(row, id, name, path, rel_path);
+    indexRow(id, path, rel_path);
+
+    // records handed out stay valid, update them in place
+    SoundFileRecord* rec = views_.value(id, 0);
+    if(rec != 0) {
+        rec->name = name;
+        rec->path = path;
+        rec->relative_path = rel_path;
+    }
+
+    return true;
+}
+
+void SoundFileTableModel::insertRecords(int row, const QList<QSqlRecord> &rows)
+{
+    for(int i = 0; i < rows.size(); ++i) {
+        int id = rows[i].value("id").toInt();
+        QString path = rows[i].value("path").toString();
+        QString rel_path = rows[i].value("relative_path").toString();
+
+        store_.insert(row + i, id, rows[i].value("name").toString(), path, rel_path);
+        indexRow(id, path, rel_path);
     }
 }
+
+void SoundFileTableModel::removeDeletedRows(const QList<int> &rows)
+{
+    // rows are gone from db already (see mergeChanges)
+    QList<SoundFileRecord*> recs;
+    foreach(int row, rows)
+        recs.append(getView(row));
+    emit aboutToBeDeleted(recs);
+
+    removeStoredRows(rows);
+}
+
+void SoundFileTableModel::eraseRows(int first, int count)
+{
+    for(int row = first; row < first + count; ++row)
+        unindexRow(row);
+    store_.remove(first, count);
+}
+
+void SoundFileTableModel::removeStoredRows(const QList<int> &rows)
+{
+    if(rows.size() == 0)
+        return;
+
+    QList<int> ids;
+    ids.reserve(rows.size());
+    int runs = 1;
+    for(int i = 0; i < rows.size(); ++i) {
+        ids.append(store_.id(rows[i]));
+        if(i > 0 && rows[i] != rows[i - 1] + 1)
+            ++runs;
+    }
+
+    // scattered rows are cheaper to announce as one reset than run by run
+    if(runs > MAX_REMOVE_RUNS) {
+        beginResetModel();
+        foreach(int row, rows)
+            unindexRow(row);
+        store_.remove(rows);
+        endResetModel();
+    }
+    else {
+        // contiguous runs, back to front so preceding rows keep their position
+        removeRowRuns(rows);
+    }
+
+    foreach(int id, ids)
+        releaseView(id);
+}
@@ -1,16 +1,23 @@
 #ifndef DB_MODEL_SOUND_FILE_TABLE_MODEL_H
 #define DB_MODEL_SOUND_FILE_TABLE_MODEL_H
 
-#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
 #include "db/core/database_api.h"
 #include "db/table_records.h"
+#include "db/model/sound_file_store.h"
+#include "db/model/id_ordered_table_model.h"
 
 /*
  * Class derived from QAbstractTableModel.
  * Builds a tablemodel based on the sound_file db table of this application.
  * Provides convenience functions for accessing & managing SoundFileRecords maintained by it.
+ * Rows are held in a compact SoundFileStore. SoundFileRecords are only created
+ * when requested and stay valid (and up to date) until their row gets removed.
 */
-class SoundFileTableModel : public QAbstractTableModel
+class SoundFileTableModel : public IdOrderedTableModel
 {
     Q_OBJECT
 public:
@@ -49,12 +56,31 @@ public:
 
     //// end inheritted functions
 
-    /* Update model with data from db */
+    /*
+     * Update model with data from db.
+     * Only rows written since last refresh are re-read and
+     * signaled (rowsInserted/rowsRemoved/dataChanged), so views keep their state.
+     * Does nothing if table is unchanged.
+    */
     void update();
 
-    /* Fills model with data from SoundFile database table **/
+    /*
+     * Fills model with data from SoundFile database table.
+     * Rows are selected on the database thread and filled in
+     * asynchronously. Signals selected() once done.
+    */
     void select();
 
+    /* Returns true while a select is pending **/
+    bool isSelecting() const;
+
+    /*
+     * Blocks until pending select is done and fills in its rows.
+     * Returns immediately if no select is pending.
+     * Lookups and additions call this, so they never see a half-filled model.
+    */
+    void waitForSelect();
+
     /*
      * Gets the row of SoundFileRecord.
      * Returns -1 if none found
@@ -73,6 +99,12 @@ public:
     */
     SoundFileRecord* getSoundFileById(int id);
 
+    /*
+     * Gets copies of SoundFileRecords with given ids, skipping unknown ids.
+     * Does not materialize records held by this model, prefer for bulk lookups.
+    */
+    QList<SoundFileRecord> const getSoundFilesByIds(QList<int> const& ids);
+
     /*
      * Gets SoundFileRecord based on row.
      * Returns 0 if none found.
@@ -85,6 +117,15 @@ public:
     */
     QList<SoundFileRecord*> const getSoundFilesByRelativePath(QString const& rel_path);
 
+    /*
+     * Gets all SoundFileRecords with given content fingerprint
+     * (see Resources::PathFixer::computeFingerprint), ordered by id.
+    */
+    QList<SoundFileRecord*> const getSoundFilesByFingerprint(QString const& fingerprint);
+
+    /* Gets content fingerprint of SoundFile with given id, empty if not known (yet) */
+    QString const getFingerprintById(int id) const;
+
     /*
      * Gets last SoundFileRecord in the model.
      * Returns 0 if none found.
@@ -100,30 +141,110 @@ public:
     );
 
     /*
-    * Returns all SoundFileRecords held by this model
+    * Adds SoundFileRecords for all given files as one batch.
+    * Files already held by this model, duplicates within infos and
+    * files outside of resource_dir will be skipped.
+    * Writes the batch in a single transaction and notifies views once,
+    * relating each file to the category given at same index of category_ids
+    * (-1 for none, may be empty) within that transaction.
+    * Returns all SoundFileRecords that have been added.
+    */
+    QList<SoundFileRecord*> const addSoundFileRecords(
+        const QList<QFileInfo>& infos,
+        const ResourceDirRecord& resource_dir,
+        const QList<int>& category_ids = QList<int>()
+    );
+
+    /*
+    * Returns copies of all SoundFileRecords held by this model.
+    * Copies every row, prefer row based access for large tables.
+    */
+    QList<SoundFileRecord> const getSoundFiles() const;
+
+    /* Logs memory held by rows of this model, compared to plain SoundFileRecords */
+    void logMemoryReport() const;
+
+    /*
+     * Deletes SoundFileRecords with given ids (and their category relations)
+     * from db in one transaction. Signals aboutToBeDeleted once for the whole set,
+     * views get one removal per contiguous range of rows, or a reset if ranges are many.
+     * Returns success.
     */
-    QList<SoundFileRecord*> const& getSoundFiles() const;
+    bool deleteSoundFiles(QList<int> const& ids);
 
 public slots:
     void deleteSoundFile(int id);
 
 signals:
-    /* triggered and processed before SoundFileRecord gets deleted */
+    /* triggered once deleted from db, processed before SoundFileRecord gets removed from model */
     void aboutToBeDeleted(SoundFileRecord*);
 
-    /* triggered and processed before SoundFileRecords get deleted */
+    /* triggered once deleted from db, processed before SoundFileRecords get removed from model */
     void aboutToBeDeleted(const QList<SoundFileRecord*>&);
 
+    /* triggered once rows of a select() have been filled in */
+    void selected();
+
+private slots:
+    void onSelectFinished();
+
 private:
     /* validates existance of given QModelIndex for this model **/
     bool indexIsValid(const QModelIndex&) const;
 
-    /* Clears all SoundFileRecords from records **/
+    /* Clears all rows and deletes all SoundFileRecords handed out **/
     void clear();
 
+    /*
+     * Gets SoundFileRecord for given row, creating it if needed.
+     * Returns 0 if row is invalid.
+    */
+    SoundFileRecord* getView(int row);
+
+    /* Deletes SoundFileRecord handed out for given id (if any) **/
+    void releaseView(int id);
+
+    /* Gets row with given path. Returns -1 if none found. */
+    int findRowByPath(QString const& path) const;
+
+    /* Adds row with given values to path lookups **/
+    void indexRow(int id, QString const& path, QString const& rel_path);
+
+    /* Removes given row from path lookups **/
+    void unindexRow(int row);
+
+    /*
+     * Removes rows at given positions (ascending) from store, lookups and views
+     * and deletes SoundFileRecords handed out for them. Does not touch db.
+    */
+    void removeStoredRows(QList<int> const& rows);
+
+    //// IdOrderedTableModel functions - see base class for description
+
+    int rowId(int row) const;
+
+    bool updateRow(int row, QSqlRecord const& values);
+
+    void insertRecords(int row, QList<QSqlRecord> const& rows);
+
+    void removeDeletedRows(QList<int> const& rows);
+
+    void eraseRows(int first, int count);
+
     DatabaseApi* api_;
-    QSqlRelationalTableModel* source_model_;
-    QList<SoundFileRecord*> records_;
+    QFutureWatcher<QList<QSqlRecord> >* select_watcher_;
+    bool select_pending_;
+    SoundFileStore store_;
+
+    // SoundFileRecords handed out so far (by id)
+    QHash<int, SoundFileRecord*> views_;
+
+    // qHash of path/relative path -> id, hits get verified against store_
+    QMultiHash<uint, int> path_hashes_;
+    QMultiHash<uint, int> relative_path_hashes_;
+
+    // version of sound_file table store_ reflects
+    int version_;
 };
 
 #endif // DB_MODEL_SOUND_FILE_TABLE_MODEL_H
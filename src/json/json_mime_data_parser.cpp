@@ -181,6 +181,10 @@ const QJsonObject JsonMimeDataParser::toJsonObject(const PlaylistSettings& setti
     obj.insert("min_interval_val", QJsonValue(settings.min_delay_interval));
     obj.insert("max_interval_val", QJsonValue(settings.max_delay_interval));
     obj.insert("volume", QJsonValue(settings.volume));
+    obj.insert("no_repeat_count", QJsonValue(settings.no_repeat_count));
+    obj.insert("fade_in", QJsonValue(settings.fade_in_duration));
+    obj.insert("fade_out", QJsonValue(settings.fade_out_duration));
+    obj.insert("crossfade", QJsonValue(settings.crossfade_duration));
 
     return obj;
 
@@ -236,6 +240,20 @@ PlaylistSettings* JsonMimeDataParser::toPlaylistSettings(const QJsonObject& obj)
         set->order = WEIGHTED;
     }
 
+    // optional, missing in files of earlier versions
+    if(obj["no_repeat_count"].isDouble() && obj["no_repeat_count"].toInt() >= 0) {
+        set->no_repeat_count = obj["no_repeat_count"].toInt();
+    }
+    if(obj["fade_in"].isDouble() && obj["fade_in"].toInt() >= 0) {
+        set->fade_in_duration = obj["fade_in"].toInt();
+    }
+    if(obj["fade_out"].isDouble() && obj["fade_out"].toInt() >= 0) {
+        set->fade_out_duration = obj["fade_out"].toInt();
+    }
+    if(obj["crossfade"].isDouble() && obj["crossfade"].toInt() >= 0) {
+        set->crossfade_duration = obj["crossfade"].toInt();
+    }
+
     return set;
 }
 
@@ -1,26 +1,53 @@
 #include "volume_mapper.h"
 
 #include <QAudio>
+#include <QtGlobal>
+
+// volumes in percent, both scales from 0 to MAX_VOLUME
+static const int MAX_VOLUME = 100;
+
+/*
+ * Conversions of all volumes in percent, computed once.
+ * Volume sliders and tile wheels convert on every step,
+ * so this saves calling into QAudio for each of them.
+*/
+struct VolumeTables {
+    int to_linear[MAX_VOLUME + 1];
+    int to_logarithmic[MAX_VOLUME + 1];
+
+    VolumeTables()
+    {
+        for(int v = 0; v <= MAX_VOLUME; ++v) {
+            qreal x = v / qreal(MAX_VOLUME);
+            to_linear[v] = qRound(QAudio::convertVolume(
+                x,
+                QAudio::LogarithmicVolumeScale,
+                QAudio::LinearVolumeScale
+            ) * MAX_VOLUME);
+            to_logarithmic[v] = qRound(QAudio::convertVolume(
+                x,
+                QAudio::LinearVolumeScale,
+                QAudio::LogarithmicVolumeScale
+            ) * MAX_VOLUME);
+        }
+    }
+};
+
+static VolumeTables const& tables()
+{
+    static VolumeTables const tables;
+    return tables;
+}
 
 VolumeMapper::VolumeMapper()
 {}
 
 int VolumeMapper::logarithmicToLinear(int v)
 {
-    qreal linear_volume = QAudio::convertVolume(
-        v / qreal(100.0),
-        QAudio::LogarithmicVolumeScale,
-        QAudio::LinearVolumeScale
-    );
-    return qRound(linear_volume*100);
+    return tables().to_linear[qBound(0, v, MAX_VOLUME)];
 }
 
 int VolumeMapper::linearToLogarithmic(int v)
 {
-    qreal log_volume = QAudio::convertVolume(
-        v / qreal(100.0),
-        QAudio::LinearVolumeScale,
-        QAudio::LogarithmicVolumeScale
-    );
-    return qRound(log_volume*100);
+    return tables().to_logarithmic[qBound(0, v, MAX_VOLUME)];
 }
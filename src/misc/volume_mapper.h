@@ -1,6 +1,10 @@
 #ifndef VOLUME_MAPPER_H
 #define VOLUME_MAPPER_H
 
+/*
+ * Maps volumes in percent (0 to 100) between logarithmic (UI) and linear (gain) scale.
+ * Values out of range get clamped.
+*/
 class VolumeMapper
 {
 public:
@@ -2,26 +2,27 @@
 
 #include <QDebug>
 
-#include "json/json_mime_data_parser.h"
-
 Playlist::Playlist(QString name, QObject* parent)
     : QMediaPlaylist(parent)
     , name_(name)
     , settings_(0)
     , model_(0)
     , records_()
+    , inserting_()
+    , index_by_url_()
+    , index_dirty_(false)
+    , weights_()
 {
     settings_ = new PlaylistSettings;
+
+    connect(this, SIGNAL(mediaInserted(int,int)),
+            this, SLOT(onMediaInserted(int,int)));
+    connect(this, SIGNAL(mediaRemoved(int,int)),
+            this, SLOT(onMediaRemoved(int,int)));
 }
 
 Playlist::~Playlist()
 {
-    QList<QMediaContent*> keys = records_.keys();
-    while(keys.size() > 0) {
-        records_.remove(keys[0]);
-        delete keys[0];
-        keys.pop_front();
-    }
     delete settings_;
 }
 
@@ -39,9 +40,6 @@ const PlaylistSettings& Playlist::getSettings() const
 void Playlist::setSoundFileModel(SoundFileTableModel *m)
 {
     model_ = m;
-
-    connect(this, SIGNAL(mediaAboutToBeRemoved(int,int)),
-            this, SLOT(onMediaAboutToBeRemoved(int,int)));
 }
 
 const SoundFileTableModel *Playlist::getSoundFileModel() const
@@ -55,82 +53,129 @@ bool Playlist::addMedia(const SoundFileRecord &rec)
 }
 
 bool Playlist::addMedia(int record_id)
+{
+    return addMedia(QList<int>() << record_id) == 1;
+}
+
+int Playlist::addMedia(const QList<int> &record_ids)
 {
     if(model_ == 0)
-        return false;
-    SoundFileRecord* rec = model_->getSoundFileById(record_id);
-    if(rec == 0)
-        return false;
-
-    QMediaContent* c = new QMediaContent(QUrl("file:///" + rec->path));
-
-    // this should very rarely occur
-    QList<QMediaContent*> delete_recs;
-    foreach(QMediaContent* r_c, records_.keys()) {
-        if(*r_c == *c) {
-            QString old_str = JsonMimeDataParser::toJsonMimeData(records_[r_c])->text();
-            QString new_str = JsonMimeDataParser::toJsonMimeData(rec)->text();
-            qDebug() << "Sound file was already set for media content.";
-            qDebug() << " > Record will be replaced.";
-            qDebug() << " > old:" << old_str;
-            qDebug() << " > new:" << new_str;
-            delete_recs.append(r_c);
-        }
+        return 0;
+
+    QList<QMediaContent> contents;
+    inserting_.clear();
+    inserting_.reserve(record_ids.size());
+    foreach(int id, record_ids) {
+        SoundFileRecord* rec = model_->getSoundFileById(id);
+        if(rec == 0)
+            continue;
+        inserting_.append(rec);
+        contents.append(QMediaContent(toUrl(rec)));
     }
-    while(delete_recs.size() > 0) {
-        records_.remove(delete_recs[0]);
-        delete delete_recs[0];
-        delete_recs.pop_front();
+
+    if(contents.isEmpty())
+        return 0;
+
+    // one insertion, so listeners get notified once
+    if(!QMediaPlaylist::insertMedia(mediaCount(), contents)) {
+        inserting_.clear();
+        return 0;
     }
-    //
 
-    if(!QMediaPlaylist::addMedia(*c))
-        return false;
+    return contents.size();
+}
+
+SoundFileRecord *Playlist::getSoundFile(int index) const
+{
+    if(index < 0 || index >= records_.size())
+        return 0;
+    return records_[index];
+}
 
-    records_[c] = rec;
+int Playlist::indexOf(const QUrl &url) const
+{
+    if(index_dirty_) {
+        index_by_url_.clear();
+        for(int i = records_.size() - 1; i >= 0; --i) {
+            if(records_[i] != 0)
+                index_by_url_.insert(toUrl(records_[i]), i);
+        }
+        index_dirty_ = false;
+    }
 
-    return true;
+    return index_by_url_.value(url, -1);
 }
 
 const QList<SoundFileRecord *> Playlist::getSoundFileList(bool unique)
 {
     QList<SoundFileRecord*> sf_list;
+    QSet<SoundFileRecord*> listed;
 
-    if(unique) {
-        foreach(SoundFileRecord* rec, records_.values()) {
-            if(sf_list.contains(rec))
+    foreach(SoundFileRecord* rec, records_) {
+        if(rec == 0)
+            continue;
+        if(unique) {
+            if(listed.contains(rec))
                 continue;
-            sf_list.append(rec);
-        }
-    }
-    else {
-        for(int i = 0; i < mediaCount(); ++i) {
-            QMediaContent c = media(i);
-            foreach(QMediaContent* r_c, records_.keys()) {
-                if(*r_c == c) {
-                    sf_list.append(records_[r_c]);
-                    break;
-                }
-            }
+            listed.insert(rec);
         }
+        sf_list.append(rec);
     }
 
     return sf_list;
 }
 
-void Playlist::onMediaAboutToBeRemoved(int start, int end)
+void Playlist::setWeight(int index, double weight)
 {
-    for(int i = start; i <= end; ++i) {
-        QMediaContent c = media(i);
-        QMediaContent* remove_key = 0;
-        foreach(QMediaContent* r_c, records_.keys()) {
-            if(*r_c == c) {
-                remove_key = r_c;
-            }
-        }
-        if(remove_key != 0) {
-            records_.remove(remove_key);
-            delete remove_key;
+    weights_.setWeight(index, weight);
+}
+
+double Playlist::getWeight(int index) const
+{
+    return weights_.getWeight(index);
+}
+
+int Playlist::sampleWeighted(const QList<int> &excluded) const
+{
+    return weights_.sample(excluded);
+}
+
+void Playlist::onMediaInserted(int start, int end)
+{
+    int count = end - start + 1;
+
+    // media not added as sound files (e.g. through QMediaPlaylist interface) gets no record
+    if(inserting_.size() == count) {
+        for(int i = 0; i < count; ++i)
+            records_.insert(start + i, inserting_[i]);
+    }
+    else {
+        records_.insert(start, count, 0);
+    }
+    inserting_.clear();
+
+    // appending keeps other indices, first index of a content stays first
+    if(start + count == records_.size() && !index_dirty_) {
+        for(int i = start; i < records_.size(); ++i) {
+            if(records_[i] != 0 && !index_by_url_.contains(toUrl(records_[i])))
+                index_by_url_.insert(toUrl(records_[i]), i);
         }
     }
+    else {
+        index_dirty_ = true;
+    }
+
+    weights_.insert(start, count);
+}
+
+void Playlist::onMediaRemoved(int start, int end)
+{
+    records_.remove(start, end - start + 1);
+    index_dirty_ = true;
+    weights_.remove(start, end);
+}
+
+const QUrl Playlist::toUrl(const SoundFileRecord *rec)
+{
+    return QUrl("file:///" + rec->path);
 }
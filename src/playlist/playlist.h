@@ -2,10 +2,12 @@
 #define PLAYLIST_PLAYLIST_H
 
 #include <QMediaPlaylist>
-#include <QMap>
+#include <QVector>
+#include <QHash>
 #include <QSet>
 
 #include "playlist_settings.h"
+#include "weighted_sampler.h"
 #include "db/model/sound_file_table_model.h"
 
 class Playlist : public QMediaPlaylist
@@ -27,20 +29,60 @@ public:
     bool addMedia(const SoundFileRecord& rec);
     bool addMedia(int record_id);
 
+    /*
+     * Adds sound files of given ids with a single insertion.
+     * Ids not found in sound file model are skipped. Returns number of sound files added.
+    */
+    int addMedia(QList<int> const& record_ids);
+
+    /* Gets sound file at index, 0 if index is out of range or media was not added as sound file */
+    SoundFileRecord* getSoundFile(int index) const;
+
+    /* Gets first index of media with given content, -1 if not contained */
+    int indexOf(QUrl const& url) const;
+
     const QList<SoundFileRecord*> getSoundFileList(bool unique = false);
 
+    /*
+     * Sets weight of media at index for weighted play order (default 1).
+     * Probability of being drawn is weight divided by sum of all weights.
+    */
+    void setWeight(int index, double weight);
+    double getWeight(int index) const;
+
+    /*
+     * Draws index of media by weight (see WeightedSampler), leaving out excluded indices.
+     * Returns -1 if nothing is left to draw.
+    */
+    int sampleWeighted(QList<int> const& excluded = QList<int>()) const;
+
 signals:
     void changedSettings();
 
 private slots:
-    void onMediaAboutToBeRemoved(int start, int end);
+    void onMediaInserted(int start, int end);
+    void onMediaRemoved(int start, int end);
 
 private:
+    /* Gets content sound file gets played from */
+    static QUrl const toUrl(SoundFileRecord const* rec);
+
     QString name_;
     PlaylistSettings* settings_;
     SoundFileTableModel* model_;
-    QMap<QMediaContent*, SoundFileRecord*> records_;
 
+    // sound files by media index (owned by model)
+    QVector<SoundFileRecord*> records_;
+
+    // sound files of insertion in progress (see onMediaInserted)
+    QVector<SoundFileRecord*> inserting_;
+
+    // first media index by content, rebuilt lazily once indices shifted
+    mutable QHash<QUrl, int> index_by_url_;
+    mutable bool index_dirty_;
+
+    // weights by media index
+    WeightedSampler weights_;
 };
 
 #endif // PLAYLIST_PLAYLIST_H
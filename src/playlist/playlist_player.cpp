@@ -1,77 +1,225 @@
 #include "playlist_player.h"
 
+#include <QDebug>
+
+#include "sound/preroll_cache.h"
+
+// delay before preparing after playlist changes, as media mostly gets added in bulk (ms)
+static const int PREPARE_DELAY = 250;
+
+// indices of media played last kept for weighted order
+static const int MAX_HISTORY = 100;
+
 PlaylistPlayer::PlaylistPlayer(QObject* parent)
-    : QMediaPlayer(parent)
+    : QObject(parent)
+    , active_voice_(0)
+    , playlist_(0)
+    , media_()
     , activated_(false)
     , current_content_index_(0)
+    , prepare_enabled_(false)
+    , prepared_index_(-1)
+    , prepare_timer_(0)
+    , history_()
     , delay_flag_(false)
     , delay_(0)
     , delay_timer_(0)
 {
+    for(int i = 0; i < 2; ++i) {
+        voices_[i] = new AudioVoice(this);
+        connect(voices_[i], SIGNAL(finished()),
+                this, SLOT(onVoiceFinished()));
+        connect(voices_[i], SIGNAL(stateChanged(AudioVoice::State)),
+                this, SLOT(onVoiceStateChanged(AudioVoice::State)));
+        connect(voices_[i], SIGNAL(aboutToFinish()),
+                this, SLOT(onVoiceAboutToFinish()));
+    }
+
     delay_timer_ = new QTimer(this);
+    delay_timer_->setSingleShot(true);
     connect(delay_timer_, SIGNAL(timeout()),
             this, SLOT(onDelayIsOver()));
+
+    prepare_timer_ = new QTimer(this);
+    prepare_timer_->setSingleShot(true);
+    prepare_timer_->setInterval(PREPARE_DELAY);
+    connect(prepare_timer_, SIGNAL(timeout()),
+            this, SLOT(prepare()));
 }
 
 void PlaylistPlayer::play()
 {
-
+    int fade_in = 0;
     Playlist* playlist = getPlaylist();
     if(playlist) {
         PlaylistSettings settings = playlist->getSettings();
         setVolume(settings.volume);
-        // if delay interval is turned on
         if (settings.order == PlayOrder::ORDERED){
             if (settings.loop_flag){
                 playlist->setPlaybackMode(QMediaPlaylist::Loop);
-
-            }else if (!settings.loop_flag){
+            } else {
                 playlist->setPlaybackMode(QMediaPlaylist::Sequential);
-
             }
+            if (playlist->currentIndex() < 0)
+                playlist->setCurrentIndex(0);
+
         } else if (settings.order == PlayOrder::SHUFFLE){
             playlist->setPlaybackMode(QMediaPlaylist::Random);
-            int index = getRandomIntInRange(0, playlist->mediaCount()-1);
+            // pick prepared ahead, its head may be decoded already
+            int index = prepared_index_;
+            if (index < 0 || index >= playlist->mediaCount())
+                index = getRandomIntInRange(0, playlist->mediaCount()-1);
             playlist->setCurrentIndex(index);
 
         } else if (settings.order == PlayOrder::WEIGHTED){
-            // TODO implement weighted
-            QMediaPlayer::pause();
+            // player picks every next media itself
+            playlist->setPlaybackMode(QMediaPlaylist::CurrentItemOnce);
+            int index = prepared_index_;
+            if (index < 0 || index >= playlist->mediaCount())
+                index = drawWeighted();
+            if (index < 0){
+                voice()->stop();
+                return;
+            }
+            playlist->setCurrentIndex(index);
         }
+        prepared_index_ = -1;
 
         if (settings.interval_flag){
             delay_ = getRandomIntInRange(settings.min_delay_interval,
                                          settings.max_delay_interval);
             delay_flag_ = true;
-            if (activated_){
-                QMediaPlayer::play();
-                playlist->setPlaybackMode(QMediaPlaylist::CurrentItemOnce);
-            }
         } else {
             delay_flag_ = false;
             delay_ = 0;
-            if (activated_){
-                QMediaPlayer::play();
-            }
         }
+
+        fade_in = settings.fade_in_duration;
+    }
+
+    if (activated_)
+        playCurrent(fade_in);
+}
+
+void PlaylistPlayer::stop()
+{
+    delay_timer_->stop();
+
+    // voices fading out get prepared for once stopped (see onVoiceStateChanged)
+    int fade_out = playlist_ ? playlist_->getSettings().fade_out_duration : 0;
+    for(int i = 0; i < 2; ++i)
+        voices_[i]->stop(fade_out);
+    prepare();
+}
+
+void PlaylistPlayer::prepare()
+{
+    prepare_timer_->stop();
+
+    // playing voice streams anyway, next activation gets prepared once stopped
+    Playlist* playlist = getPlaylist();
+    if (!prepare_enabled_ || playlist == 0 || playlist->mediaCount() == 0 || voice()->getState() != AudioVoice::StoppedState)
+        return;
+
+    PlaylistSettings const& settings = playlist->getSettings();
+    if (settings.order == PlayOrder::ORDERED){
+        prepared_index_ = qMax(0, playlist->currentIndex());
+    } else if (settings.order == PlayOrder::SHUFFLE){
+        if (prepared_index_ < 0 || prepared_index_ >= playlist->mediaCount())
+            prepared_index_ = getRandomIntInRange(0, playlist->mediaCount()-1);
+    } else if (settings.order == PlayOrder::WEIGHTED){
+        if (prepared_index_ < 0 || prepared_index_ >= playlist->mediaCount())
+            prepared_index_ = drawWeighted();
     }
+
+    if (prepared_index_ >= 0)
+        PrerollCache::instance()->request(mediaPath(prepared_index_));
 }
 
 void PlaylistPlayer::setPlaylist(Playlist *playlist)
 {
+    if(playlist_)
+        playlist_->disconnect(this);
+
+    playlist_ = playlist;
+    media_ = QMediaContent(playlist_);
+
+    if(playlist_ == 0)
+        return;
+
     connect(playlist, SIGNAL(currentIndexChanged(int)),
             this, SLOT(onCurrentMediaIndexChanged(int)) );
 
     connect(playlist, SIGNAL(changedSettings()),
             this, SLOT(onMediaSettingsChanged()) );
 
-    QMediaPlayer::setPlaylist(playlist);
+    connect(playlist, SIGNAL(mediaInserted(int,int)),
+            this, SLOT(onMediaListChanged()) );
+
+    connect(playlist, SIGNAL(mediaRemoved(int,int)),
+            this, SLOT(onMediaListChanged()) );
+
+    prepared_index_ = -1;
+    history_.clear();
+    prepare_timer_->start();
+}
+
+void PlaylistPlayer::setMedia(const QMediaContent &media)
+{
+    Playlist* playlist = qobject_cast<Playlist*>(media.playlist());
+    if(playlist) {
+        setPlaylist(playlist);
+        return;
+    }
+
+    stop();
+    setPlaylist(0);
+    media_ = media;
+}
+
+const QMediaContent &PlaylistPlayer::media() const
+{
+    return media_;
+}
+
+QMediaPlayer::State PlaylistPlayer::state() const
+{
+    switch(voice()->getState()) {
+        case AudioVoice::PlayingState:
+            return QMediaPlayer::PlayingState;
+        case AudioVoice::PausedState:
+            return QMediaPlayer::PausedState;
+        default:
+            return QMediaPlayer::StoppedState;
+    }
+}
+
+int PlaylistPlayer::volume() const
+{
+    return voice()->getVolume();
+}
+
+void PlaylistPlayer::setVolume(int volume)
+{
+    // ramped, fades in progress keep going
+    for(int i = 0; i < 2; ++i)
+        voices_[i]->setVolume(volume);
+}
+
+void PlaylistPlayer::setPrepareEnabled(bool enabled)
+{
+    if(prepare_enabled_ == enabled)
+        return;
+
+    prepare_enabled_ = enabled;
+    if(prepare_enabled_)
+        prepare();
 }
 
 void PlaylistPlayer::onDelayIsOver()
 {
     delay_timer_->stop();
-    play();
+    advance();
 }
 
 void PlaylistPlayer::activate()
@@ -83,13 +231,162 @@ void PlaylistPlayer::activate()
 void PlaylistPlayer::deactivate()
 {
     activated_ = false;
+    delay_timer_->stop();
     emit playerActivationToggled(false);
+    prepare();
 }
 
 void PlaylistPlayer::setActivation(bool flag)
 {
-    activated_ = flag;
-    emit playerActivationToggled(flag);
+    if(flag)
+        activate();
+    else
+        deactivate();
+}
+
+void PlaylistPlayer::onVoiceFinished()
+{
+    // voice crossfaded from finished
+    if (!activated_ || sender() != voice())
+        return;
+
+    if (delay_flag_){
+        delay_timer_->start(delay_*1000);
+    } else {
+        advance();
+    }
+}
+
+void PlaylistPlayer::onVoiceStateChanged(AudioVoice::State state)
+{
+    if (sender() != voice())
+        return;
+
+    emit stateChanged(state == AudioVoice::PlayingState ? QMediaPlayer::PlayingState
+                    : state == AudioVoice::PausedState ? QMediaPlayer::PausedState
+                    : QMediaPlayer::StoppedState);
+
+    // faded out after deactivation
+    if (state == AudioVoice::StoppedState && !activated_)
+        prepare();
+}
+
+void PlaylistPlayer::onVoiceAboutToFinish()
+{
+    AudioVoice* finishing = qobject_cast<AudioVoice*>(sender());
+    int crossfade = getCrossfadeDuration();
+    if (!activated_ || finishing != voice() || crossfade <= 0)
+        return;
+
+    // end of non looping playlist, last sound file plays out
+    Playlist* playlist = getPlaylist();
+    if (playlist->getSettings().order == PlayOrder::ORDERED && playlist->nextIndex() < 0)
+        return;
+
+    // fades out over rest of its source, next media fades in on the other voice
+    finishing->stop(crossfade);
+    advance(crossfade);
+}
+
+AudioVoice *PlaylistPlayer::voice() const
+{
+    return voices_[active_voice_];
+}
+
+void PlaylistPlayer::playCurrent(int fade_in)
+{
+    QString path = playlist_ ? mediaPath(playlist_->currentIndex()) : media_.canonicalUrl().toLocalFile();
+    if(path.isEmpty()) {
+        voice()->stop();
+        return;
+    }
+
+    if (voice()->isFadingOut() && !voices_[1 - active_voice_]->isFadingOut())
+        active_voice_ = 1 - active_voice_;
+
+    voice()->setSource(path);
+    voice()->setFinishNotice(getCrossfadeDuration());
+    voice()->play(fade_in);
+
+    if (playlist_){
+        history_.append(playlist_->currentIndex());
+        while (history_.size() > MAX_HISTORY)
+            history_.removeFirst();
+    }
+
+    // following media is known in order only
+    if (playlist_ && playlist_->getSettings().order == PlayOrder::ORDERED){
+        int next = playlist_->nextIndex();
+        if (next >= 0 && next != playlist_->currentIndex())
+            PrerollCache::instance()->request(mediaPath(next));
+    }
+}
+
+int PlaylistPlayer::getCrossfadeDuration() const
+{
+    // delays put silence between media, nothing to overlap
+    if (playlist_ == 0 || delay_flag_)
+        return 0;
+    return playlist_->getSettings().crossfade_duration;
+}
+
+const QString PlaylistPlayer::mediaPath(int index) const
+{
+    if(playlist_ == 0 || index < 0 || index >= playlist_->mediaCount())
+        return QString();
+
+    SoundFileRecord* rec = playlist_->getSoundFile(index);
+    if(rec != 0)
+        return rec->path;
+    return playlist_->media(index).canonicalUrl().toLocalFile();
+}
+
+void PlaylistPlayer::advance(int fade_in)
+{
+    Playlist* playlist = getPlaylist();
+    if(playlist == 0) {
+        // single media ends after playing once
+        deactivate();
+        return;
+    }
+
+    if (playlist->getSettings().order == PlayOrder::WEIGHTED){
+        playlist->setCurrentIndex(drawWeighted());
+    } else {
+        playlist->next();
+    }
+
+    if(playlist->currentIndex() < 0) {
+        deactivate();
+        return;
+    }
+
+    // new delay for each sound file
+    if (delay_flag_){
+        PlaylistSettings settings = playlist->getSettings();
+        delay_ = getRandomIntInRange(settings.min_delay_interval,
+                                     settings.max_delay_interval);
+    }
+
+    playCurrent(fade_in);
+}
+
+int PlaylistPlayer::drawWeighted() const
+{
+    Playlist* playlist = getPlaylist();
+    if (playlist == 0)
+        return -1;
+
+    // media played last is left out, as long as anything else can be drawn
+    int count = qMin(playlist->getSettings().no_repeat_count, history_.size());
+    QList<int> excluded = history_.mid(history_.size() - count);
+    int index = playlist->sampleWeighted(excluded);
+    while (index < 0 && excluded.size() > 0){
+        excluded.removeFirst();
+        index = playlist->sampleWeighted(excluded);
+    }
+
+    return index;
 }
 
 int PlaylistPlayer::getRandomIntInRange(int min, int max)
@@ -101,9 +398,13 @@ int PlaylistPlayer::getRandomIntInRange(int min, int max)
 void PlaylistPlayer::onCurrentMediaIndexChanged(int position)
 {
     current_content_index_ = position;
-    if (activated_ && delay_flag_){
-        delay_timer_->start(delay_*1000);
-    }
+}
+
+void PlaylistPlayer::onMediaListChanged()
+{
+    // indices shifted
+    history_.clear();
+    prepare_timer_->start();
 }
 
 void PlaylistPlayer::onMediaSettingsChanged()
@@ -120,12 +421,15 @@ void PlaylistPlayer::onMediaSettingsChanged()
     }
 
     if (settings.order == PlayOrder::ORDERED){
-
+        getPlaylist()->setPlaybackMode(settings.loop_flag ? QMediaPlaylist::Loop
+                                                          : QMediaPlaylist::Sequential);
     } else if (settings.order == PlayOrder::SHUFFLE){
         getPlaylist()->setPlaybackMode(QMediaPlaylist::Random);
     } else if (settings.order == PlayOrder::WEIGHTED){
-        qDebug() << "weigthed not implemented yet";
+        getPlaylist()->setPlaybackMode(QMediaPlaylist::CurrentItemOnce);
     }
+
+    prepare();
 }
 
 void PlaylistPlayer::onMediaVolumeChanged(int val)
@@ -134,15 +438,7 @@ void PlaylistPlayer::onMediaVolumeChanged(int val)
         setVolume(val);
 }
 
-
 Playlist *PlaylistPlayer::getPlaylist() const
 {
-
-    Playlist* pl = qobject_cast<Playlist*>( playlist() );
-    if(pl){
-        return pl;
-    } else {
-        return nullptr;
-    }
+    return playlist_;
 }
-
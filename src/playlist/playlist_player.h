@@ -1,27 +1,57 @@
 #ifndef PLAYLIST_PLAYLIST_PLAYER_H
 #define PLAYLIST_PLAYLIST_PLAYER_H
 
+#include <QObject>
+#include <QMediaContent>
 #include <QMediaPlayer>
 #include <QTimer>
 
 #include "playlist/playlist.h"
 #include "playlist/playlist_settings.h"
+#include "sound/audio_voice.h"
 
-class PlaylistPlayer : public QMediaPlayer
+/*
+ * Plays the sound files of a playlist one after another,
+ * in order, shuffle or by weight (see Playlist::setWeight) and with delays as defined by its settings.
+ * Weighted order does not draw the sound files played last again (see PlaylistSettings::no_repeat_count).
+ * Plays through two AudioVoices of the shared AudioEngine, so consecutive sound files
+ * can overlap (see PlaylistSettings::crossfade_duration). Activation and deactivation
+ * fade in and out as set by the playlist settings, volume changes get ramped.
+ * While stopped and prepare is enabled, the sound file next activation will start with
+ * gets chosen ahead and its head pre-decoded (see PrerollCache), so activation starts without delay.
+*/
+class PlaylistPlayer : public QObject
 {
     Q_OBJECT
 public:
     PlaylistPlayer(QObject* parent = 0);
-    //explicit CustomMediaPlayer(QObject* parent = 0, Flags* flags = 0);
 
     Playlist *getPlaylist() const;
     void setPlaylist(Playlist* playlist);
 
+    /* Sets media to play, a playlist content sets playlist (see setPlaylist) */
+    void setMedia(QMediaContent const& media);
+    QMediaContent const& media() const;
+
+    QMediaPlayer::State state() const;
+
+    int volume() const;
+    void setVolume(int volume);
+
+    /* Enables preparing next activation (see prepare), meant for tiles on the scene shown */
+    void setPrepareEnabled(bool enabled);
+
 signals:
     void playerActivationToggled(bool state);
+    void stateChanged(QMediaPlayer::State state);
 
 public slots:
     void play();
+    void stop();
+
+    /* Chooses sound file next activation starts with and requests its head to be pre-decoded */
+    void prepare();
+
     void onCurrentMediaIndexChanged(int position);
     void onMediaSettingsChanged();
     void onMediaVolumeChanged(int val);
@@ -31,11 +61,55 @@ public slots:
     void deactivate();
     void setActivation(bool flag);
 
+private slots:
+    void onMediaListChanged();
+    void onVoiceFinished();
+    void onVoiceStateChanged(AudioVoice::State state);
+    void onVoiceAboutToFinish();
+
 private:
+    /* Gets voice playing current media */
+    AudioVoice* voice() const;
+
+    /*
+     * Starts voice on current media, fading in over fade_in (ms),
+     * requests head of following media if known.
+     * Voice fading out keeps fading, media starts on the other voice.
+    */
+    void playCurrent(int fade_in = 0);
+
+    /* Gets overlap of consecutive media (ms), 0 if delays are set or no playlist is played */
+    int getCrossfadeDuration() const;
+
+    /* Gets path of media at index of playlist */
+    QString const mediaPath(int index) const;
+
+    /* Moves to next media of playlist, deactivates at end of non looping playlist */
+    void advance(int fade_in = 0);
+
+    /* Draws index of next media by weight, -1 if playlist is empty */
+    int drawWeighted() const;
+
     int getRandomIntInRange(int min, int max);
 
+    // voices take turns, one fades out while the other fades in
+    AudioVoice* voices_[2];
+    int active_voice_;
+
+    Playlist* playlist_;
+    QMediaContent media_;
+
     bool activated_;
     int current_content_index_;
+
+    // index chosen by prepare, -1 if none
+    bool prepare_enabled_;
+    int prepared_index_;
+    QTimer* prepare_timer_;
+
+    // indices of media played last, most recent at back
+    QList<int> history_;
+
     bool delay_flag_;
     int delay_;
     QTimer* delay_timer_;
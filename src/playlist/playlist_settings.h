@@ -29,6 +29,14 @@ struct PlaylistSettings {
     int volume;
     QString image_path;
 
+    // number of sound files played last which weighted order does not draw again
+    int no_repeat_count;
+
+    // fades on activation and deactivation, overlap of consecutive sound files (ms, 0 for none)
+    int fade_in_duration;
+    int fade_out_duration;
+    int crossfade_duration;
+
     PlaylistSettings()
         : name("Settings")
         , order(PlayOrder::ORDERED)
@@ -38,6 +46,10 @@ struct PlaylistSettings {
         , max_delay_interval(0)
         , volume(100)
         , image_path()
+        , no_repeat_count(1)
+        , fade_in_duration(0)
+        , fade_out_duration(0)
+        , crossfade_duration(0)
     {}
 
     PlaylistSettings(QString n,PlayOrder ord, bool loop, bool interval, int min_interval, int max_interval, int vol, QString img_path)
@@ -49,6 +61,10 @@ struct PlaylistSettings {
         , max_delay_interval(max_interval)
         , volume(vol)
         , image_path(img_path)
+        , no_repeat_count(1)
+        , fade_in_duration(0)
+        , fade_out_duration(0)
+        , crossfade_duration(0)
     {}
 
     void copyFrom(const PlaylistSettings& settings)
@@ -61,6 +77,10 @@ struct PlaylistSettings {
         max_delay_interval = settings.max_delay_interval;
         volume = settings.volume;
         image_path = settings.image_path;
+        no_repeat_count = settings.no_repeat_count;
+        fade_in_duration = settings.fade_in_duration;
+        fade_out_duration = settings.fade_out_duration;
+        crossfade_duration = settings.crossfade_duration;
     }
 };
 
@@ -20,6 +20,10 @@ PlaylistSettingsWidget::PlaylistSettingsWidget(const PlaylistSettings& settings,
     , normal_radio_button_(0)
     , shuffle_radio_button_(0)
     , weighted_radio_button_(0)
+    , no_repeat_spinbox_(0)
+    , fade_in_spinbox_(0)
+    , fade_out_spinbox_(0)
+    , crossfade_spinbox_(0)
     , save_button_(0)
     , close_button_(0)
     , image_path_edit_(0)
@@ -77,6 +81,12 @@ void PlaylistSettingsWidget::onSaveClicked(bool)
     {
         new_settings.order = PlayOrder::WEIGHTED;
     }
+    new_settings.no_repeat_count = no_repeat_spinbox_->value();
+
+    //set fades
+    new_settings.fade_in_duration = fade_in_spinbox_->value();
+    new_settings.fade_out_duration = fade_out_spinbox_->value();
+    new_settings.crossfade_duration = crossfade_spinbox_->value();
 
     //set volume
     new_settings.volume = VolumeMapper::logarithmicToLinear(volume_slider_->value());
@@ -194,6 +204,40 @@ void PlaylistSettingsWidget::initWidgets()
         weighted_radio_button_->setChecked(true);
     }
 
+    no_repeat_spinbox_ = new QSpinBox(this);
+    no_repeat_spinbox_->setRange(0, 99);
+    no_repeat_spinbox_->setValue(settings_.no_repeat_count);
+    no_repeat_spinbox_->setPrefix(tr("Avoid last "));
+    no_repeat_spinbox_->setToolTip(tr("Number of sound files played last, which weighted order does not pick again"));
+    no_repeat_spinbox_->setEnabled(weighted_radio_button_->isChecked());
+
+    connect(weighted_radio_button_, SIGNAL(toggled(bool)),
+            no_repeat_spinbox_, SLOT(setEnabled(bool)));
+
+    fade_in_spinbox_ = new QSpinBox(this);
+    fade_in_spinbox_->setRange(0, 30000);
+    fade_in_spinbox_->setSingleStep(100);
+    fade_in_spinbox_->setValue(settings_.fade_in_duration);
+    fade_in_spinbox_->setPrefix(tr("Fade in "));
+    fade_in_spinbox_->setSuffix(" ms");
+    fade_in_spinbox_->setToolTip(tr("Time playlist fades in for when activated"));
+
+    fade_out_spinbox_ = new QSpinBox(this);
+    fade_out_spinbox_->setRange(0, 30000);
+    fade_out_spinbox_->setSingleStep(100);
+    fade_out_spinbox_->setValue(settings_.fade_out_duration);
+    fade_out_spinbox_->setPrefix(tr("Fade out "));
+    fade_out_spinbox_->setSuffix(" ms");
+    fade_out_spinbox_->setToolTip(tr("Time playlist fades out for when deactivated"));
+
+    crossfade_spinbox_ = new QSpinBox(this);
+    crossfade_spinbox_->setRange(0, 30000);
+    crossfade_spinbox_->setSingleStep(100);
+    crossfade_spinbox_->setValue(settings_.crossfade_duration);
+    crossfade_spinbox_->setPrefix(tr("Crossfade "));
+    crossfade_spinbox_->setSuffix(" ms");
+    crossfade_spinbox_->setToolTip(tr("Time consecutive sound files overlap for, not used with delay interval"));
+
     image_path_edit_ = new QLineEdit(this);
     image_path_edit_->setReadOnly(true);
     image_path_edit_->setText(settings_.image_path);
@@ -231,6 +275,7 @@ void PlaylistSettingsWidget::initLayout()
     playmode_layout->addWidget(normal_radio_button_);
     playmode_layout->addWidget(shuffle_radio_button_);
     playmode_layout->addWidget(weighted_radio_button_);
+    playmode_layout->addWidget(no_repeat_spinbox_);
     playmode_layout->addStretch(1);
     playmode_box->setLayout(playmode_layout);
 
@@ -255,6 +300,15 @@ void PlaylistSettingsWidget::initLayout()
     grid_layout->addWidget(playmode_box,1,0,1,1);
     grid_layout->addWidget(volume_box,1,1,1,1);
 
+    //fade settings
+    QGroupBox *fade_box = new QGroupBox(tr("Fade Options"),this);
+    QHBoxLayout *fade_layout = new QHBoxLayout;
+    fade_layout->addWidget(fade_in_spinbox_);
+    fade_layout->addWidget(fade_out_spinbox_);
+    fade_layout->addWidget(crossfade_spinbox_);
+    fade_box->setLayout(fade_layout);
+    grid_layout->addWidget(fade_box,2,0,1,2);
+
     //image open
     QGroupBox* image_box = new QGroupBox(tr("Background Image"), this);
     QHBoxLayout* image_layout = new QHBoxLayout;
@@ -276,7 +330,7 @@ void PlaylistSettingsWidget::initLayout()
     layout->addWidget(bottom_box);
     setLayout(layout);
 
-    setFixedHeight(400);
+    setFixedHeight(460);
     setFixedWidth(600);
 }
 
@@ -9,6 +9,7 @@
 #include <QPushButton>
 #include <QRadioButton>
 #include <QGroupBox>
+#include <QSpinBox>
 
 #include "playlist.h"
 
@@ -53,6 +54,10 @@ private:
     QRadioButton* normal_radio_button_;
     QRadioButton* shuffle_radio_button_;
     QRadioButton* weighted_radio_button_;
+    QSpinBox* no_repeat_spinbox_;
+    QSpinBox* fade_in_spinbox_;
+    QSpinBox* fade_out_spinbox_;
+    QSpinBox* crossfade_spinbox_;
     QPushButton* save_button_;
     QPushButton* close_button_;
     QLineEdit* image_path_edit_;
@@ -0,0 +1,72 @@
+#include "playlist_weights_dialog.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+
+PlaylistWeightsDialog::PlaylistWeightsDialog(Playlist *playlist, QWidget *parent)
+    : QDialog(parent)
+    , playlist_(playlist)
+    , table_(0)
+    , ok_(0)
+    , cancel_(0)
+{
+    setWindowTitle(tr("Playlist Weights"));
+
+    initWidgets();
+    initLayout();
+}
+
+void PlaylistWeightsDialog::accept()
+{
+    for(int i = 0; i < table_->rowCount() && i < playlist_->mediaCount(); ++i)
+        playlist_->setWeight(i, table_->item(i, 1)->data(Qt::EditRole).toDouble());
+
+    QDialog::accept();
+}
+
+void PlaylistWeightsDialog::initWidgets()
+{
+    table_ = new QTableWidget(playlist_->mediaCount(), 2, this);
+    table_->setHorizontalHeaderLabels(QStringList() << tr("Name") << tr("Weight"));
+    table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table_->verticalHeader()->hide();
+
+    for(int i = 0; i < playlist_->mediaCount(); ++i) {
+        SoundFileRecord* rec = playlist_->getSoundFile(i);
+        QString name = rec ? rec->name : playlist_->media(i).canonicalUrl().fileName();
+        QTableWidgetItem* name_item = new QTableWidgetItem(name);
+        name_item->setFlags(name_item->flags() & ~Qt::ItemIsEditable);
+        if(rec)
+            name_item->setToolTip(rec->path);
+        table_->setItem(i, 0, name_item);
+
+        // double data gets edited by spin box
+        QTableWidgetItem* weight_item = new QTableWidgetItem;
+        weight_item->setData(Qt::EditRole, playlist_->getWeight(i));
+        table_->setItem(i, 1, weight_item);
+    }
+
+    ok_ = new QPushButton(tr("OK"), this);
+    cancel_ = new QPushButton(tr("Cancel"), this);
+
+    connect(ok_, SIGNAL(pressed()),
+            this, SLOT(accept()));
+    connect(cancel_, SIGNAL(pressed()),
+            this, SLOT(reject()));
+}
+
+void PlaylistWeightsDialog::initLayout()
+{
+    QVBoxLayout* layout = new QVBoxLayout;
+
+    QHBoxLayout* button_layout = new QHBoxLayout;
+    button_layout->addStretch(2);
+    button_layout->addWidget(ok_, 1);
+    button_layout->addWidget(cancel_, 1);
+
+    layout->addWidget(table_, 4);
+    layout->addLayout(button_layout, 0);
+
+    setLayout(layout);
+    resize(500, 400);
+}
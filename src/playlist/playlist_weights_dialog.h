@@ -0,0 +1,33 @@
+#ifndef PLAYLIST_PLAYLIST_WEIGHTS_DIALOG_H
+#define PLAYLIST_PLAYLIST_WEIGHTS_DIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QPushButton>
+
+#include "playlist.h"
+
+/*
+ * Lists sound files of a playlist with their weights for weighted play order.
+ * Weights edited get set on the playlist once accepted.
+*/
+class PlaylistWeightsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit PlaylistWeightsDialog(Playlist* playlist, QWidget *parent = 0);
+
+public slots:
+    virtual void accept();
+
+private:
+    void initWidgets();
+    void initLayout();
+
+    Playlist* playlist_;
+    QTableWidget* table_;
+    QPushButton* ok_;
+    QPushButton* cancel_;
+};
+
+#endif // PLAYLIST_PLAYLIST_WEIGHTS_DIALOG_H
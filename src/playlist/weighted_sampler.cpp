@@ -0,0 +1,158 @@
+#include "weighted_sampler.h"
+
+#include <QtGlobal>
+#include <QSet>
+#include <algorithm>
+
+WeightedSampler::WeightedSampler()
+    : weights_()
+    , tree_(1, 0.0)
+    , top_bit_(0)
+{}
+
+int WeightedSampler::size() const
+{
+    return weights_.size();
+}
+
+void WeightedSampler::insert(int index, int count, double weight)
+{
+    index = qBound(0, index, weights_.size());
+    weights_.insert(index, qMax(0, count), qMax(0.0, weight));
+    rebuild();
+}
+
+void WeightedSampler::remove(int start, int end)
+{
+    start = qMax(0, start);
+    end = qMin(end, weights_.size() - 1);
+    if(end < start)
+        return;
+
+    weights_.remove(start, end - start + 1);
+    rebuild();
+}
+
+void WeightedSampler::clear()
+{
+    weights_.clear();
+    rebuild();
+}
+
+void WeightedSampler::setWeight(int index, double weight)
+{
+    if(index < 0 || index >= weights_.size())
+        return;
+
+    weight = qMax(0.0, weight);
+    add(index, weight - weights_[index]);
+    weights_[index] = weight;
+}
+
+double WeightedSampler::getWeight(int index) const
+{
+    if(index < 0 || index >= weights_.size())
+        return 0.0;
+    return weights_[index];
+}
+
+double WeightedSampler::getTotal() const
+{
+    return prefix(weights_.size());
+}
+
+int WeightedSampler::sample(const QList<int> &excluded) const
+{
+    // excluded weight is cut out of drawn range, by skipping over it during lookup
+    QList<int> skipped = excluded.toSet().toList();
+    std::sort(skipped.begin(), skipped.end());
+
+    double total = getTotal();
+    foreach(int index, skipped)
+        total -= getWeight(index);
+
+    // leaves room for rounding of tree sums
+    if(total <= 1e-9)
+        return -1;
+
+    double value = (qrand() / (RAND_MAX + 1.0)) * total;
+    foreach(int index, skipped) {
+        double w = getWeight(index);
+        if(w <= 0.0)
+            continue;
+
+        // value lands on or behind excluded index, so move past it
+        if(value < prefix(index))
+            break;
+        value += w;
+    }
+
+    int index = find(value);
+
+    // rounding may hit excluded index or one of zero weight, take closest drawable one
+    if(skipped.contains(index) || getWeight(index) <= 0.0) {
+        for(int d = 1; d < weights_.size(); ++d) {
+            int lo = index - d;
+            int hi = index + d;
+            if(lo >= 0 && getWeight(lo) > 0.0 && !skipped.contains(lo))
+                return lo;
+            if(hi < weights_.size() && getWeight(hi) > 0.0 && !skipped.contains(hi))
+                return hi;
+        }
+        return -1;
+    }
+
+    return index;
+}
+
+int WeightedSampler::find(double value) const
+{
+    if(weights_.isEmpty())
+        return -1;
+
+    // descends tree, pos ends as count of indices whose prefix sum is <= value
+    int pos = 0;
+    for(int step = top_bit_; step > 0; step >>= 1) {
+        int next = pos + step;
+        if(next < tree_.size() && tree_[next] <= value) {
+            pos = next;
+            value -= tree_[next];
+        }
+    }
+
+    return qMin(pos, weights_.size() - 1);
+}
+
+double WeightedSampler::prefix(int count) const
+{
+    double sum = 0.0;
+    for(int i = qMin(count, weights_.size()); i > 0; i -= i & -i)
+        sum += tree_[i];
+    return sum;
+}
+
+void WeightedSampler::add(int index, double delta)
+{
+    for(int i = index + 1; i < tree_.size(); i += i & -i)
+        tree_[i] += delta;
+}
+
+void WeightedSampler::rebuild()
+{
+    int n = weights_.size();
+    tree_.fill(0.0, n + 1);
+
+    // each node passes its sum on to its parent once
+    for(int i = 1; i <= n; ++i) {
+        tree_[i] += weights_[i - 1];
+        int parent = i + (i & -i);
+        if(parent <= n)
+            tree_[parent] += tree_[i];
+    }
+
+    top_bit_ = 1;
+    while(top_bit_ * 2 <= n)
+        top_bit_ *= 2;
+    if(n == 0)
+        top_bit_ = 0;
+}
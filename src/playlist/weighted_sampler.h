@@ -0,0 +1,63 @@
+#ifndef PLAYLIST_WEIGHTED_SAMPLER_H
+#define PLAYLIST_WEIGHTED_SAMPLER_H
+
+#include <QVector>
+#include <QList>
+
+/*
+ * Draws indices with probability proportional to their weight.
+ * Weights are kept in a Fenwick tree (binary indexed tree), so changing a weight
+ * and drawing an index both take O(log n). Inserting or removing indices
+ * shifts the ones behind and rebuilds the tree in O(n).
+ * Weights below zero are treated as zero.
+*/
+class WeightedSampler
+{
+public:
+    WeightedSampler();
+
+    int size() const;
+
+    /* Inserts count indices of given weight before index */
+    void insert(int index, int count, double weight = 1.0);
+
+    /* Removes indices from start to end (inclusive) */
+    void remove(int start, int end);
+
+    void clear();
+
+    void setWeight(int index, double weight);
+    double getWeight(int index) const;
+
+    /* Gets sum of all weights */
+    double getTotal() const;
+
+    /*
+     * Draws an index, leaving out excluded ones.
+     * Returns -1 if all weight is excluded (or none left).
+    */
+    int sample(QList<int> const& excluded = QList<int>()) const;
+
+    /* Gets index at which weights summed up from index 0 exceed value (value within [0, total)) */
+    int find(double value) const;
+
+private:
+    /* Gets sum of weights of first count indices */
+    double prefix(int count) const;
+
+    /* Adds delta to weight at index in tree */
+    void add(int index, double delta);
+
+    /* Rebuilds tree from weights in O(n) */
+    void rebuild();
+
+    QVector<double> weights_;
+
+    // 1-based, node i sums weights (i - lowbit(i), i]
+    QVector<double> tree_;
+
+    // highest power of two not above size, start of tree descent
+    int top_bit_;
+};
+
+#endif // PLAYLIST_WEIGHTED_SAMPLER_H
@@ -0,0 +1,518 @@
+#include "audio_metadata_reader.h"
+
+#include <QtEndian>
+
+namespace Resources {
+
+// bytes searched for the first mp3 frame behind ID3v2 tag (or file start)
+static const int MP3_SCAN_SIZE = 64 * 1024;
+
+// largest tag text read, bigger frames (e.g. lyrics) get skipped
+static const int MAX_TAG_SIZE = 4096;
+
+// largest RIFF LIST or ASF content description read
+static const int MAX_TAG_BLOCK_SIZE = 64 * 1024;
+
+// ASF object GUIDs, as stored on disk (first three fields little endian)
+static const QByteArray ASF_HEADER_GUID = QByteArray::fromHex("3026b2758e66cf11a6d900aa0062ce6c");
+static const QByteArray ASF_FILE_PROPERTIES_GUID = QByteArray::fromHex("a1dcab8c47a9cf118ee400c00c205365");
+static const QByteArray ASF_STREAM_PROPERTIES_GUID = QByteArray::fromHex("9107dcb7b7a9cf118ee600c00c205365");
+static const QByteArray ASF_CONTENT_DESCRIPTION_GUID = QByteArray::fromHex("3326b2758e66cf11a6d900aa0062ce6c");
+static const QByteArray ASF_AUDIO_MEDIA_GUID = QByteArray::fromHex("409e69f84d5bcf11a8fd00805f5c442b");
+
+// mp3 bitrates (kbit/s) by bitrate index
+static const int MP3_BITRATES_V1[3][16] = {
+    {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0},  // layer I
+    {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0},     // layer II
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0}       // layer III
+};
+static const int MP3_BITRATES_V2_L1[16] = {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0};
+static const int MP3_BITRATES_V2_L23[16] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+
+// mp3 sample rates by version bits (2.5, reserved, 2, 1) and sample rate index
+static const int MP3_SAMPLE_RATES[4][3] = {
+    {11025, 12000, 8000},
+    {0, 0, 0},
+    {22050, 24000, 16000},
+    {44100, 48000, 32000}
+};
+
+struct Mp3Frame {
+    int sample_rate;
+    int bitrate;
+    int channels;
+    int samples;
+    int length;
+    int side_info;
+};
+
+static quint16 le16(char const* p)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<uchar const*>(p));
+}
+
+static quint32 le32(char const* p)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<uchar const*>(p));
+}
+
+static quint64 le64(char const* p)
+{
+    return qFromLittleEndian<quint64>(reinterpret_cast<uchar const*>(p));
+}
+
+static quint32 be32(char const* p)
+{
+    return qFromBigEndian<quint32>(reinterpret_cast<uchar const*>(p));
+}
+
+/* Reads 28 bit integer stored in 4 bytes of 7 bits (ID3v2 sizes) */
+static quint32 synchsafe32(char const* p)
+{
+    uchar const* u = reinterpret_cast<uchar const*>(p);
+    return ((u[0] & 0x7F) << 21) | ((u[1] & 0x7F) << 14) | ((u[2] & 0x7F) << 7) | (u[3] & 0x7F);
+}
+
+/* Decodes UTF-16 text of given byte order, up to first null character */
+static QString const decodeUtf16(QByteArray const& data, bool little_endian)
+{
+    QString text;
+    text.reserve(data.size() / 2);
+    for(int i = 0; i + 1 < data.size(); i += 2) {
+        uchar const* p = reinterpret_cast<uchar const*>(data.constData() + i);
+        ushort c = little_endian ? qFromLittleEndian<quint16>(p) : qFromBigEndian<quint16>(p);
+        if(c == 0)
+            break;
+        text.append(QChar(c));
+    }
+    return text;
+}
+
+/* Decodes 8 bit text up to first null character */
+static QString const decode8Bit(QByteArray const& data, bool utf8)
+{
+    int end = data.indexOf('\0');
+    QByteArray text = end == -1 ? data : data.left(end);
+    return utf8 ? QString::fromUtf8(text) : QString::fromLatin1(text);
+}
+
+/* Decodes content of an ID3v2 text frame (encoding byte followed by text) */
+static QString const decodeId3Text(QByteArray const& data)
+{
+    if(data.size() < 2)
+        return QString();
+
+    QByteArray text = data.mid(1);
+    switch(data[0]) {
+    case 0:
+        return decode8Bit(text, false).trimmed();
+    case 1:
+        if(text.size() >= 2 && (uchar) text[0] == 0xFE && (uchar) text[1] == 0xFF)
+            return decodeUtf16(text.mid(2), false).trimmed();
+        if(text.size() >= 2 && (uchar) text[0] == 0xFF && (uchar) text[1] == 0xFE)
+            return decodeUtf16(text.mid(2), true).trimmed();
+        return decodeUtf16(text, true).trimmed();
+    case 2:
+        return decodeUtf16(text, false).trimmed();
+    case 3:
+        return decode8Bit(text, true).trimmed();
+    default:
+        return QString();
+    }
+}
+
+/* Gets tag name for ID3v2 text frame id (v2.2 and v2.3/4 ids), empty if not read */
+static QString const id3TagName(QByteArray const& frame_id)
+{
+    // no shared table, called from several extractor threads at once
+    if(frame_id == "TIT2" || frame_id == "TT2")
+        return "title";
+    if(frame_id == "TPE1" || frame_id == "TP1")
+        return "artist";
+    if(frame_id == "TALB" || frame_id == "TAL")
+        return "album";
+    if(frame_id == "TCON" || frame_id == "TCO")
+        return "genre";
+    if(frame_id == "TYER" || frame_id == "TYE" || frame_id == "TDRC")
+        return "year";
+    return QString();
+}
+
+/* Parses mp3 frame header. Returns false if header is invalid or unsupported (free format). */
+static bool parseMp3Header(quint32 h, Mp3Frame& frame)
+{
+    if((h & 0xFFE00000) != 0xFFE00000)
+        return false;
+
+    int version = (h >> 19) & 3;
+    int layer = 4 - ((h >> 17) & 3);
+    int bitrate_idx = (h >> 12) & 0xF;
+    int sample_rate_idx = (h >> 10) & 3;
+    int padding = (h >> 9) & 1;
+    int mode = (h >> 6) & 3;
+
+    if(version == 1 || layer == 4 || bitrate_idx == 0 || bitrate_idx == 15 || sample_rate_idx == 3)
+        return false;
+
+    bool v1 = version == 3;
+    frame.sample_rate = MP3_SAMPLE_RATES[version][sample_rate_idx];
+    if(v1)
+        frame.bitrate = MP3_BITRATES_V1[layer - 1][bitrate_idx];
+    else
+        frame.bitrate = layer == 1 ? MP3_BITRATES_V2_L1[bitrate_idx] : MP3_BITRATES_V2_L23[bitrate_idx];
+
+    frame.channels = mode == 3 ? 1 : 2;
+    frame.samples = layer == 1 ? 384 : (layer == 3 && !v1 ? 576 : 1152);
+    if(layer == 1)
+        frame.length = (12 * frame.bitrate * 1000 / frame.sample_rate + padding) * 4;
+    else
+        frame.length = (frame.samples / 8) * frame.bitrate * 1000 / frame.sample_rate + padding;
+
+    if(v1)
+        frame.side_info = frame.channels == 1 ? 17 : 32;
+    else
+        frame.side_info = frame.channels == 1 ? 9 : 17;
+
+    return frame.length > 4;
+}
+
+bool AudioMetadataReader::read(const QString &path, SoundFileMetadata &metadata)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray head = file.peek(16);
+    if(head.size() < 12)
+        return false;
+
+    if(head.startsWith("RIFF") && head.mid(8, 4) == "WAVE")
+        return readWav(file, metadata);
+
+    if(head.startsWith(ASF_HEADER_GUID))
+        return readAsf(file, metadata);
+
+    return readMp3(file, metadata);
+}
+
+bool AudioMetadataReader::readWav(QFile &file, SoundFileMetadata &metadata)
+{
+    if(!file.seek(12))
+        return false;
+
+    bool has_format = false;
+    quint32 byte_rate = 0;
+    qint64 data_size = -1;
+
+    while(true) {
+        QByteArray header = file.read(8);
+        if(header.size() < 8)
+            break;
+
+        QByteArray id = header.left(4);
+        quint32 size = le32(header.constData() + 4);
+        qint64 start = file.pos();
+
+        if(id == "fmt ") {
+            QByteArray format = file.read(qMin<quint32>(size, 40));
+            if(format.size() >= 16) {
+                metadata.channels = le16(format.constData() + 2);
+                metadata.sample_rate = le32(format.constData() + 4);
+                byte_rate = le32(format.constData() + 8);
+                has_format = true;
+            }
+        }
+        else if(id == "data") {
+            // size may be a placeholder (streamed or > 4 GiB files), data ends with file then
+            data_size = qMin<qint64>(size, file.size() - start);
+        }
+        else if(id == "LIST") {
+            QByteArray list = file.read(qMin<quint32>(size, MAX_TAG_BLOCK_SIZE));
+            if(list.startsWith("INFO")) {
+                int pos = 4;
+                while(pos + 8 <= list.size()) {
+                    QByteArray info_id = list.mid(pos, 4);
+                    int info_size = (int) le32(list.constData() + pos + 4);
+                    // size comes from file, compared without overflowing pos
+                    if(info_size < 0 || info_size > list.size() - pos - 8)
+                        break;
+
+                    QString name;
+                    if(info_id == "INAM")
+                        name = "title";
+                    else if(info_id == "IART")
+                        name = "artist";
+                    else if(info_id == "IPRD")
+                        name = "album";
+                    else if(info_id == "IGNR")
+                        name = "genre";
+                    else if(info_id == "ICRD")
+                        name = "year";
+
+                    if(!name.isEmpty()) {
+                        QString text = decode8Bit(list.mid(pos + 8, info_size), true).trimmed();
+                        if(!text.isEmpty())
+                            metadata.tags.insert(name, text);
+                    }
+
+                    // sub chunks are word aligned as well, padding of last one may pass end of list
+                    if(info_size + (info_size & 1) >= list.size() - pos - 8)
+                        break;
+                    pos += 8 + info_size + (info_size & 1);
+                }
+            }
+        }
+
+        // chunks are word aligned
+        if(!file.seek(start + size + (size & 1)))
+            break;
+    }
+
+    if(!has_format)
+        return false;
+
+    if(byte_rate > 0) {
+        metadata.bitrate = (int) ((qint64) byte_rate * 8 / 1000);
+        if(data_size > 0)
+            metadata.duration_ms = data_size * 1000 / byte_rate;
+    }
+
+    return true;
+}
+
+bool AudioMetadataReader::readMp3(QFile &file, SoundFileMetadata &metadata)
+{
+    readId3v2(file, metadata.tags);
+
+    qint64 scan_start = file.pos();
+    QByteArray buf = file.read(MP3_SCAN_SIZE);
+
+    // first position holding a frame header followed by another one (rules out stray sync bytes)
+    int pos = -1;
+    Mp3Frame frame;
+    for(int i = 0; i + 4 <= buf.size(); ++i) {
+        if((uchar) buf[i] != 0xFF || ((uchar) buf[i + 1] & 0xE0) != 0xE0)
+            continue;
+        if(!parseMp3Header(be32(buf.constData() + i), frame))
+            continue;
+
+        if(i + frame.length + 4 <= buf.size()) {
+            Mp3Frame next;
+            if(!parseMp3Header(be32(buf.constData() + i + frame.length), next) || next.sample_rate != frame.sample_rate)
+                continue;
+        }
+
+        pos = i;
+        break;
+    }
+
+    if(pos == -1)
+        return false;
+
+    metadata.sample_rate = frame.sample_rate;
+    metadata.channels = frame.channels;
+
+    qint64 audio_bytes = file.size() - (scan_start + pos) - readId3v1(file, metadata.tags);
+
+    // VBR files announce their frame count in first frame (Xing/Info or VBRI header)
+    quint32 frames = 0;
+    quint32 bytes = 0;
+    int xing = pos + 4 + frame.side_info;
+    int vbri = pos + 36;
+    if(xing + 16 <= buf.size() && (buf.mid(xing, 4) == "Xing" || buf.mid(xing, 4) == "Info")) {
+        quint32 flags = be32(buf.constData() + xing + 4);
+        int field = xing + 8;
+        if(flags & 1) {
+            frames = be32(buf.constData() + field);
+            field += 4;
+        }
+        if((flags & 2) && field + 4 <= buf.size())
+            bytes = be32(buf.constData() + field);
+    }
+    else if(vbri + 18 <= buf.size() && buf.mid(vbri, 4) == "VBRI") {
+        bytes = be32(buf.constData() + vbri + 10);
+        frames = be32(buf.constData() + vbri + 14);
+    }
+
+    if(frames > 0) {
+        metadata.duration_ms = (qint64) frames * frame.samples * 1000 / frame.sample_rate;
+        qint64 stream_bytes = bytes > 0 ? bytes : audio_bytes;
+        if(metadata.duration_ms > 0)
+            metadata.bitrate = (int) (stream_bytes * 8 / metadata.duration_ms);
+    }
+    else {
+        // constant bitrate, kbit/s equals bits per ms
+        metadata.bitrate = frame.bitrate;
+        metadata.duration_ms = audio_bytes * 8 / frame.bitrate;
+    }
+
+    return true;
+}
+
+bool AudioMetadataReader::readAsf(QFile &file, SoundFileMetadata &metadata)
+{
+    QByteArray header = file.read(30);
+    if(header.size() < 30 || !header.startsWith(ASF_HEADER_GUID))
+        return false;
+
+    qint64 end = qMin<qint64>(le64(header.constData() + 16), file.size());
+    quint32 count = le32(header.constData() + 24);
+
+    bool found = false;
+    for(quint32 n = 0; n < count && file.pos() + 24 <= end; ++n) {
+        QByteArray object = file.read(24);
+        if(object.size() < 24)
+            break;
+
+        QByteArray guid = object.left(16);
+        quint64 object_size = le64(object.constData() + 16);
+        if(object_size < 24)
+            break;
+
+        qint64 data_start = file.pos();
+        qint64 data_size = object_size - 24;
+
+        if(guid == ASF_FILE_PROPERTIES_GUID) {
+            QByteArray data = file.read(qMin<qint64>(data_size, 80));
+            if(data.size() >= 64) {
+                // play duration in 100ns units, includes preroll (ms)
+                quint64 play_duration = le64(data.constData() + 40);
+                quint64 preroll = le64(data.constData() + 56);
+                metadata.duration_ms = qMax<qint64>(0, play_duration / 10000 - preroll);
+                found = true;
+            }
+        }
+        else if(guid == ASF_STREAM_PROPERTIES_GUID) {
+            QByteArray data = file.read(qMin<qint64>(data_size, 128));
+            if(data.size() >= 54 + 16 && data.startsWith(ASF_AUDIO_MEDIA_GUID) && le32(data.constData() + 40) >= 16) {
+                // type specific data is a WAVEFORMATEX
+                char const* format = data.constData() + 54;
+                metadata.channels = le16(format + 2);
+                metadata.sample_rate = le32(format + 4);
+                metadata.bitrate = (int) ((qint64) le32(format + 8) * 8 / 1000);
+                found = true;
+            }
+        }
+        else if(guid == ASF_CONTENT_DESCRIPTION_GUID) {
+            QByteArray data = file.read(qMin<qint64>(data_size, MAX_TAG_BLOCK_SIZE));
+            if(data.size() >= 10) {
+                int title_size = le16(data.constData());
+                int author_size = le16(data.constData() + 2);
+
+                QString title = decodeUtf16(data.mid(10, title_size), true).trimmed();
+                QString author = decodeUtf16(data.mid(10 + title_size, author_size), true).trimmed();
+                if(!title.isEmpty())
+                    metadata.tags.insert("title", title);
+                if(!author.isEmpty())
+                    metadata.tags.insert("artist", author);
+            }
+        }
+
+        if(!file.seek(data_start + data_size))
+            break;
+    }
+
+    return found;
+}
+
+qint64 AudioMetadataReader::readId3v2(QFile &file, QVariantMap &tags)
+{
+    QByteArray header = file.peek(10);
+    if(header.size() < 10 || !header.startsWith("ID3"))
+        return 0;
+
+    int major = (uchar) header[3];
+    int flags = (uchar) header[5];
+
+    // size excludes header (and footer of v2.4 tags)
+    qint64 size = 10 + synchsafe32(header.constData() + 6);
+    if(major == 4 && (flags & 0x10))
+        size += 10;
+
+    qint64 start = file.pos();
+    qint64 end = start + size;
+    file.seek(start + 10);
+
+    // unsynchronised tags would need to be decoded as a whole, skip them
+    if(major < 2 || major > 4 || (major < 4 && (flags & 0x80))) {
+        file.seek(end);
+        return size;
+    }
+
+    if(major >= 3 && (flags & 0x40)) {
+        QByteArray ext = file.read(4);
+        if(ext.size() == 4) {
+            // v2.3 size excludes its own 4 bytes, v2.4 size includes them
+            qint64 ext_size = major == 3 ? be32(ext.constData()) + 4 : synchsafe32(ext.constData());
+            file.seek(file.pos() - 4 + ext_size);
+        }
+    }
+
+    int id_size = major == 2 ? 3 : 4;
+    int frame_header_size = major == 2 ? 6 : 10;
+
+    while(file.pos() + frame_header_size <= end) {
+        QByteArray frame_header = file.read(frame_header_size);
+        if(frame_header.size() < frame_header_size || frame_header[0] == '\0')
+            break; // padding
+
+        QByteArray id = frame_header.left(id_size);
+        char const* p = frame_header.constData();
+
+        qint64 frame_size;
+        if(major == 2)
+            frame_size = ((uchar) p[3] << 16) | ((uchar) p[4] << 8) | (uchar) p[5];
+        else if(major == 3)
+            frame_size = be32(p + 4);
+        else
+            frame_size = synchsafe32(p + 4);
+
+        if(frame_size <= 0 || file.pos() + frame_size > end)
+            break;
+
+        // compressed, encrypted or unsynchronised frames are not read
+        bool plain = major == 2 || p[9] == 0;
+
+        QString name = id3TagName(id);
+        if(plain && !name.isEmpty() && frame_size <= MAX_TAG_SIZE && !tags.contains(name)) {
+            QString text = decodeId3Text(file.read(frame_size));
+            if(!text.isEmpty())
+                tags.insert(name, text);
+        }
+        else {
+            file.seek(file.pos() + frame_size);
+        }
+    }
+
+    file.seek(end);
+    return size;
+}
+
+qint64 AudioMetadataReader::readId3v1(QFile &file, QVariantMap &tags)
+{
+    if(file.size() < 128)
+        return 0;
+
+    qint64 pos = file.pos();
+    file.seek(file.size() - 128);
+    QByteArray tag = file.read(128);
+    file.seek(pos);
+
+    if(tag.size() < 128 || !tag.startsWith("TAG"))
+        return 0;
+
+    QStringList names = QStringList() << "title" << "artist" << "album" << "year";
+    QList<int> offsets = QList<int>() << 3 << 33 << 63 << 93;
+    QList<int> sizes = QList<int>() << 30 << 30 << 30 << 4;
+    for(int i = 0; i < names.size(); ++i) {
+        if(tags.contains(names[i]))
+            continue;
+        QString text = decode8Bit(tag.mid(offsets[i], sizes[i]), false).trimmed();
+        if(!text.isEmpty())
+            tags.insert(names[i], text);
+    }
+
+    return 128;
+}
+
+} // namespace Resources
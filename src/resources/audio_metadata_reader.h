@@ -0,0 +1,46 @@
+#ifndef RESOURCES_AUDIO_METADATA_READER_H
+#define RESOURCES_AUDIO_METADATA_READER_H
+
+#include <QFile>
+#include <QString>
+
+#include "db/core/database_api.h"
+
+namespace Resources {
+
+/*
+ * Reads audio properties and tags of sound files from their headers,
+ * without decoding any audio. Supported are
+ * WAV (RIFF fmt/data chunks, LIST INFO tags),
+ * MP3 (first frame header, Xing/Info/VBRI frame counts, ID3v2 and ID3v1 tags) and
+ * WMA (ASF file/stream properties, content description).
+ * Only the few bytes needed get read, skipped parts (e.g. embedded pictures) get seeked over.
+ * Thread-safe, holds no state.
+*/
+class AudioMetadataReader
+{
+public:
+    /*
+     * Reads metadata of file at path into given metadata (id and mtime stay untouched).
+     * Returns false if file cannot be read or its format is not recognized.
+    */
+    static bool read(QString const& path, SoundFileMetadata& metadata);
+
+private:
+    static bool readWav(QFile& file, SoundFileMetadata& metadata);
+    static bool readMp3(QFile& file, SoundFileMetadata& metadata);
+    static bool readAsf(QFile& file, SoundFileMetadata& metadata);
+
+    /*
+     * Reads ID3v2 tag at current position (if any) into tags.
+     * Leaves file positioned behind tag. Returns size of tag (0 if none).
+    */
+    static qint64 readId3v2(QFile& file, QVariantMap& tags);
+
+    /* Reads ID3v1 tag at end of file (if any) into tags, not overriding present ones. Returns its size. */
+    static qint64 readId3v1(QFile& file, QVariantMap& tags);
+};
+
+} // namespace Resources
+
+#endif // RESOURCES_AUDIO_METADATA_READER_H
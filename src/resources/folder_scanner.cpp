@@ -0,0 +1,235 @@
+#include "folder_scanner.h"
+
+#include <QRunnable>
+#include <QDirIterator>
+#include <QDir>
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace Resources {
+
+// files handed out per batch, matches transaction size of DatabaseHandler import
+static const int BATCH_SIZE = 1000;
+
+// files a job collects before handing them to the scanner
+static const int JOB_FLUSH_SIZE = 256;
+
+// interval found files get handed out in (ms)
+static const int POLL_INTERVAL = 100;
+
+// directory listing is bound by I/O (e.g. network shares), so more jobs than cores pay off
+static const int MIN_THREADS = 2;
+static const int MAX_THREADS = 8;
+
+/*
+ * Lists one directory. Queues jobs for subdirectories,
+ * hands matching files to scanner in chunks.
+*/
+class FolderScanner::DirJob : public QRunnable
+{
+public:
+    DirJob(FolderScanner* scanner, QString const& dir)
+        : QRunnable()
+        , scanner_(scanner)
+        , dir_(dir)
+    {}
+
+    void run()
+    {
+        if(scanner_->canceled_.load() == 0)
+            list();
+
+        // last access to scanner, it may finish once pending jobs reach 0
+        scanner_->pending_.deref();
+    }
+
+private:
+    void list()
+    {
+        QList<SoundFile> files;
+
+        QDirIterator it(dir_, QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
+        while(it.hasNext()) {
+            if(scanner_->canceled_.load() != 0)
+                return;
+
+            it.next();
+            QFileInfo info = it.fileInfo();
+
+            if(info.isDir()) {
+                if(!info.isSymLink())
+                    scanner_->enqueue(info.filePath());
+                continue;
+            }
+
+            if(!scanner_->suffixes_.contains(info.suffix().toLower()))
+                continue;
+
+            files.append(SoundFile(info, scanner_->resource_dir_));
+            if(files.size() >= JOB_FLUSH_SIZE) {
+                scanner_->collect(files);
+                files.clear();
+            }
+        }
+
+        scanner_->collect(files);
+        scanner_->dir_count_.ref();
+    }
+
+    FolderScanner* scanner_;
+    QString dir_;
+};
+
+FolderScanner::FolderScanner(QObject* parent)
+    : QObject(parent)
+    , pool_()
+    , poll_timer_()
+    , suffixes_()
+    , resource_dir_()
+    , batch_size_(BATCH_SIZE)
+    , running_(false)
+    , pending_(0)
+    , canceled_(0)
+    , dir_count_(0)
+    , file_count_(0)
+    , found_mutex_()
+    , found_()
+    , reported_dirs_(0)
+    , reported_files_(0)
+{
+    setSuffixes(getDefaultSuffixes());
+    pool_.setMaxThreadCount(qBound(MIN_THREADS, QThread::idealThreadCount(), MAX_THREADS));
+
+    poll_timer_.setInterval(POLL_INTERVAL);
+    connect(&poll_timer_, SIGNAL(timeout()),
+            this, SLOT(onPoll()));
+}
+
+FolderScanner::~FolderScanner()
+{
+    // jobs reference this scanner
+    canceled_.store(1);
+    pool_.waitForDone();
+}
+
+void FolderScanner::setSuffixes(const QStringList &suffixes)
+{
+    if(running_)
+        return;
+
+    suffixes_.clear();
+    foreach(QString const& suffix, suffixes)
+        suffixes_.insert(suffix.toLower());
+}
+
+const QStringList FolderScanner::getDefaultSuffixes()
+{
+    return QStringList() << "mp3" << "wma" << "wav";
+}
+
+void FolderScanner::setBatchSize(int files)
+{
+    batch_size_ = qMax(1, files);
+}
+
+void FolderScanner::setMaxThreadCount(int threads)
+{
+    pool_.setMaxThreadCount(qMax(1, threads));
+}
+
+bool FolderScanner::start(const QString &path, const ResourceDirRecord &resource_dir)
+{
+    if(running_) {
+        qDebug() << "FAILURE: cannot start FolderScanner";
+        qDebug() << " > a scan is running already";
+        return false;
+    }
+
+    resource_dir_ = resource_dir;
+    running_ = true;
+    canceled_.store(0);
+    dir_count_.store(0);
+    file_count_.store(0);
+    reported_dirs_ = 0;
+    reported_files_ = 0;
+
+    enqueue(QDir(path).absolutePath());
+    poll_timer_.start();
+
+    return true;
+}
+
+bool FolderScanner::isRunning() const
+{
+    return running_;
+}
+
+int FolderScanner::getDirCount() const
+{
+    return dir_count_.load();
+}
+
+int FolderScanner::getFileCount() const
+{
+    return file_count_.load();
+}
+
+void FolderScanner::cancel()
+{
+    if(running_)
+        canceled_.store(1);
+}
+
+void FolderScanner::onPoll()
+{
+    // checked before taking found files, so files of all finished jobs are included
+    bool done = pending_.load() == 0;
+
+    QList<SoundFile> found;
+    {
+        QMutexLocker lock(&found_mutex_);
+        if(done || found_.size() >= batch_size_)
+            found.swap(found_);
+    }
+
+    bool canceled = canceled_.load() != 0;
+
+    if(!canceled) {
+        for(int start = 0; start < found.size(); start += batch_size_)
+            emit batchFound(found.mid(start, batch_size_));
+    }
+
+    int dirs = dir_count_.load();
+    int files = file_count_.load();
+    if(dirs != reported_dirs_ || files != reported_files_) {
+        reported_dirs_ = dirs;
+        reported_files_ = files;
+        emit progressChanged(dirs, files);
+    }
+
+    if(!done)
+        return;
+
+    poll_timer_.stop();
+    running_ = false;
+    emit finished(canceled);
+}
+
+void FolderScanner::enqueue(const QString &dir)
+{
+    pending_.ref();
+    pool_.start(new DirJob(this, dir));
+}
+
+void FolderScanner::collect(const QList<SoundFile> &files)
+{
+    if(files.isEmpty())
+        return;
+
+    QMutexLocker lock(&found_mutex_);
+    found_.append(files);
+    file_count_.fetchAndAddRelaxed(files.size());
+}
+
+} // namespace Resources
@@ -0,0 +1,109 @@
+#ifndef RESOURCES_FOLDER_SCANNER_H
+#define RESOURCES_FOLDER_SCANNER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSet>
+#include <QStringList>
+
+#include "sound_file.h"
+
+namespace Resources {
+
+/*
+ * Scans a folder tree for sound files on a pool of worker threads.
+ * Every directory is listed by its own job, which queues jobs for
+ * the subdirectories it finds, so subtrees get walked in parallel.
+ * Found files are collected and handed out in batches (see batchFound)
+ * on the thread owning the scanner, while the scan is still running.
+ * Files are accepted by (case-insensitive) suffix, looked up in a set.
+ * Symbolic links to directories are not followed.
+*/
+class FolderScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FolderScanner(QObject* parent = 0);
+    ~FolderScanner();
+
+    /* Sets accepted file suffixes (without '.'), default see getDefaultSuffixes() */
+    void setSuffixes(QStringList const& suffixes);
+
+    /* Gets suffixes of sound files imported by default (lower case, without '.') */
+    static QStringList const getDefaultSuffixes();
+
+    /* Sets number of files handed out per batch */
+    void setBatchSize(int files);
+
+    /* Sets number of directories listed in parallel */
+    void setMaxThreadCount(int threads);
+
+    /*
+     * Starts scanning folder at given path, creating SoundFiles relative to resource_dir.
+     * Returns false if a scan is running already.
+    */
+    bool start(QString const& path, ResourceDirRecord const& resource_dir);
+
+    bool isRunning() const;
+
+    /* Gets number of directories listed and files found by current (or last) scan */
+    int getDirCount() const;
+    int getFileCount() const;
+
+signals:
+    /* emitted for every batch of found files */
+    void batchFound(QList<Resources::SoundFile> const&);
+
+    /* emitted periodically while scanning */
+    void progressChanged(int dirs, int files);
+
+    /* emitted once all jobs are done, after the last batch */
+    void finished(bool canceled);
+
+public slots:
+    /*
+     * Stops scan. Queued directories are skipped, files not yet handed out are dropped.
+     * finished(true) follows once running jobs returned.
+    */
+    void cancel();
+
+private slots:
+    /* Hands out found files and checks for end of scan */
+    void onPoll();
+
+private:
+    class DirJob;
+
+    /* Queues job listing given directory */
+    void enqueue(QString const& dir);
+
+    /* Adds files found by a job */
+    void collect(QList<SoundFile> const& files);
+
+    QThreadPool pool_;
+    QTimer poll_timer_;
+
+    QSet<QString> suffixes_;
+    ResourceDirRecord resource_dir_;
+    int batch_size_;
+    bool running_;
+
+    // shared with jobs
+    QAtomicInt pending_;
+    QAtomicInt canceled_;
+    QAtomicInt dir_count_;
+    QAtomicInt file_count_;
+    QMutex found_mutex_;
+    QList<SoundFile> found_;
+
+    // progress last reported
+    int reported_dirs_;
+    int reported_files_;
+};
+
+} // namespace Resources
+
+#endif // RESOURCES_FOLDER_SCANNER_H
@@ -3,7 +3,6 @@
 #include <QFileDialog>
 #include <QHBoxLayout>
 #include <QDebug>
-#include <QDirIterator>
 #include <QDir>
 
 namespace Resources {
@@ -11,25 +10,65 @@ namespace Resources {
 Importer::Importer(ResourceDirTableModel* model, QObject *parent)
     : QObject(parent)
     , model_(model)
+    , scanner_(0)
 {
+    scanner_ = new FolderScanner(this);
+
+    connect(scanner_, SIGNAL(batchFound(QList<Resources::SoundFile> const&)),
+            this, SIGNAL(soundFilesFound(QList<Resources::SoundFile> const&)));
+    connect(scanner_, SIGNAL(progressChanged(int,int)),
+            this, SLOT(onScanProgressChanged(int,int)));
+    connect(scanner_, SIGNAL(finished(bool)),
+            this, SLOT(onScanFinished(bool)));
 }
 
 void Importer::parseFolder(const QUrl &url, const ResourceDirRecord& resource_dir)
 {
-    QList<Resources::SoundFile> files;
-    if(url.isValid() && url.isLocalFile())
-    {
-        QDir d(url.toLocalFile());
-        QDirIterator it(d.absolutePath(), QStringList() << "*.mp3" << "*.wma" << "*.wav", QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext())
-            files.append(Resources::SoundFile(QFileInfo(it.next()), resource_dir));
+    if(scanner_->isRunning())
+        return;
+
+    if(!url.isValid() || !url.isLocalFile()) {
+        emit folderImported();
+        return;
+    }
+
+    QDir d(url.toLocalFile());
+    if(scanner_->start(d.absolutePath(), resource_dir)) {
+        emit importStarted();
+        emit statusMessageUpdated(tr("Scanning %1").arg(d.absolutePath()));
     }
-    emit folderImported(files);
+}
+
+bool Importer::isImporting() const
+{
+    return scanner_->isRunning();
+}
+
+void Importer::cancelImport()
+{
+    scanner_->cancel();
+}
+
+void Importer::onScanProgressChanged(int dirs, int files)
+{
+    emit statusMessageUpdated(tr("Scanned %1 folders, found %2 sound files").arg(dirs).arg(files));
+}
+
+void Importer::onScanFinished(bool canceled)
+{
+    if(canceled)
+        emit statusMessageUpdated(tr("Import canceled"));
+    else
+        emit statusMessageUpdated(tr("Imported %1 sound files").arg(scanner_->getFileCount()));
+
     emit folderImported();
 }
 
 void Importer::startBrowseFolder(bool)
 {
+    if(scanner_->isRunning())
+        return;
+
     QUrl url = QFileDialog::getExistingDirectoryUrl(0, tr("Open Resource Directory"));
     if(url.isValid()) {
         ResourceDirRecord* rec = createOrGetResourceDir(url);
@@ -6,12 +6,15 @@
 #include <QFileInfo>
 
 #include "sound_file.h"
+#include "folder_scanner.h"
 #include "db/model/resource_dir_table_model.h"
 
 namespace Resources {
 
 /*
  * Class for importing soundfile ressources.
+ * Folders are scanned in the background (see FolderScanner),
+ * found sound files are handed out in batches while scanning.
 */
 class Importer : public QObject
 {
@@ -21,14 +24,19 @@ public:
     explicit Importer(ResourceDirTableModel* model, QObject *parent = 0);
 
     /*
-     * Imports folder with given url.
-     * Siganls folderImported(QList<Resources::SoundFile> const&)
-     * when import is finished.
+     * Starts import of folder with given url.
+     * Signals soundFilesFound(QList<Resources::SoundFile> const&) for each batch
+     * of files found and folderImported() when import is finished.
+     * Does nothing if an import is running already.
     */
     void parseFolder(QUrl const& url, const ResourceDirRecord& resource_dir);
 
+    /* Returns true while a folder is being imported */
+    bool isImporting() const;
+
 signals:
-    void folderImported(QList<Resources::SoundFile> const&);
+    void importStarted();
+    void soundFilesFound(QList<Resources::SoundFile> const&);
     void folderImported();
     void statusMessageUpdated(QString const&);
 
@@ -36,6 +44,13 @@ public slots:
     /* triggers folder import dialog and parsing of soundfiles */
     void startBrowseFolder(bool);
 
+    /* Stops running import, files handed out so far stay imported */
+    void cancelImport();
+
+private slots:
+    void onScanProgressChanged(int dirs, int files);
+    void onScanFinished(bool canceled);
+
 private:
     /*
      * Returns the ResourceDirRecord corresponding to given url.
@@ -45,6 +60,7 @@ private:
     ResourceDirRecord* createOrGetResourceDir(const QUrl& url);
 
     ResourceDirTableModel* model_;
+    FolderScanner* scanner_;
 };
 
 } // namespace Resources
@@ -0,0 +1,134 @@
+#include "metadata_extractor.h"
+
+#include <QtConcurrent>
+#include <QDebug>
+
+#include "audio_metadata_reader.h"
+#include "path_fixer.h"
+
+namespace Resources {
+
+// sound files parsed (and stored) at once
+static const int CHUNK_SIZE = 256;
+
+MetadataExtractor::MetadataExtractor(DatabaseHandler* handler, QObject* parent)
+    : QObject(parent)
+    , handler_(handler)
+    , watcher_(0)
+    , running_(false)
+    , canceled_(false)
+    , extracted_(0)
+    , total_(0)
+{
+    watcher_ = new QFutureWatcher<SoundFileMetadata>(this);
+    connect(watcher_, SIGNAL(finished()),
+            this, SLOT(onChunkParsed()));
+}
+
+MetadataExtractor::~MetadataExtractor()
+{
+    watcher_->cancel();
+    watcher_->waitForFinished();
+}
+
+bool MetadataExtractor::isRunning() const
+{
+    return running_;
+}
+
+void MetadataExtractor::extractPending()
+{
+    // running extraction picks up new files with its next chunk
+    if(running_)
+        return;
+
+    running_ = true;
+    canceled_ = false;
+    extracted_ = 0;
+    total_ = handler_->getApi()->getSoundFilesWithoutMetadataCount();
+
+    startNext();
+}
+
+void MetadataExtractor::cancel()
+{
+    if(!running_)
+        return;
+
+    canceled_ = true;
+    watcher_->cancel();
+}
+
+void MetadataExtractor::onChunkParsed()
+{
+    if(canceled_) {
+        finish();
+        return;
+    }
+
+    QList<SoundFileMetadata> metadata = watcher_->future().results();
+    if(!handler_->getApi()->updateSoundFileMetadata(metadata)) {
+        // same chunk would come up again
+        finish();
+        return;
+    }
+
+    extracted_ += metadata.size();
+    total_ = qMax(total_, extracted_);
+    emit statusMessageUpdated(tr("Reading audio metadata (%1/%2)").arg(extracted_).arg(total_));
+
+    startNext();
+}
+
+SoundFileMetadata MetadataExtractor::readMetadata(const Job &job)
+{
+    SoundFileMetadata metadata = job.metadata;
+    if(!AudioMetadataReader::read(job.path, metadata)) {
+        // keep id and file state, so file counts as done
+        SoundFileMetadata empty;
+        empty.id = metadata.id;
+        empty.mtime = metadata.mtime;
+        metadata = empty;
+    }
+
+    // identifies file content, also for formats not understood
+    metadata.fingerprint = PathFixer::computeFingerprint(job.path);
+    return metadata;
+}
+
+void MetadataExtractor::startNext()
+{
+    QList<QSqlRecord> rows = handler_->getApi()->getSoundFilesWithoutMetadata(CHUNK_SIZE);
+    if(rows.size() == 0) {
+        finish();
+        return;
+    }
+
+    QList<Job> jobs;
+    foreach(QSqlRecord const& row, rows) {
+        Job job;
+        job.path = row.value("path").toString();
+        job.metadata.id = row.value("id").toInt();
+        job.metadata.mtime = row.value("mtime").toLongLong();
+        jobs.append(job);
+    }
+
+    watcher_->setFuture(QtConcurrent::mapped(jobs, &MetadataExtractor::readMetadata));
+}
+
+void MetadataExtractor::finish()
+{
+    running_ = false;
+
+    if(extracted_ > 0) {
+        qDebug() << "NOTIFICATION: read audio metadata";
+        qDebug() << " > files:" << extracted_;
+        qDebug() << " > canceled:" << canceled_;
+
+        emit statusMessageUpdated(tr("Read audio metadata of %1 files").arg(extracted_));
+    }
+
+    emit extractionFinished(extracted_);
+}
+
+} // namespace Resources
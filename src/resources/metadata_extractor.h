@@ -0,0 +1,75 @@
+#ifndef RESOURCES_METADATA_EXTRACTOR_H
+#define RESOURCES_METADATA_EXTRACTOR_H
+
+#include <QObject>
+#include <QFutureWatcher>
+
+#include "db/database_handler.h"
+
+namespace Resources {
+
+/*
+ * Fills in audio metadata (duration, sample rate, channels, bitrate, tags)
+ * and content fingerprint (see PathFixer::computeFingerprint) of sound files lacking it
+ * (new files, or files changed since metadata was read).
+ * Files get read in chunks, headers of each chunk are parsed in parallel
+ * on worker threads (see AudioMetadataReader), then the chunk is stored in one transaction.
+ * Files which cannot be parsed get stored with empty metadata, so they are not read again
+ * unless they change. Meant to be triggered after imports and rescans.
+*/
+class MetadataExtractor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetadataExtractor(DatabaseHandler* handler, QObject* parent = 0);
+    ~MetadataExtractor();
+
+    bool isRunning() const;
+
+signals:
+    /* emitted once no sound files without metadata are left (or extraction got canceled) */
+    void extractionFinished(int files);
+
+    void statusMessageUpdated(QString const&);
+
+public slots:
+    /*
+     * Starts reading metadata of all sound files lacking it.
+     * If extraction is running already, it continues with files added meanwhile.
+    */
+    void extractPending();
+
+    /* Stops extraction after chunk being parsed (chunk does not get stored) */
+    void cancel();
+
+private slots:
+    void onChunkParsed();
+
+private:
+    struct Job {
+        QString path;
+        SoundFileMetadata metadata;
+    };
+
+    /* Reads metadata and fingerprint for given job, metadata stays empty if file cannot be parsed */
+    static SoundFileMetadata readMetadata(Job const& job);
+
+    /* Starts parsing next chunk of sound files without metadata, finishes if none left */
+    void startNext();
+
+    void finish();
+
+    DatabaseHandler* handler_;
+    QFutureWatcher<SoundFileMetadata>* watcher_;
+
+    bool running_;
+    bool canceled_;
+
+    // files stored by current run, files to store when run started
+    int extracted_;
+    int total_;
+};
+
+} // namespace Resources
+
+#endif // RESOURCES_METADATA_EXTRACTOR_H
@@ -1,9 +1,19 @@
 #include "path_fixer.h"
 
 #include <QFileInfo>
+#include <QFile>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <QDebug>
 
 namespace Resources {
 
+// bytes hashed from start, middle and end of a file
+static const qint64 FINGERPRINT_BLOCK_SIZE = 64 * 1024;
+
+// duplicate groups listed in debug output at most
+static const int MAX_REPORTED_DUPLICATES = 20;
+
 PathFixer::PathFixer(DatabaseHandler* handler, QObject *parent)
     : QObject(parent)
     , handler_(handler)
@@ -18,4 +28,69 @@ bool PathFixer::check(SoundFileRecord *rec)
     return info.exists() && info.isFile();
 }
 
+const QString PathFixer::computeFingerprint(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    qint64 size = file.size();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // size is part of the hash, so files differing in length never match
+    uchar size_bytes[8];
+    qToLittleEndian<quint64>(size, size_bytes);
+    hash.addData(reinterpret_cast<char const*>(size_bytes), 8);
+
+    if(size <= 3 * FINGERPRINT_BLOCK_SIZE) {
+        hash.addData(file.readAll());
+    }
+    else {
+        QList<qint64> offsets = QList<qint64>()
+                << 0
+                << (size - FINGERPRINT_BLOCK_SIZE) / 2
+                << size - FINGERPRINT_BLOCK_SIZE;
+
+        foreach(qint64 offset, offsets) {
+            if(!file.seek(offset))
+                return QString();
+            QByteArray block = file.read(FINGERPRINT_BLOCK_SIZE);
+            if(block.size() != FINGERPRINT_BLOCK_SIZE)
+                return QString();
+            hash.addData(block);
+        }
+    }
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+const QList<QList<int> > PathFixer::findDuplicates() const
+{
+    return handler_->getApi()->getDuplicateSoundFileIds();
+}
+
+void PathFixer::reportDuplicates()
+{
+    QList<QList<int> > groups = findDuplicates();
+    if(groups.size() == 0)
+        return;
+
+    int files = 0;
+    foreach(QList<int> const& group, groups)
+        files += group.size();
+
+    qDebug() << "NOTIFICATION: found sound files with identical content";
+    qDebug() << " > groups:" << groups.size();
+    qDebug() << " > files:" << files;
+    for(int i = 0; i < groups.size() && i < MAX_REPORTED_DUPLICATES; ++i) {
+        QStringList paths;
+        foreach(QSqlRecord const& rec, handler_->getApi()->getRecords(SOUND_FILE, groups[i]))
+            paths.append(rec.value("path").toString());
+        qDebug() << " > duplicates:" << paths;
+    }
+
+    emit duplicatesFound(groups.size(), files);
+    emit statusMessageUpdated(tr("%1 sound files share their content with another one").arg(files));
+}
+
 } // namespace SoundFile
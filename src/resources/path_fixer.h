@@ -9,6 +9,12 @@
 
 namespace Resources {
 
+/*
+ * Checks sound file paths and identifies sound files by content,
+ * so files moved on disk can be relinked and duplicates can be found.
+ * Content fingerprints hash the file size together with a few
+ * sampled blocks (start, middle and end), never the whole file.
+*/
 class PathFixer : public QObject
 {
     Q_OBJECT
@@ -18,9 +24,26 @@ public:
 
     static void remove(SoundFileRecord* rec, DatabaseHandler* handler);
     static bool check(SoundFileRecord* rec);
+
+    /*
+     * Computes content fingerprint of file at path (hex string).
+     * Reads at most 3 blocks of FINGERPRINT_BLOCK_SIZE, smaller files are hashed as a whole.
+     * Returns empty string if file cannot be read. Thread-safe.
+    */
+    static QString const computeFingerprint(QString const& path);
+
+    /* Gets groups of sound_file ids sharing their content (see DatabaseApi::getDuplicateSoundFileIds) */
+    QList<QList<int> > const findDuplicates() const;
+
 signals:
+    /* emitted by reportDuplicates, groups of files sharing content and files within these groups */
+    void duplicatesFound(int groups, int files);
+
+    void statusMessageUpdated(QString const&);
 
 public slots:
+    /* Looks up duplicates and reports them (debug output, duplicatesFound), if any */
+    void reportDuplicates();
 
 private:
     DatabaseHandler* handler_;
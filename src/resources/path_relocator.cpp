@@ -0,0 +1,296 @@
+#include "path_relocator.h"
+
+#include <QtConcurrent>
+#include <QDirIterator>
+#include <QFileDialog>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "folder_scanner.h"
+#include "path_fixer.h"
+
+namespace Resources {
+
+/* Splits path into its components (drive or root left out) */
+static QStringList const pathComponents(QString const& path)
+{
+    return QDir::fromNativeSeparators(path).split('/', QString::SkipEmptyParts);
+}
+
+/* Counts trailing components equal (case-insensitive) in both lists */
+static int sharedSuffix(QStringList const& a, QStringList const& b)
+{
+    int n = 0;
+    while(n < a.size() && n < b.size()
+          && a[a.size() - 1 - n].compare(b[b.size() - 1 - n], Qt::CaseInsensitive) == 0)
+        ++n;
+    return n;
+}
+
+PathRelocator::PathRelocator(DatabaseHandler* handler, QObject* parent)
+    : QObject(parent)
+    , handler_(handler)
+    , suffixes_()
+    , watcher_(0)
+    , report_()
+{
+    foreach(QString const& suffix, FolderScanner::getDefaultSuffixes())
+        suffixes_.insert(suffix);
+
+    watcher_ = new QFutureWatcher<Report>(this);
+    connect(watcher_, SIGNAL(finished()),
+            this, SLOT(onRelocationsFound()));
+}
+
+PathRelocator::~PathRelocator()
+{
+    watcher_->waitForFinished();
+}
+
+bool PathRelocator::isRunning() const
+{
+    return watcher_->isRunning();
+}
+
+const PathRelocator::Report &PathRelocator::getReport() const
+{
+    return report_;
+}
+
+const QString PathRelocator::formatReport(const Report &report, int max_lines)
+{
+    QStringList lines;
+
+    if(report.ambiguous.size() > 0) {
+        lines << tr("Ambiguous (%1):").arg(report.ambiguous.size());
+        for(int i = 0; i < report.ambiguous.size() && i < max_lines; ++i) {
+            lines << report.ambiguous[i].path;
+            foreach(QString const& candidate, report.ambiguous[i].candidates)
+                lines << "  ? " + candidate;
+        }
+        if(report.ambiguous.size() > max_lines)
+            lines << "  ...";
+    }
+
+    if(report.unmatched.size() > 0) {
+        if(lines.size() > 0)
+            lines << "";
+        lines << tr("Not found (%1):").arg(report.unmatched.size());
+        lines << report.unmatched.mid(0, max_lines);
+        if(report.unmatched.size() > max_lines)
+            lines << "  ...";
+    }
+
+    return lines.join("\n");
+}
+
+const PathRelocator::Report PathRelocator::findRelocations(DatabaseApi *api, const QStringList &roots,
+                                                           const QStringList &resource_dir_paths, const QSet<QString> &suffixes)
+{
+    Report report;
+    QElapsedTimer timer;
+    timer.start();
+
+    struct Missing {
+        int id;
+        QString path;
+        QString relative_path;
+        qint64 size;
+        QString fingerprint;
+    };
+
+    // missing sound files, each folder is stat'ed once for all files it holds
+    QList<Missing> missing;
+    QSet<QString> missing_names;
+    QSet<QString> present;
+    QHash<QString, bool> folder_exists;
+    foreach(QSqlRecord const& rec, api->getSoundFileLocations()) {
+        QString path = rec.value("path").toString();
+        QString folder = path.left(path.lastIndexOf('/'));
+
+        if(!folder_exists.contains(folder))
+            folder_exists.insert(folder, QFileInfo(folder).isDir());
+
+        if(folder_exists[folder] && QFileInfo(path).isFile()) {
+            present.insert(path);
+            continue;
+        }
+
+        Missing m;
+        m.id = rec.value("id").toInt();
+        m.path = path;
+        m.relative_path = rec.value("relative_path").toString();
+        m.size = rec.value("size").isNull() ? -1 : rec.value("size").toLongLong();
+        m.fingerprint = rec.value("fingerprint").toString();
+        missing.append(m);
+        missing_names.insert(QFileInfo(path).fileName().toLower());
+    }
+
+    report.missing = missing.size();
+    if(missing.isEmpty()) {
+        report.ms = timer.elapsed();
+        return report;
+    }
+
+    // candidates by lower case file name, only names of missing files get indexed
+    QVector<QFileInfo> candidates;
+    QHash<QString, QList<int> > candidates_by_name;
+    QSet<QString> indexed;
+    foreach(QString const& root, roots) {
+        QDirIterator it(root, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while(it.hasNext()) {
+            it.next();
+
+            QString name = it.fileName().toLower();
+            if(!missing_names.contains(name) || !suffixes.contains(QFileInfo(name).suffix()))
+                continue;
+
+            // known sound files stay where they are, overlapping roots list files twice
+            QString path = it.filePath();
+            if(present.contains(path) || indexed.contains(path))
+                continue;
+
+            indexed.insert(path);
+            candidates_by_name[name].append(candidates.size());
+            candidates.append(it.fileInfo());
+        }
+    }
+    report.candidates = candidates.size();
+
+    QSet<int> claimed;
+    QHash<int, QString> fingerprints;
+    foreach(Missing const& m, missing) {
+        QStringList components = pathComponents(m.path);
+        QString name = QFileInfo(m.path).fileName().toLower();
+
+        // candidates sharing most trailing folders with missing file
+        QList<int> best;
+        int best_score = 0;
+        foreach(int c, candidates_by_name.value(name)) {
+            if(claimed.contains(c))
+                continue;
+
+            int score = sharedSuffix(components, pathComponents(candidates[c].filePath()));
+            if(score > best_score) {
+                best_score = score;
+                best.clear();
+            }
+            if(score == best_score)
+                best.append(c);
+        }
+
+        if(best.isEmpty()) {
+            report.unmatched.append(m.path);
+            continue;
+        }
+
+        // known size and content rule out files only sharing the name, hashing only those of equal size
+        if(m.size >= 0 || !m.fingerprint.isEmpty()) {
+            QList<int> same;
+            foreach(int c, best) {
+                if(m.size >= 0 && candidates[c].size() != m.size)
+                    continue;
+                if(!m.fingerprint.isEmpty()) {
+                    if(!fingerprints.contains(c))
+                        fingerprints.insert(c, PathFixer::computeFingerprint(candidates[c].filePath()));
+                    if(fingerprints[c] != m.fingerprint)
+                        continue;
+                }
+                same.append(c);
+            }
+            best = same;
+        }
+
+        if(best.isEmpty()) {
+            report.unmatched.append(m.path);
+            continue;
+        }
+
+        if(best.size() > 1) {
+            Ambiguous a;
+            a.id = m.id;
+            a.path = m.path;
+            foreach(int c, best)
+                a.candidates.append(candidates[c].filePath());
+            report.ambiguous.append(a);
+            continue;
+        }
+
+        int c = best.first();
+        claimed.insert(c);
+
+        SoundFileRelocation r;
+        r.id = m.id;
+        r.info = candidates[c];
+        r.relative_path = m.relative_path;
+        foreach(QString const& dir, resource_dir_paths) {
+            if(r.info.filePath().startsWith(dir + "/")) {
+                r.relative_path = r.info.filePath().mid(dir.size());
+                break;
+            }
+        }
+
+        // stat here, not within the write transaction
+        r.info.lastModified();
+
+        report.relocated.append(r);
+    }
+
+    report.ms = timer.elapsed();
+    return report;
+}
+
+bool PathRelocator::relocate(const QStringList &roots)
+{
+    if(isRunning() || roots.isEmpty())
+        return false;
+
+    QStringList resource_dir_paths;
+    foreach(ResourceDirRecord* rec, handler_->getResourceDirTableModel()->getResourceDirs())
+        resource_dir_paths.append(rec->path);
+
+    emit statusMessageUpdated(tr("Searching missing sound files below %1").arg(roots.join(", ")));
+
+    DatabaseApi* api = handler_->getApi();
+    QSet<QString> suffixes = suffixes_;
+    watcher_->setFuture(QtConcurrent::run([api, roots, resource_dir_paths, suffixes]() -> Report {
+        return findRelocations(api, roots, resource_dir_paths, suffixes);
+    }));
+
+    return true;
+}
+
+void PathRelocator::startBrowseRoot()
+{
+    if(isRunning())
+        return;
+
+    QString root = QFileDialog::getExistingDirectory(0, tr("Find Missing Sound Files Below"));
+    if(root.size() > 0)
+        relocate(QStringList() << root);
+}
+
+void PathRelocator::onRelocationsFound()
+{
+    report_ = watcher_->result();
+
+    // transaction got rolled back, nothing was moved
+    if(report_.relocated.size() > 0 && !handler_->relocateSoundFiles(report_.relocated))
+        report_.relocated.clear();
+
+    qDebug() << "NOTIFICATION: relocated missing sound files";
+    qDebug() << " > missing:" << report_.missing;
+    qDebug() << " > candidates:" << report_.candidates;
+    qDebug() << " > relocated:" << report_.relocated.size();
+    qDebug() << " > ambiguous:" << report_.ambiguous.size();
+    qDebug() << " > unmatched:" << report_.unmatched.size();
+    qDebug() << " > ms:" << report_.ms;
+
+    emit statusMessageUpdated(tr("Relocated %1 of %2 missing sound files (%3 ambiguous)")
+                              .arg(report_.relocated.size())
+                              .arg(report_.missing)
+                              .arg(report_.ambiguous.size()));
+    emit relocationFinished(report_.relocated.size(), report_.ambiguous.size(), report_.unmatched.size());
+}
+
+} // namespace Resources
@@ -0,0 +1,105 @@
+#ifndef RESOURCES_PATH_RELOCATOR_H
+#define RESOURCES_PATH_RELOCATOR_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <QSet>
+
+#include "db/database_handler.h"
+
+namespace Resources {
+
+/*
+ * Repairs paths of sound files missing on disk (e.g. after moving the library to another disk).
+ * Candidate roots get walked once, indexing all sound files below them by file name.
+ * Each missing sound file is matched against candidates of equal name (case-insensitive)
+ * by the number of trailing path components shared with its relative path.
+ * If size or content fingerprint (see PathFixer::computeFingerprint) of the missing file
+ * is known, candidates differing in them are rejected, hashing candidates of matching size only.
+ * Matches which stay tied are reported as ambiguous.
+ * Searching runs on a worker thread, all found locations get written in one transaction.
+*/
+class PathRelocator : public QObject
+{
+    Q_OBJECT
+public:
+    /* missing sound file matching more than one candidate equally well */
+    struct Ambiguous {
+        int id;
+        QString path;
+        QStringList candidates;
+    };
+
+    struct Report {
+        int missing;
+        QList<SoundFileRelocation> relocated;
+        QList<Ambiguous> ambiguous;
+
+        // paths of missing sound files without candidate (of matching size and content)
+        QStringList unmatched;
+
+        // sound files indexed below candidate roots
+        int candidates;
+
+        qint64 ms;
+
+        Report()
+            : missing(0)
+            , relocated()
+            , ambiguous()
+            , unmatched()
+            , candidates(0)
+            , ms(0)
+        {}
+    };
+
+    explicit PathRelocator(DatabaseHandler* handler, QObject* parent = 0);
+    ~PathRelocator();
+
+    bool isRunning() const;
+
+    /* Gets report of last relocation */
+    Report const& getReport() const;
+
+    /*
+     * Gets readable listing of ambiguous and unmatched sound files of given report,
+     * listing up to max_lines of each.
+    */
+    static QString const formatReport(Report const& report, int max_lines = 1000);
+
+    /*
+     * Finds new locations of missing sound files below candidate roots, accepting files by suffix.
+     * Relative paths get rebuilt against given resource directory paths, if a new location is within one.
+     * Reads sound files through api, writes nothing. Can run on any thread.
+    */
+    static Report const findRelocations(DatabaseApi* api, QStringList const& roots,
+                                        QStringList const& resource_dir_paths, QSet<QString> const& suffixes);
+
+signals:
+    /* emitted after found locations have been written (see getReport) */
+    void relocationFinished(int relocated, int ambiguous, int unmatched);
+
+    void statusMessageUpdated(QString const&);
+
+public slots:
+    /* Starts relocating missing sound files to files below given roots. Returns false if running already. */
+    bool relocate(QStringList const& roots);
+
+    /* Asks for a root folder and relocates missing sound files below it */
+    void startBrowseRoot();
+
+private slots:
+    void onRelocationsFound();
+
+private:
+    DatabaseHandler* handler_;
+    QSet<QString> suffixes_;
+
+    QFutureWatcher<Report>* watcher_;
+    Report report_;
+};
+
+} // namespace Resources
+
+#endif // RESOURCES_PATH_RELOCATOR_H
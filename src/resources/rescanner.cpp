@@ -0,0 +1,369 @@
+#include "rescanner.h"
+
+#include <QtConcurrent>
+#include <QDirIterator>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "folder_scanner.h"
+#include "path_fixer.h"
+
+namespace Resources {
+
+// delay between last change of a watched folder and rescan (ms)
+static const int WATCH_DELAY = 2000;
+
+// folders watched at most (os limits, e.g. inotify watches per user)
+static const int MAX_WATCHED_FOLDERS = 4096;
+
+/* Gets path of folder containing given path */
+static QString const parentPath(QString const& path)
+{
+    return path.left(path.lastIndexOf('/'));
+}
+
+Rescanner::Rescanner(DatabaseHandler* handler, QObject* parent)
+    : QObject(parent)
+    , handler_(handler)
+    , suffixes_()
+    , diff_watcher_(0)
+    , current_()
+    , queue_()
+    , fs_watcher_(0)
+    , watch_timer_()
+    , changed_dirs_()
+{
+    foreach(QString const& suffix, FolderScanner::getDefaultSuffixes())
+        suffixes_.insert(suffix);
+
+    diff_watcher_ = new QFutureWatcher<Result>(this);
+    connect(diff_watcher_, SIGNAL(finished()),
+            this, SLOT(onDiffReady()));
+
+    watch_timer_.setSingleShot(true);
+    watch_timer_.setInterval(WATCH_DELAY);
+    connect(&watch_timer_, SIGNAL(timeout()),
+            this, SLOT(onWatchTimeout()));
+}
+
+Rescanner::~Rescanner()
+{
+    diff_watcher_->waitForFinished();
+}
+
+void Rescanner::rescan(const ResourceDirRecord &resource_dir, bool full)
+{
+    for(int i = 0; i < queue_.size(); ++i) {
+        if(queue_[i].first == resource_dir.id) {
+            queue_[i].second = queue_[i].second || full;
+            return;
+        }
+    }
+
+    queue_.append(qMakePair(resource_dir.id, full));
+    startNext();
+}
+
+bool Rescanner::isRunning() const
+{
+    return diff_watcher_->isRunning();
+}
+
+bool Rescanner::isWatching() const
+{
+    return fs_watcher_ != 0;
+}
+
+const SoundFileDiff Rescanner::computeDiff(DatabaseApi *api, const ResourceDirRecord &resource_dir, const QSet<QString> &suffixes, bool full, bool &changed)
+{
+    SoundFileDiff diff;
+    changed = false;
+
+    QString root = resource_dir.path;
+    if(!root.endsWith("/"))
+        root += "/";
+
+    struct Entry {
+        int id;
+        qint64 size;
+        qint64 mtime;
+        QString fingerprint;
+    };
+
+    // known files by path, and their paths by folder
+    QHash<QString, Entry> files;
+    QHash<QString, QStringList> files_by_folder;
+    foreach(QSqlRecord const& rec, api->getSoundFileManifest(root)) {
+        QString path = rec.value("path").toString();
+
+        // files imported before manifests existed have no size and mtime
+        Entry entry;
+        entry.id = rec.value("id").toInt();
+        entry.size = rec.value("size").isNull() ? -1 : rec.value("size").toLongLong();
+        entry.mtime = rec.value("mtime").isNull() ? -1 : rec.value("mtime").toLongLong();
+        entry.fingerprint = rec.value("fingerprint").toString();
+
+        files.insert(path, entry);
+        files_by_folder[parentPath(path)].append(path);
+    }
+
+    // known folders with mtime, and their paths by parent folder
+    QHash<QString, qint64> folders;
+    QHash<QString, QStringList> subfolders;
+    foreach(QSqlRecord const& rec, api->getResourceFolders(resource_dir.id)) {
+        QString path = rec.value("path").toString();
+        folders.insert(path, rec.value("mtime").toLongLong());
+        subfolders[parentPath(path)].append(path);
+    }
+
+    // imported folders are the top level folders below resource dir
+    QSet<QString> roots;
+    QStringList loose_files;
+    foreach(QString const& path, files.keys() + folders.keys()) {
+        int slash = path.indexOf('/', root.size());
+        if(slash != -1)
+            roots.insert(path.left(slash));
+        else if(files.contains(path))
+            loose_files.append(path);
+        else
+            roots.insert(path);
+    }
+
+    QSet<QString> seen;
+    auto checkFile = [&](QFileInfo const& info) {
+        if(!info.isFile())
+            return;
+
+        QString path = info.filePath();
+        if(!files.contains(path)) {
+            diff.added.append(info);
+            return;
+        }
+
+        seen.insert(path);
+        Entry const& entry = files[path];
+        if(entry.size != info.size() || entry.mtime != DatabaseApi::getManifestTime(info))
+            diff.modified.append(qMakePair(entry.id, info));
+    };
+
+    QStringList stack = roots.toList();
+    while(!stack.isEmpty()) {
+        QString folder = stack.takeLast();
+
+        // gone folders are left out, their files end up removed
+        QFileInfo folder_info(folder);
+        if(!folder_info.isDir())
+            continue;
+
+        qint64 mtime = DatabaseApi::getManifestTime(folder_info);
+        diff.folders.append(qMakePair(folder, mtime));
+
+        // entries unchanged since last walk, only known files need a stat
+        if(!full && folders.value(folder, -1) == mtime) {
+            foreach(QString const& path, files_by_folder.value(folder))
+                checkFile(QFileInfo(path));
+            stack << subfolders.value(folder);
+            continue;
+        }
+
+        QDirIterator it(folder, QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
+        while(it.hasNext()) {
+            it.next();
+            QFileInfo info = it.fileInfo();
+
+            if(info.isDir()) {
+                if(!info.isSymLink())
+                    stack.append(info.filePath());
+                continue;
+            }
+
+            if(suffixes.contains(info.suffix().toLower()))
+                checkFile(info);
+        }
+    }
+
+    // files directly in resource dir were imported one by one, only check them
+    foreach(QString const& path, loose_files)
+        checkFile(QFileInfo(path));
+
+    QHash<QString, Entry>::const_iterator it;
+    for(it = files.constBegin(); it != files.constEnd(); ++it) {
+        if(!seen.contains(it.key()))
+            diff.removed.append(it.value().id);
+    }
+
+    // removed files turning up elsewhere were moved, only new files of a removed size get hashed
+    QMultiHash<QString, int> removed_fingerprints;
+    QSet<qint64> removed_sizes;
+    QSet<int> removed_ids = diff.removed.toSet();
+    foreach(Entry const& entry, files) {
+        if(!removed_ids.contains(entry.id) || entry.fingerprint.isEmpty() || entry.size < 0)
+            continue;
+        removed_fingerprints.insert(entry.fingerprint, entry.id);
+        removed_sizes.insert(entry.size);
+    }
+
+    for(int i = diff.added.size() - 1; i >= 0 && removed_fingerprints.size() > 0; --i) {
+        QFileInfo const& info = diff.added[i];
+        if(!removed_sizes.contains(info.size()))
+            continue;
+
+        QString fingerprint = PathFixer::computeFingerprint(info.filePath());
+        if(!removed_fingerprints.contains(fingerprint))
+            continue;
+
+        int id = removed_fingerprints.value(fingerprint);
+        removed_fingerprints.remove(fingerprint, id);
+        diff.removed.removeOne(id);
+        diff.moved.append(qMakePair(id, info));
+        diff.added.removeAt(i);
+    }
+
+    changed = diff.added.size() > 0 || diff.removed.size() > 0 || diff.modified.size() > 0 || diff.moved.size() > 0;
+    if(!changed) {
+        typedef QPair<QString, qint64> Folder;
+        changed = diff.folders.size() != folders.size();
+        foreach(Folder const& folder, diff.folders) {
+            if(changed)
+                break;
+            changed = folders.value(folder.first, -1) != folder.second;
+        }
+    }
+
+    return diff;
+}
+
+void Rescanner::rescanAll()
+{
+    foreach(ResourceDirRecord* rec, handler_->getResourceDirTableModel()->getResourceDirs())
+        rescan(*rec);
+}
+
+void Rescanner::setWatching(bool watching)
+{
+    if(watching == isWatching())
+        return;
+
+    if(!watching) {
+        delete fs_watcher_;
+        fs_watcher_ = 0;
+        watch_timer_.stop();
+        changed_dirs_.clear();
+        return;
+    }
+
+    fs_watcher_ = new QFileSystemWatcher(this);
+    connect(fs_watcher_, SIGNAL(directoryChanged(QString const&)),
+            this, SLOT(onDirectoryChanged(QString const&)));
+
+    // watched folders get set once manifests are up to date
+    rescanAll();
+    if(queue_.isEmpty() && !isRunning())
+        updateWatchedFolders();
+}
+
+void Rescanner::onDiffReady()
+{
+    Result result = diff_watcher_->result();
+    SoundFileDiff const& diff = result.diff;
+
+    if(result.changed)
+        handler_->applySoundFileDiff(current_, diff);
+
+    emit rescanFinished(current_.path, diff.added.size(), diff.removed.size(), diff.modified.size());
+    emit statusMessageUpdated(tr("Rescanned %1: %2 added, %3 removed, %4 modified, %5 moved")
+                              .arg(current_.path)
+                              .arg(diff.added.size())
+                              .arg(diff.removed.size())
+                              .arg(diff.modified.size())
+                              .arg(diff.moved.size()));
+
+    if(queue_.isEmpty() && isWatching())
+        updateWatchedFolders();
+
+    startNext();
+}
+
+void Rescanner::onDirectoryChanged(const QString &path)
+{
+    foreach(ResourceDirRecord* rec, handler_->getResourceDirTableModel()->getResourceDirs()) {
+        if(path.startsWith(rec->path + "/"))
+            changed_dirs_.insert(rec->id);
+    }
+
+    // changes come in bursts (e.g. copying a folder), rescan once they settle
+    watch_timer_.start();
+}
+
+void Rescanner::onWatchTimeout()
+{
+    ResourceDirTableModel* model = handler_->getResourceDirTableModel();
+    foreach(int id, changed_dirs_) {
+        ResourceDirRecord* rec = model->getResourceDirById(id);
+        if(rec != 0)
+            rescan(*rec);
+    }
+    changed_dirs_.clear();
+}
+
+void Rescanner::startNext()
+{
+    if(isRunning() || queue_.isEmpty())
+        return;
+
+    QPair<int, bool> next = queue_.takeFirst();
+    ResourceDirRecord* rec = handler_->getResourceDirTableModel()->getResourceDirById(next.first);
+    if(rec == 0) {
+        startNext();
+        return;
+    }
+
+    current_ = *rec;
+    emit statusMessageUpdated(tr("Rescanning %1").arg(current_.path));
+
+    DatabaseApi* api = handler_->getApi();
+    ResourceDirRecord resource_dir = current_;
+    QSet<QString> suffixes = suffixes_;
+    bool full = next.second;
+    diff_watcher_->setFuture(QtConcurrent::run([api, resource_dir, suffixes, full]() -> Result {
+        QElapsedTimer timer;
+        timer.start();
+
+        Result result;
+        result.diff = computeDiff(api, resource_dir, suffixes, full, result.changed);
+
+        qDebug() << "NOTIFICATION: rescanned resource dir";
+        qDebug() << " > path:" << resource_dir.path;
+        qDebug() << " > folders:" << result.diff.folders.size();
+        qDebug() << " > ms:" << timer.elapsed();
+
+        return result;
+    }));
+}
+
+void Rescanner::updateWatchedFolders()
+{
+    if(fs_watcher_ == 0)
+        return;
+
+    QStringList folders;
+    foreach(ResourceDirRecord* rec, handler_->getResourceDirTableModel()->getResourceDirs()) {
+        foreach(QSqlRecord const& row, handler_->getApi()->getResourceFolders(rec->id))
+            folders.append(row.value("path").toString());
+    }
+
+    if(folders.size() > MAX_WATCHED_FOLDERS) {
+        qDebug() << "FAILURE: cannot watch all resource folders";
+        qDebug() << " > folders:" << folders.size();
+        qDebug() << " > watched:" << MAX_WATCHED_FOLDERS;
+        folders = folders.mid(0, MAX_WATCHED_FOLDERS);
+    }
+
+    if(fs_watcher_->directories().size() > 0)
+        fs_watcher_->removePaths(fs_watcher_->directories());
+    if(folders.size() > 0)
+        fs_watcher_->addPaths(folders);
+}
+
+} // namespace Resources
@@ -0,0 +1,99 @@
+#ifndef RESOURCES_RESCANNER_H
+#define RESOURCES_RESCANNER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+
+#include "db/database_handler.h"
+
+namespace Resources {
+
+/*
+ * Brings sound files of resource directories in line with disk.
+ * A rescan compares the folders below a resource directory against
+ * its manifest (size and mtime per file, mtime per folder) on a worker thread.
+ * Folders with unchanged mtime are not listed again, only their known files get stat'ed.
+ * Removed files found again at another path (same size and fingerprint) are relinked
+ * instead of being removed and added, so they keep their id and categories.
+ * The resulting diff gets applied in one transaction (see DatabaseHandler::applySoundFileDiff).
+ * Optionally watches all folders in the manifest and rescans
+ * resource directories shortly after any of their folders changed.
+*/
+class Rescanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Rescanner(DatabaseHandler* handler, QObject* parent = 0);
+    ~Rescanner();
+
+    /*
+     * Queues rescan of given resource directory.
+     * A full rescan lists every folder, ignoring folder mtimes
+     * (needed on file systems with coarse timestamps).
+    */
+    void rescan(ResourceDirRecord const& resource_dir, bool full = false);
+
+    bool isRunning() const;
+    bool isWatching() const;
+
+    /*
+     * Compares folders below resource_dir against its manifest, accepting files by suffix.
+     * Sets changed to false if neither files nor folders differ from manifest.
+     * Reads manifest through api, can run on any thread.
+    */
+    static SoundFileDiff const computeDiff(DatabaseApi* api, ResourceDirRecord const& resource_dir,
+                                           QSet<QString> const& suffixes, bool full, bool& changed);
+
+signals:
+    void rescanFinished(QString const& path, int added, int removed, int modified);
+    void statusMessageUpdated(QString const&);
+
+public slots:
+    /* Queues incremental rescan of all resource directories */
+    void rescanAll();
+
+    /*
+     * Starts or stops watching folders of all resource directories.
+     * Starting rescans all resource directories, so manifests are up to date.
+    */
+    void setWatching(bool watching);
+
+private slots:
+    void onDiffReady();
+    void onDirectoryChanged(QString const& path);
+    void onWatchTimeout();
+
+private:
+    struct Result {
+        SoundFileDiff diff;
+        bool changed;
+    };
+
+    /* Starts next queued rescan, if none is running */
+    void startNext();
+
+    /* Replaces watched folders with folders in manifests of all resource directories */
+    void updateWatchedFolders();
+
+    DatabaseHandler* handler_;
+    QSet<QString> suffixes_;
+
+    QFutureWatcher<Result>* diff_watcher_;
+    ResourceDirRecord current_;
+
+    // queued rescans (resource dir id, full)
+    QList<QPair<int, bool> > queue_;
+
+    QFileSystemWatcher* fs_watcher_;
+    QTimer watch_timer_;
+
+    // ids of resource dirs changed while watching
+    QSet<int> changed_dirs_;
+};
+
+} // namespace Resources
+
+#endif // RESOURCES_RESCANNER_H
@@ -0,0 +1,222 @@
+#include "audio_engine.h"
+
+#include <QCoreApplication>
+#include <QAudioDeviceInfo>
+#include <QDebug>
+
+#include "audio_voice.h"
+#include "audio_stream_decoder.h"
+#include "mix_kernels.h"
+
+// used if output device does not prefer a sample rate of its own
+static const int DEFAULT_SAMPLE_RATE = 44100;
+
+// audio decoded ahead per voice (ms)
+static const int STREAM_BUFFER_MS = 1000;
+
+// upper bound of decoder threads shared by voices
+static const int MAX_DECODER_THREADS = 4;
+
+// fade out of voices deleted while playing (ms)
+static const int DEFAULT_RELEASE_FADE = 1000;
+
+AudioEngine* AudioEngine::instance_ = nullptr;
+
+AudioEngine::AudioEngine()
+    : QObject()
+    , format_()
+    , mixer_thread_(0)
+    , mixer_(0)
+    , decoder_threads_()
+    , next_decoder_thread_(0)
+    , next_stream_id_(0)
+    , voices_()
+    , released_()
+    , release_fade_(DEFAULT_RELEASE_FADE)
+{
+    QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    int sample_rate = device.preferredFormat().sampleRate();
+
+    format_.setSampleRate(sample_rate > 0 ? sample_rate : DEFAULT_SAMPLE_RATE);
+    format_.setChannelCount(2);
+    format_.setSampleSize(16);
+    format_.setSampleType(QAudioFormat::SignedInt);
+    format_.setByteOrder(QAudioFormat::LittleEndian);
+    format_.setCodec("audio/pcm");
+
+    if(!device.isFormatSupported(format_)) {
+        format_.setSampleRate(DEFAULT_SAMPLE_RATE);
+        if(!device.isFormatSupported(format_)) {
+            qDebug() << "FAILURE: audio output does not support 16 bit stereo";
+            qDebug() << " > device:" << device.deviceName();
+        }
+    }
+
+    mixer_thread_ = new QThread(this);
+    mixer_ = new AudioMixer(format_);
+    mixer_->moveToThread(mixer_thread_);
+    connect(mixer_thread_, SIGNAL(finished()),
+            mixer_, SLOT(deleteLater()));
+    connect(mixer_, SIGNAL(streamDrained(int, int)),
+            this, SLOT(onStreamDrained(int, int)));
+    connect(mixer_, SIGNAL(streamRampFinished(int, int)),
+            this, SLOT(onStreamRampFinished(int, int)));
+    connect(mixer_, SIGNAL(streamPositionReached(int, int)),
+            this, SLOT(onStreamPositionReached(int, int)));
+    mixer_thread_->start(QThread::HighestPriority);
+    QMetaObject::invokeMethod(mixer_, "start", Qt::QueuedConnection);
+
+    int decoder_thread_count = qBound(1, QThread::idealThreadCount() / 2, MAX_DECODER_THREADS);
+    for(int i = 0; i < decoder_thread_count; ++i) {
+        QThread* thread = new QThread(this);
+        thread->start();
+        decoder_threads_.append(thread);
+    }
+
+    connect(qApp, SIGNAL(aboutToQuit()),
+            this, SLOT(shutdown()));
+
+    qDebug() << "NOTIFICATION: started audio engine";
+    qDebug() << " > sample rate:" << format_.sampleRate();
+    qDebug() << " > decoder threads:" << decoder_thread_count;
+    qDebug() << " > sse2:" << MixKernels::usesSse2();
+}
+
+AudioEngine* AudioEngine::instance() {
+    if(!instance_) {
+        instance_ = new AudioEngine;
+    }
+    return instance_;
+}
+
+AudioEngine::~AudioEngine()
+{
+    shutdown();
+    instance_ = nullptr;
+}
+
+const QAudioFormat &AudioEngine::getFormat() const
+{
+    return format_;
+}
+
+const AudioStreamPtr AudioEngine::attach(AudioVoice *voice)
+{
+    int capacity = format_.sampleRate() * 2 * STREAM_BUFFER_MS / 1000;
+    AudioStreamPtr stream(new AudioStream(++next_stream_id_, capacity));
+    voices_.insert(stream->id, voice);
+    mixer_->addStream(stream);
+    return stream;
+}
+
+void AudioEngine::release(const AudioStreamPtr &stream, AudioStreamDecoder *decoder, int fade_out)
+{
+    voices_.remove(stream->id);
+
+    // silent or mixer gone, nothing to fade
+    if(fade_out <= 0 || stream->playing.load() == 0 || !mixer_thread_->isRunning()) {
+        if(mixer_thread_->isRunning())
+            mixer_->removeStream(stream);
+
+        deleteDecoder(decoder);
+        return;
+    }
+
+    ReleasedStream released;
+    released.stream = stream;
+    released.decoder = decoder;
+    released.serial = stream->ramp(0.0f, toFrames(fade_out), EqualPowerRamp);
+    released_.insert(stream->id, released);
+}
+
+void AudioEngine::setReleaseFade(int fade_out)
+{
+    release_fade_ = qMax(0, fade_out);
+}
+
+int AudioEngine::getReleaseFade() const
+{
+    return release_fade_;
+}
+
+int AudioEngine::toFrames(qint64 ms) const
+{
+    return (int) (ms * format_.sampleRate() / 1000);
+}
+
+QThread *AudioEngine::getDecoderThread()
+{
+    QThread* thread = decoder_threads_[next_decoder_thread_];
+    next_decoder_thread_ = (next_decoder_thread_ + 1) % decoder_threads_.size();
+    return thread;
+}
+
+void AudioEngine::onStreamDrained(int id, int generation)
+{
+    if(released_.contains(id)) {
+        finishRelease(id);
+        return;
+    }
+
+    AudioVoice* voice = voices_.value(id, 0);
+    if(voice)
+        voice->onStreamDrained(generation);
+}
+
+void AudioEngine::onStreamRampFinished(int id, int serial)
+{
+    // ramps commanded by voice before its release may still finish
+    if(released_.contains(id)) {
+        if(released_[id].serial == serial)
+            finishRelease(id);
+        return;
+    }
+
+    AudioVoice* voice = voices_.value(id, 0);
+    if(voice)
+        voice->onStreamRampFinished(serial);
+}
+
+void AudioEngine::onStreamPositionReached(int id, int generation)
+{
+    AudioVoice* voice = voices_.value(id, 0);
+    if(voice)
+        voice->onStreamPositionReached(generation);
+}
+
+void AudioEngine::finishRelease(int id)
+{
+    ReleasedStream released = released_.take(id);
+    if(mixer_thread_->isRunning())
+        mixer_->removeStream(released.stream);
+    deleteDecoder(released.decoder);
+}
+
+void AudioEngine::deleteDecoder(AudioStreamDecoder *decoder)
+{
+    // decoder gets deleted on its own thread,
+    // once that has stopped no event loop is left to do so
+    if(decoder->thread()->isRunning())
+        decoder->deleteLater();
+    else
+        delete decoder;
+}
+
+void AudioEngine::shutdown()
+{
+    if(!mixer_thread_->isRunning())
+        return;
+
+    QMetaObject::invokeMethod(mixer_, "stop", Qt::BlockingQueuedConnection);
+    mixer_thread_->quit();
+    mixer_thread_->wait();
+
+    foreach(QThread* thread, decoder_threads_) {
+        thread->quit();
+        thread->wait();
+    }
+
+    // fade outs still pending will not finish anymore
+    foreach(int id, released_.keys())
+        finishRelease(id);
+}
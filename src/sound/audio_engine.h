@@ -0,0 +1,99 @@
+#ifndef SOUND_AUDIO_ENGINE_H
+#define SOUND_AUDIO_ENGINE_H
+
+#include <QObject>
+#include <QAudioFormat>
+#include <QThread>
+#include <QHash>
+#include <QList>
+
+#include "audio_mixer.h"
+
+class AudioVoice;
+class AudioStreamDecoder;
+
+/*
+ * Shared audio engine all AudioVoices play through.
+ * Owns one AudioMixer on a thread of its own, feeding a single
+ * audio output, and a few decoder threads voices get spread across.
+ * This keeps the number of threads and open output devices constant,
+ * no matter how many tiles play at once.
+ * Voices deleted while playing (e.g. tiles of a layout switched away from)
+ * do not cut off, their streams fade out before leaving the mix.
+ * All functions are to be called from the main thread.
+*/
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+public:
+    static AudioEngine* instance();
+    virtual ~AudioEngine();
+
+    // delete copy and move c'tors
+    AudioEngine(const AudioEngine &) = delete;
+    AudioEngine(AudioEngine &&) = delete;
+
+    // delete assign operator
+    void operator=(const AudioEngine&) = delete;
+    void operator=(AudioEngine&&) = delete;
+
+    /* Gets format of output (interleaved stereo, 16 bit) */
+    QAudioFormat const& getFormat() const;
+
+    /* Creates stream for voice and adds it to mix */
+    AudioStreamPtr const attach(AudioVoice* voice);
+
+    /*
+     * Takes stream and decoder of a voice being deleted.
+     * Stream fades out over fade_out (ms) and leaves the mix once silent
+     * or drained, decoder gets deleted then. Both are released at once given no fade.
+    */
+    void release(AudioStreamPtr const& stream, AudioStreamDecoder* decoder, int fade_out);
+
+    /* Sets fade out of voices deleted while playing (ms, default 1000) */
+    void setReleaseFade(int fade_out);
+    int getReleaseFade() const;
+
+    /* Converts duration (ms) to frames at output sample rate */
+    int toFrames(qint64 ms) const;
+
+    /* Gets decoder thread for next voice (round robin) */
+    QThread* getDecoderThread();
+
+private slots:
+    void onStreamDrained(int id, int generation);
+    void onStreamRampFinished(int id, int serial);
+    void onStreamPositionReached(int id, int generation);
+
+    /* Stops mixer and decoder threads, finishes pending releases */
+    void shutdown();
+
+private:
+    AudioEngine();
+
+    /* Removes stream released before from mix and deletes its decoder */
+    void finishRelease(int id);
+
+    /* Deletes decoder on its thread, or directly if that has stopped */
+    void deleteDecoder(AudioStreamDecoder* decoder);
+
+    struct ReleasedStream {
+        AudioStreamPtr stream;
+        AudioStreamDecoder* decoder;
+        int serial;     // of fade out ramp
+    };
+
+    QAudioFormat format_;
+    QThread* mixer_thread_;
+    AudioMixer* mixer_;
+    QList<QThread*> decoder_threads_;
+    int next_decoder_thread_;
+    int next_stream_id_;
+    QHash<int, AudioVoice*> voices_;
+    QHash<int, ReleasedStream> released_;
+    int release_fade_;
+
+    static AudioEngine* instance_;
+};
+
+#endif // SOUND_AUDIO_ENGINE_H
@@ -0,0 +1,219 @@
+#include "audio_mixer.h"
+
+#include <QDebug>
+#include <cstring>
+#include <cmath>
+
+#include "mix_kernels.h"
+
+// interval output buffer gets topped up in (ms)
+static const int PUSH_INTERVAL = 5;
+
+// output buffer size (ms), bounds latency of volume changes and activation
+static const int OUTPUT_BUFFER_MS = 80;
+
+// frames mixed at once, if output does not report a period size
+static const int DEFAULT_PERIOD_FRAMES = 512;
+
+// frames ramp curves get evaluated at, gain changes linearly in between
+static const int RAMP_SEGMENT_FRAMES = 64;
+
+static const float HALF_PI = 1.57079632679f;
+
+AudioMixer::AudioMixer(const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , format_(format)
+    , output_(0)
+    , device_(0)
+    , push_timer_(0)
+    , streams_mutex_()
+    , streams_()
+    , mix_buffer_()
+    , read_buffer_()
+    , out_buffer_()
+{}
+
+AudioMixer::~AudioMixer()
+{
+    stop();
+}
+
+void AudioMixer::addStream(const AudioStreamPtr &stream)
+{
+    QMutexLocker locker(&streams_mutex_);
+    if(!streams_.contains(stream))
+        streams_.append(stream);
+}
+
+void AudioMixer::removeStream(const AudioStreamPtr &stream)
+{
+    QMutexLocker locker(&streams_mutex_);
+    streams_.removeAll(stream);
+}
+
+void AudioMixer::start()
+{
+    if(output_ != 0)
+        return;
+
+    output_ = new QAudioOutput(format_, this);
+    output_->setBufferSize(format_.bytesForDuration(OUTPUT_BUFFER_MS * 1000));
+    device_ = output_->start();
+
+    if(device_ == 0 || output_->error() != QAudio::NoError) {
+        qDebug() << "FAILURE: could not open audio output";
+        qDebug() << " > format:" << format_;
+        qDebug() << " > error:" << output_->error();
+        delete output_;
+        output_ = 0;
+        device_ = 0;
+        return;
+    }
+
+    push_timer_ = new QTimer(this);
+    push_timer_->setTimerType(Qt::PreciseTimer);
+    push_timer_->setInterval(PUSH_INTERVAL);
+    connect(push_timer_, SIGNAL(timeout()),
+            this, SLOT(onPush()));
+    push_timer_->start();
+
+    // fill output buffer right away, so playback starts without a gap
+    onPush();
+}
+
+void AudioMixer::stop()
+{
+    if(push_timer_ != 0) {
+        push_timer_->stop();
+        delete push_timer_;
+        push_timer_ = 0;
+    }
+
+    if(output_ != 0) {
+        output_->stop();
+        delete output_;
+        output_ = 0;
+        device_ = 0;
+    }
+}
+
+void AudioMixer::onPush()
+{
+    if(device_ == 0)
+        return;
+
+    int frame_bytes = format_.bytesPerFrame();
+    int period = output_->periodSize();
+    if(period <= 0)
+        period = DEFAULT_PERIOD_FRAMES * frame_bytes;
+
+    int frames = period / frame_bytes;
+    while(output_->bytesFree() >= period) {
+        mix(frames);
+        device_->write(reinterpret_cast<char const*>(out_buffer_.constData()), frames * frame_bytes);
+    }
+}
+
+void AudioMixer::mix(int frames)
+{
+    int samples = frames * 2;
+    if(mix_buffer_.size() < samples) {
+        mix_buffer_.resize(samples);
+        read_buffer_.resize(samples);
+        out_buffer_.resize(samples);
+    }
+    std::memset(mix_buffer_.data(), 0, samples * sizeof(float));
+
+    QMutexLocker locker(&streams_mutex_);
+    foreach(AudioStreamPtr const& stream, streams_) {
+        // buffer may still hold audio of source played before
+        int generation = stream->primed.loadAcquire();
+        if(stream->playing.load() == 0 || generation != stream->generation.load())
+            continue;
+
+        QMutexLocker reset_locker(&stream->reset_mutex);
+
+        int read = stream->buffer.read(read_buffer_.data(), samples);
+        updateRamp(stream.data());
+        if(read > 0) {
+            mixStream(stream.data(), read / 2);
+
+            qint64 played = stream->frames_played.fetchAndAddRelaxed(read / 2) + read / 2;
+            qint64 notify = stream->notify_frame.load();
+            if(notify >= 0 && played >= notify && stream->notify_frame.testAndSetOrdered(notify, -1))
+                emit streamPositionReached(stream->id, generation);
+        }
+
+        // end of source played, notify once
+        if(read < samples && stream->decoded.load() != 0 && stream->buffer.available() == 0
+                && stream->drained.testAndSetOrdered(0, 1))
+            emit streamDrained(stream->id, generation);
+    }
+    locker.unlock();
+
+    MixKernels::toInt16(out_buffer_.data(), mix_buffer_.constData(), samples);
+}
+
+void AudioMixer::mixStream(AudioStream *stream, int frames)
+{
+    float pan_l, pan_r;
+    MixKernels::panGains(1.0f, stream->pan.load(), pan_l, pan_r);
+
+    float* out = mix_buffer_.data();
+    float const* in = read_buffer_.constData();
+    int mixed = 0;
+
+    // ramp in segments, so curves get followed closely by a linear kernel
+    while(mixed < frames && stream->mixer_ramp.done < stream->mixer_ramp.total) {
+        int n = qMin(frames - mixed, qMin(RAMP_SEGMENT_FRAMES, stream->mixer_ramp.total - stream->mixer_ramp.done));
+        stream->mixer_ramp.done += n;
+
+        float from = stream->mixer_ramp.current;
+        float to = rampGain(stream->mixer_ramp.start, stream->mixer_ramp.target, stream->mixer_ramp.curve,
+                            stream->mixer_ramp.done / (float) stream->mixer_ramp.total);
+        float step = (to - from) / n;
+        MixKernels::mixStereoRamp(out + 2 * mixed, in + 2 * mixed, n,
+                                  from * pan_l, from * pan_r, step * pan_l, step * pan_r);
+        stream->mixer_ramp.current = to;
+        mixed += n;
+
+        if(stream->mixer_ramp.done == stream->mixer_ramp.total) {
+            stream->mixer_ramp.current = stream->mixer_ramp.target;
+            emit streamRampFinished(stream->id, stream->mixer_ramp.serial);
+        }
+    }
+
+    if(mixed < frames) {
+        float gain = stream->mixer_ramp.current;
+        MixKernels::mixStereo(out + 2 * mixed, in + 2 * mixed, frames - mixed, gain * pan_l, gain * pan_r);
+    }
+}
+
+void AudioMixer::updateRamp(AudioStream *stream)
+{
+    int serial = stream->ramp_serial.loadAcquire();
+    if(serial == stream->mixer_ramp.serial)
+        return;
+
+    // fields of command got stored before its serial, acquire pairs with ordered increment in ramp()
+    float from = stream->ramp_from.load();
+    stream->mixer_ramp.serial = serial;
+    stream->mixer_ramp.start = from < 0.0f ? stream->mixer_ramp.current : from;
+    stream->mixer_ramp.target = stream->gain.load();
+    stream->mixer_ramp.curve = stream->ramp_curve.load();
+    stream->mixer_ramp.total = stream->ramp_frames.load();
+    stream->mixer_ramp.done = 0;
+    stream->mixer_ramp.current = stream->mixer_ramp.total > 0 ? stream->mixer_ramp.start
+                                                             : stream->mixer_ramp.target;
+}
+
+float AudioMixer::rampGain(float start, float target, int curve, float progress)
+{
+    if(curve == EqualPowerRamp) {
+        // rises like sine and falls like cosine, a fade in and a fade out sum up to constant power
+        if(target >= start)
+            return start + (target - start) * std::sin(progress * HALF_PI);
+        return target + (start - target) * std::cos(progress * HALF_PI);
+    }
+    return start + (target - start) * progress;
+}
@@ -0,0 +1,179 @@
+#ifndef SOUND_AUDIO_MIXER_H
+#define SOUND_AUDIO_MIXER_H
+
+#include <QObject>
+#include <QAudioFormat>
+#include <QAudioOutput>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+
+#include "audio_ring_buffer.h"
+
+/*
+ * Shapes of gain ramps. Linear changes amplitude evenly,
+ * EqualPower follows a quarter sine, so crossfading streams keep their summed power.
+*/
+enum RampCurve {
+    LinearRamp = 0,
+    EqualPowerRamp = 1
+};
+
+/*
+ * Decoded audio of one voice, shared between its AudioVoice (control),
+ * its AudioStreamDecoder (producer) and the AudioMixer (consumer).
+ * Stream state of a source (buffer, decoded, drained, frames_played) gets reset
+ * by the decoder once it starts on the source, the mixer only mixes a stream
+ * after the decoder primed it for the generation the voice requested.
+ * Samples are interleaved stereo floats at the engine sample rate.
+ * Gain changes get commanded as ramps (see ramp()), the mixer applies them
+ * sample by sample from the frame it picks them up.
+*/
+struct AudioStream {
+    int id;
+    AudioRingBuffer buffer;
+
+    // held by mixer while reading and by decoder while clearing buffer
+    QMutex reset_mutex;
+
+    std::atomic<float> gain;        // linear target of last ramp, 1.0 is unchanged
+    std::atomic<float> ramp_from;   // gain ramp starts at, negative to start at current gain
+    QAtomicInt ramp_frames;         // length of ramp, 0 to jump
+    QAtomicInt ramp_curve;          // RampCurve
+    QAtomicInt ramp_serial;         // counts ramp commands, published last
+
+    std::atomic<float> pan;     // -1 (left) to 1 (right)
+
+    QAtomicInt playing;         // mixed, unless 0 (or buffer not primed for generation yet)
+    QAtomicInt decoded;         // decoder reached end of source
+    QAtomicInt drained;         // mixer played all of decoded source
+    QAtomicInt generation;      // counts starts of source requested by voice, tells apart stale notifications
+    QAtomicInt primed;          // generation buffer got reset and primed for by decoder, published last
+    QAtomicInteger<qint64> frames_played;
+    QAtomicInteger<qint64> notify_frame;   // frames_played to notify at once, negative if none
+
+    // ramp in progress, accessed by mixer only
+    struct {
+        int serial;
+        float start;
+        float target;
+        float current;
+        int curve;
+        int done;
+        int total;
+    } mixer_ramp;
+
+    AudioStream(int i, int capacity)
+        : id(i)
+        , buffer(capacity)
+        , reset_mutex()
+        , gain(1.0f)
+        , ramp_from(-1.0f)
+        , ramp_frames(0)
+        , ramp_curve(LinearRamp)
+        , ramp_serial(0)
+        , pan(0.0f)
+        , playing(0)
+        , decoded(0)
+        , drained(0)
+        , generation(0)
+        , primed(0)
+        , frames_played(0)
+        , notify_frame(-1)
+    {
+        mixer_ramp.serial = 0;
+        mixer_ramp.start = 1.0f;
+        mixer_ramp.target = 1.0f;
+        mixer_ramp.current = 1.0f;
+        mixer_ramp.curve = LinearRamp;
+        mixer_ramp.done = 0;
+        mixer_ramp.total = 0;
+    }
+
+    /*
+     * Commands a gain ramp to target over frames (0 jumps), starting at from
+     * or at the gain the stream has when the mixer picks the ramp up (from < 0).
+     * Replaces ramp in progress. Returns serial of ramp (see AudioMixer::streamRampFinished).
+     * To be called from one controlling thread at a time.
+    */
+    int ramp(float target, int frames, RampCurve curve = LinearRamp, float from = -1.0f)
+    {
+        gain.store(target);
+        ramp_from.store(from);
+        ramp_frames.store(qMax(0, frames));
+        ramp_curve.store(curve);
+        return ramp_serial.fetchAndAddOrdered(1) + 1;
+    }
+};
+
+typedef QSharedPointer<AudioStream> AudioStreamPtr;
+
+/*
+ * Mixes all playing AudioStreams into one QAudioOutput (push mode).
+ * Lives on a thread of its own (see AudioEngine), a timer tops up the
+ * output buffer period by period. Streams running short (decoder behind)
+ * are mixed with what they have, never waited for.
+ * Writes silence while no stream is playing.
+*/
+class AudioMixer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioMixer(QAudioFormat const& format, QObject* parent = 0);
+    ~AudioMixer();
+
+    /* Adds stream to mix (thread-safe) */
+    void addStream(AudioStreamPtr const& stream);
+
+    /* Removes stream from mix, mixer does not access it anymore once returned (thread-safe) */
+    void removeStream(AudioStreamPtr const& stream);
+
+signals:
+    /* emitted once a stream played all of its decoded source */
+    void streamDrained(int id, int generation);
+
+    /* emitted once a ramp of given serial reached its target (ramps of 0 frames excluded) */
+    void streamRampFinished(int id, int serial);
+
+    /* emitted once a stream played up to its notify_frame */
+    void streamPositionReached(int id, int generation);
+
+public slots:
+    /* Opens output, to be called on mixer thread */
+    void start();
+
+    /* Closes output */
+    void stop();
+
+private slots:
+    void onPush();
+
+private:
+    /* Mixes frames of all playing streams into out_buffer_ */
+    void mix(int frames);
+
+    /* Adds frames read for stream to mix_buffer_, advancing its gain ramp */
+    void mixStream(AudioStream* stream, int frames);
+
+    /* Takes over ramp command of stream, if a new one got published */
+    static void updateRamp(AudioStream* stream);
+
+    /* Gain of ramp at progress (0 to 1) */
+    static float rampGain(float start, float target, int curve, float progress);
+
+    QAudioFormat format_;
+    QAudioOutput* output_;
+    QIODevice* device_;
+    QTimer* push_timer_;
+
+    QMutex streams_mutex_;
+    QList<AudioStreamPtr> streams_;
+
+    QVector<float> mix_buffer_;
+    QVector<float> read_buffer_;
+    QVector<qint16> out_buffer_;
+};
+
+#endif // SOUND_AUDIO_MIXER_H
@@ -0,0 +1,74 @@
+#include "audio_ring_buffer.h"
+
+#include <cstring>
+
+AudioRingBuffer::AudioRingBuffer(int capacity)
+    : data_()
+    , mask_(0)
+    , read_pos_(0)
+    , write_pos_(0)
+{
+    quint32 size = 1;
+    while(size < (quint32) qMax(capacity, 1))
+        size <<= 1;
+
+    data_.fill(0.0f, (int) size);
+    mask_ = size - 1;
+}
+
+int AudioRingBuffer::capacity() const
+{
+    return data_.size();
+}
+
+int AudioRingBuffer::available() const
+{
+    return (int) ((quint32) write_pos_.loadAcquire() - (quint32) read_pos_.loadAcquire());
+}
+
+int AudioRingBuffer::free() const
+{
+    return capacity() - available();
+}
+
+int AudioRingBuffer::write(const float *data, int count)
+{
+    quint32 write_pos = (quint32) write_pos_.load();
+    quint32 read_pos = (quint32) read_pos_.loadAcquire();
+
+    int n = qMin(count, capacity() - (int) (write_pos - read_pos));
+    if(n <= 0)
+        return 0;
+
+    // copy in up to two parts, split where buffer wraps
+    int start = (int) (write_pos & mask_);
+    int first = qMin(n, capacity() - start);
+    std::memcpy(data_.data() + start, data, first * sizeof(float));
+    std::memcpy(data_.data(), data + first, (n - first) * sizeof(float));
+
+    write_pos_.storeRelease((int) (write_pos + n));
+    return n;
+}
+
+int AudioRingBuffer::read(float *data, int count)
+{
+    quint32 read_pos = (quint32) read_pos_.load();
+    quint32 write_pos = (quint32) write_pos_.loadAcquire();
+
+    int n = qMin(count, (int) (write_pos - read_pos));
+    if(n <= 0)
+        return 0;
+
+    int start = (int) (read_pos & mask_);
+    int first = qMin(n, capacity() - start);
+    std::memcpy(data, data_.constData() + start, first * sizeof(float));
+    std::memcpy(data + first, data_.constData(), (n - first) * sizeof(float));
+
+    read_pos_.storeRelease((int) (read_pos + n));
+    return n;
+}
+
+void AudioRingBuffer::clear()
+{
+    read_pos_.storeRelease(write_pos_.loadAcquire());
+}
@@ -0,0 +1,47 @@
+#ifndef SOUND_AUDIO_RING_BUFFER_H
+#define SOUND_AUDIO_RING_BUFFER_H
+
+#include <QVector>
+#include <QAtomicInt>
+
+/*
+ * Lock-free ring buffer of float samples, for exactly one producer thread
+ * (writing) and one consumer thread (reading).
+ * Capacity gets rounded up to a power of two. Read and write positions
+ * only ever grow (wrapping around as unsigned ints), so a full buffer can be told
+ * apart from an empty one without sacrificing a slot.
+*/
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(int capacity);
+
+    /* Gets number of samples the buffer holds at most */
+    int capacity() const;
+
+    /* Gets number of samples ready to be read (exact on consumer thread) */
+    int available() const;
+
+    /* Gets number of samples which can be written (exact on producer thread) */
+    int free() const;
+
+    /* Writes up to count samples (producer thread). Returns number written. */
+    int write(float const* data, int count);
+
+    /* Reads up to count samples (consumer thread). Returns number read. */
+    int read(float* data, int count);
+
+    /*
+     * Drops all samples. Neither producer nor consumer may access
+     * the buffer at the same time (see AudioStream::reset_mutex).
+    */
+    void clear();
+
+private:
+    QVector<float> data_;
+    quint32 mask_;
+    QAtomicInt read_pos_;
+    QAtomicInt write_pos_;
+};
+
+#endif // SOUND_AUDIO_RING_BUFFER_H
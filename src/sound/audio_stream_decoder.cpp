@@ -0,0 +1,240 @@
+#include "audio_stream_decoder.h"
+
+#include <QDebug>
+#include <cstring>
+
+#include "mix_kernels.h"
+
+// interval buffer gets topped up in while decoder waits for room (ms)
+static const int REFILL_INTERVAL = 20;
+
+AudioStreamDecoder::AudioStreamDecoder(const AudioStreamPtr &stream, const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , stream_(stream)
+    , format_(format)
+    , decoder_(0)
+    , refill_timer_(0)
+    , path_()
+    , head_()
+    , head_pos_(0)
+    , skip_(0)
+    , pending_()
+    , pending_pos_(0)
+    , finished_(false)
+    , format_warned_(false)
+{
+    refill_timer_ = new QTimer(this);
+    refill_timer_->setInterval(REFILL_INTERVAL);
+    connect(refill_timer_, SIGNAL(timeout()),
+            this, SLOT(onBufferReady()));
+}
+
+AudioStreamDecoder::~AudioStreamDecoder()
+{
+    if(decoder_ != 0)
+        decoder_->stop();
+}
+
+void AudioStreamDecoder::start(const QString &path, AudioHeadPtr head, int generation)
+{
+    stop();
+
+    // on this thread, so end of source played before cannot mark new one decoded
+    stream_->decoded.store(0);
+    stream_->drained.store(0);
+    stream_->frames_played.store(0);
+
+    path_ = path;
+    head_ = head;
+    skip_ = head_ ? head_->samples.size() : 0;
+    refill_timer_->start();
+
+    // whole file in memory, nothing to decode
+    if(head_ && head_->complete) {
+        finished_ = true;
+        pull();
+        stream_->primed.storeRelease(generation);
+        emit durationChanged(path_, (qint64) head_->samples.size() / 2 * 1000 / format_.sampleRate());
+        return;
+    }
+
+    // created on first use, so idle voices do not hold a decoder
+    if(decoder_ == 0) {
+        decoder_ = new QAudioDecoder(this);
+        connect(decoder_, SIGNAL(bufferReady()),
+                this, SLOT(onBufferReady()));
+        connect(decoder_, SIGNAL(finished()),
+                this, SLOT(onFinished()));
+        connect(decoder_, SIGNAL(error(QAudioDecoder::Error)),
+                this, SLOT(onError(QAudioDecoder::Error)));
+        connect(decoder_, SIGNAL(durationChanged(qint64)),
+                this, SLOT(onDurationChanged(qint64)));
+    }
+
+    QAudioFormat decoded_format(format_);
+    decoded_format.setSampleType(QAudioFormat::Float);
+    decoded_format.setSampleSize(32);
+    decoder_->setAudioFormat(decoded_format);
+    decoder_->setSourceFilename(path);
+    decoder_->start();
+
+    // head goes into stream buffer right away
+    pull();
+    stream_->primed.storeRelease(generation);
+}
+
+void AudioStreamDecoder::stop()
+{
+    refill_timer_->stop();
+    if(decoder_ != 0)
+        decoder_->stop();
+
+    head_.clear();
+    head_pos_ = 0;
+    skip_ = 0;
+    pending_.clear();
+    pending_pos_ = 0;
+    finished_ = false;
+
+    QMutexLocker locker(&stream_->reset_mutex);
+    stream_->primed.store(0);
+    stream_->buffer.clear();
+}
+
+void AudioStreamDecoder::onBufferReady()
+{
+    pull();
+}
+
+void AudioStreamDecoder::onFinished()
+{
+    finished_ = true;
+    pull();
+}
+
+void AudioStreamDecoder::onError(QAudioDecoder::Error err)
+{
+    qDebug() << "FAILURE: could not decode sound file";
+    qDebug() << " > path:" << decoder_->sourceFilename();
+    qDebug() << " > error:" << err << decoder_->errorString();
+
+    // let stream drain, so voice finishes instead of hanging
+    finished_ = true;
+    pull();
+
+    emit error(decoder_->errorString());
+}
+
+void AudioStreamDecoder::onDurationChanged(qint64 duration)
+{
+    if(duration >= 0)
+        emit durationChanged(path_, duration);
+}
+
+void AudioStreamDecoder::pull()
+{
+    forever {
+        int head_size = head_ ? head_->samples.size() : 0;
+        if(head_pos_ < head_size)
+            head_pos_ += stream_->buffer.write(head_->samples.constData() + head_pos_, head_size - head_pos_);
+
+        bool head_written = head_pos_ >= head_size;
+        if(head_written && pending_pos_ < pending_.size()) {
+            pending_pos_ += stream_->buffer.write(pending_.constData() + pending_pos_,
+                                                  pending_.size() - pending_pos_);
+        }
+
+        // stream buffer full, refill timer retries
+        if(!head_written || pending_pos_ < pending_.size()) {
+            // meanwhile decoded audio overlapping head can be dropped
+            bool skipping = skip_ > 0 && pending_pos_ >= pending_.size();
+            if(!skipping || decoder_ == 0 || !decoder_->bufferAvailable())
+                return;
+        }
+        else if(decoder_ == 0 || !decoder_->bufferAvailable()) {
+            break;
+        }
+
+        convert(decoder_->read());
+    }
+
+    if(finished_) {
+        refill_timer_->stop();
+        stream_->decoded.store(1);
+    }
+}
+
+bool AudioStreamDecoder::appendStereo(const QAudioBuffer &buffer, QVector<float> &out)
+{
+    QAudioFormat format = buffer.format();
+    int channels = format.channelCount();
+    int frames = buffer.frameCount();
+    bool is_float = format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32;
+    bool is_int16 = format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16;
+
+    if(channels < 1 || (!is_float && !is_int16))
+        return false;
+
+    int offset = out.size();
+    out.resize(offset + frames * 2);
+    float* dst = out.data() + offset;
+
+    // mono to both sides, more channels down to first two
+    int right = channels > 1 ? 1 : 0;
+
+    if(is_float) {
+        float const* src = buffer.constData<float>();
+        if(channels == 2) {
+            std::memcpy(dst, src, frames * 2 * sizeof(float));
+        } else {
+            for(int i = 0; i < frames; ++i) {
+                dst[2 * i] = src[i * channels];
+                dst[2 * i + 1] = src[i * channels + right];
+            }
+        }
+    } else {
+        qint16 const* src = buffer.constData<qint16>();
+        if(channels == 2) {
+            MixKernels::fromInt16(dst, src, frames * 2);
+        } else {
+            for(int i = 0; i < frames; ++i) {
+                dst[2 * i] = src[i * channels] / 32768.0f;
+                dst[2 * i + 1] = src[i * channels + right] / 32768.0f;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool AudioStreamDecoder::convert(const QAudioBuffer &buffer)
+{
+    pending_pos_ = 0;
+    pending_.clear();
+
+    QAudioFormat format = buffer.format();
+    if(!appendStereo(buffer, pending_)) {
+        if(!format_warned_) {
+            qDebug() << "FAILURE: decoded audio format not supported";
+            qDebug() << " > format:" << format;
+            format_warned_ = true;
+        }
+        return false;
+    }
+
+    // backends not resampling would play at wrong speed, still better than silence
+    if(format.sampleRate() != format_.sampleRate() && !format_warned_) {
+        qDebug() << "FAILURE: decoded audio not at output sample rate";
+        qDebug() << " > decoded:" << format.sampleRate();
+        qDebug() << " > output:" << format_.sampleRate();
+        format_warned_ = true;
+    }
+
+    // part played from head already
+    if(skip_ > 0) {
+        pending_pos_ = qMin(skip_, pending_.size());
+        skip_ -= pending_pos_;
+    }
+
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef SOUND_AUDIO_STREAM_DECODER_H
+#define SOUND_AUDIO_STREAM_DECODER_H
+
+#include <QObject>
+#include <QAudioDecoder>
+#include <QAudioFormat>
+#include <QTimer>
+#include <QVector>
+
+#include "audio_mixer.h"
+#include "preroll_cache.h"
+
+/*
+ * Decodes a sound file into the ring buffer of an AudioStream.
+ * Lives on a decoder thread of the AudioEngine, shared with other voices.
+ * Decoded buffers only get read from QAudioDecoder while the ring buffer
+ * has room, which stalls the decoder backend until the mixer catches up,
+ * so memory stays bounded independent of file length.
+ * Given a pre-decoded head (see PrerollCache), the head gets played first
+ * and decoded audio overlapping it is dropped.
+*/
+class AudioStreamDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    AudioStreamDecoder(AudioStreamPtr const& stream, QAudioFormat const& format, QObject* parent = 0);
+    ~AudioStreamDecoder();
+
+    /*
+     * Appends samples of buffer to out as interleaved stereo floats
+     * (mono to both sides, more channels down to first two).
+     * Returns false if sample format is not supported.
+    */
+    static bool appendStereo(QAudioBuffer const& buffer, QVector<float>& out);
+
+signals:
+    void error(QString const& message);
+
+    /* emitted once duration of file at path is known (ms) */
+    void durationChanged(QString const& path, qint64 duration);
+
+public slots:
+    /*
+     * Starts decoding file at path from its beginning, drops audio decoded before.
+     * Given head (may be null) gets played while decoding starts up.
+     * Resets stream state and marks stream primed for given generation
+     * once its buffer holds audio of path only (see AudioStream::primed).
+    */
+    void start(QString const& path, AudioHeadPtr head, int generation);
+
+    /* Stops decoding, drops audio decoded */
+    void stop();
+
+private slots:
+    void onBufferReady();
+    void onFinished();
+    void onError(QAudioDecoder::Error err);
+    void onDurationChanged(qint64 duration);
+
+private:
+    /* Moves decoded audio into stream buffer, as long as it has room */
+    void pull();
+
+    /* Converts buffer to interleaved stereo floats (into pending_) */
+    bool convert(QAudioBuffer const& buffer);
+
+    AudioStreamPtr stream_;
+    QAudioFormat format_;
+    QAudioDecoder* decoder_;
+    QTimer* refill_timer_;
+    QString path_;
+
+    // pre-decoded head, samples of head written
+    AudioHeadPtr head_;
+    int head_pos_;
+
+    // decoded samples still to drop, as head covers them
+    int skip_;
+
+    // converted samples not yet fitting into stream buffer
+    QVector<float> pending_;
+    int pending_pos_;
+
+    bool finished_;
+    bool format_warned_;
+};
+
+#endif // SOUND_AUDIO_STREAM_DECODER_H
@@ -0,0 +1,235 @@
+#include "audio_voice.h"
+
+#include "audio_engine.h"
+#include "audio_stream_decoder.h"
+#include "preroll_cache.h"
+
+AudioVoice::AudioVoice(QObject *parent)
+    : QObject(parent)
+    , engine_(0)
+    , stream_()
+    , decoder_(0)
+    , source_()
+    , state_(StoppedState)
+    , volume_(100)
+    , pan_(0.0f)
+    , loaded_(false)
+    , fading_out_(false)
+    , fade_serial_(0)
+    , duration_(-1)
+    , finish_notice_(0)
+{
+    engine_ = AudioEngine::instance();
+    stream_ = engine_->attach(this);
+
+    decoder_ = new AudioStreamDecoder(stream_, engine_->getFormat());
+    decoder_->moveToThread(engine_->getDecoderThread());
+    connect(decoder_, SIGNAL(error(QString const&)),
+            this, SIGNAL(error(QString const&)));
+    connect(decoder_, SIGNAL(durationChanged(QString const&, qint64)),
+            this, SLOT(onDurationChanged(QString const&, qint64)));
+}
+
+AudioVoice::~AudioVoice()
+{
+    // engine fades out what is still playing and deletes decoder on its own thread
+    engine_->release(stream_, decoder_, state_ == PlayingState ? engine_->getReleaseFade() : 0);
+}
+
+void AudioVoice::setSource(const QString &path)
+{
+    stop();
+    source_ = path;
+}
+
+const QString &AudioVoice::getSource() const
+{
+    return source_;
+}
+
+AudioVoice::State AudioVoice::getState() const
+{
+    return state_;
+}
+
+int AudioVoice::getVolume() const
+{
+    return volume_;
+}
+
+float AudioVoice::getPan() const
+{
+    return pan_;
+}
+
+qint64 AudioVoice::getPosition() const
+{
+    // position of source played before, until decoder started on current one
+    if(stream_->primed.loadAcquire() != stream_->generation.load())
+        return 0;
+
+    return stream_->frames_played.load() * 1000 / engine_->getFormat().sampleRate();
+}
+
+qint64 AudioVoice::getDuration() const
+{
+    return duration_;
+}
+
+bool AudioVoice::isFadingOut() const
+{
+    return fading_out_;
+}
+
+void AudioVoice::setFinishNotice(int notice)
+{
+    finish_notice_ = qMax(0, notice);
+    updateFinishNotice();
+}
+
+void AudioVoice::play(int fade_in)
+{
+    if(source_.isEmpty())
+        return;
+
+    if(state_ == PlayingState) {
+        // back up from where fade out got to
+        if(fading_out_) {
+            fading_out_ = false;
+            stream_->ramp(getGain(), engine_->toFrames(qMax(fade_in, (int) VOLUME_RAMP)), EqualPowerRamp);
+        }
+        return;
+    }
+
+    if(!loaded_) {
+        // stream state gets reset by decoder, mixer waits for it to prime new generation
+        stream_->notify_frame.store(-1);
+        int generation = stream_->generation.fetchAndAddOrdered(1) + 1;
+        duration_ = -1;
+
+        // starts at volume, or silent to fade in
+        stream_->ramp(getGain(), engine_->toFrames(fade_in), EqualPowerRamp, fade_in > 0 ? 0.0f : getGain());
+
+        // pre-decoded head lets playback start within one mixer period
+        AudioHeadPtr head = PrerollCache::instance()->get(source_);
+        QMetaObject::invokeMethod(decoder_, "start", Qt::QueuedConnection,
+                                  Q_ARG(QString, source_),
+                                  Q_ARG(AudioHeadPtr, head),
+                                  Q_ARG(int, generation));
+        loaded_ = true;
+    }
+    else if(fading_out_ || fade_in > 0) {
+        // resumed, fade out paused with voice does not go on
+        fading_out_ = false;
+        stream_->ramp(getGain(), engine_->toFrames(fade_in > 0 ? fade_in : (int) VOLUME_RAMP), EqualPowerRamp,
+                      fade_in > 0 ? 0.0f : -1.0f);
+    }
+
+    stream_->playing.store(1);
+    setState(PlayingState);
+}
+
+void AudioVoice::pause()
+{
+    if(state_ != PlayingState)
+        return;
+
+    stream_->playing.store(0);
+    setState(PausedState);
+}
+
+void AudioVoice::stop(int fade_out)
+{
+    // keeps playing until silent, see onStreamRampFinished()
+    if(fade_out > 0 && state_ == PlayingState) {
+        fading_out_ = true;
+        fade_serial_ = stream_->ramp(0.0f, engine_->toFrames(fade_out), EqualPowerRamp);
+        return;
+    }
+
+    fading_out_ = false;
+    stream_->playing.store(0);
+    if(loaded_) {
+        QMetaObject::invokeMethod(decoder_, "stop", Qt::QueuedConnection);
+        loaded_ = false;
+    }
+    setState(StoppedState);
+}
+
+void AudioVoice::setVolume(int volume, int ramp)
+{
+    volume_ = qBound(0, volume, 100);
+
+    // fade out keeps going down, play() takes voice back up to new volume
+    if(!fading_out_)
+        stream_->ramp(getGain(), engine_->toFrames(ramp));
+}
+
+void AudioVoice::setPan(float pan)
+{
+    pan_ = qBound(-1.0f, pan, 1.0f);
+    stream_->pan.store(pan_);
+}
+
+void AudioVoice::onStreamDrained(int generation)
+{
+    // drained before voice got restarted
+    if(!loaded_ || generation != stream_->generation.load())
+        return;
+
+    stream_->playing.store(0);
+    loaded_ = false;
+    fading_out_ = false;
+    setState(StoppedState);
+    emit finished();
+}
+
+void AudioVoice::onStreamRampFinished(int serial)
+{
+    if(fading_out_ && serial == fade_serial_)
+        stop();
+}
+
+void AudioVoice::onStreamPositionReached(int generation)
+{
+    // reached before voice got restarted
+    if(!loaded_ || generation != stream_->generation.load() || fading_out_)
+        return;
+
+    emit aboutToFinish();
+}
+
+void AudioVoice::onDurationChanged(const QString &path, qint64 duration)
+{
+    // duration of source played before
+    if(!loaded_ || path != source_)
+        return;
+
+    duration_ = duration;
+    updateFinishNotice();
+}
+
+void AudioVoice::updateFinishNotice()
+{
+    if(!loaded_ || finish_notice_ <= 0 || duration_ < 0) {
+        stream_->notify_frame.store(-1);
+        return;
+    }
+
+    // notified right away, if source is shorter than notice
+    stream_->notify_frame.store(engine_->toFrames(qMax((qint64) 0, duration_ - finish_notice_)));
+}
+
+float AudioVoice::getGain() const
+{
+    return volume_ / 100.0f;
+}
+
+void AudioVoice::setState(AudioVoice::State state)
+{
+    if(state_ == state)
+        return;
+
+    state_ = state;
+    emit stateChanged(state_);
+}
@@ -0,0 +1,133 @@
+#ifndef SOUND_AUDIO_VOICE_H
+#define SOUND_AUDIO_VOICE_H
+
+#include <QObject>
+#include <QString>
+
+#include "audio_mixer.h"
+
+class AudioEngine;
+class AudioStreamDecoder;
+
+/*
+ * Lightweight player of one sound file at a time, mixed by the shared AudioEngine.
+ * Replaces a QMediaPlayer per tile: a voice holds a ring buffer and
+ * a decoder on a shared thread, but no audio output or thread of its own.
+ * Volume and pan changes apply within one mixer period, volume changes
+ * and fades ramp sample by sample inside the mixer, so no timers are involved.
+ * Sources with a head in the PrerollCache start playing from memory.
+ * Seeking is not supported.
+*/
+class AudioVoice : public QObject
+{
+    Q_OBJECT
+    friend class AudioEngine;
+public:
+    enum State {
+        StoppedState,
+        PlayingState,
+        PausedState
+    };
+
+    // volume changes get smoothed over (ms), so they do not click
+    static const int VOLUME_RAMP = 30;
+
+    explicit AudioVoice(QObject* parent = 0);
+    ~AudioVoice();
+
+    /* Sets file to play, stops voice if playing */
+    void setSource(QString const& path);
+    QString const& getSource() const;
+
+    State getState() const;
+
+    /* Gets volume (linear, 0 to 100) */
+    int getVolume() const;
+
+    /* Gets pan (-1 left to 1 right) */
+    float getPan() const;
+
+    /* Gets playback position within source (ms) */
+    qint64 getPosition() const;
+
+    /* Gets duration of source (ms), -1 until known */
+    qint64 getDuration() const;
+
+    /* Checks whether voice fades out before stopping (see stop()) */
+    bool isFadingOut() const;
+
+    /*
+     * Sets time before end of source aboutToFinish() gets emitted at (ms), 0 for none.
+     * Takes effect once duration of source is known.
+    */
+    void setFinishNotice(int notice);
+
+signals:
+    void stateChanged(AudioVoice::State state);
+
+    /* emitted once source played until its end */
+    void finished();
+
+    /* emitted once source played up to finish notice before its end (see setFinishNotice()) */
+    void aboutToFinish();
+
+    void error(QString const& message);
+
+public slots:
+    /*
+     * Starts source from its beginning, or resumes it if paused,
+     * fading in from silence over fade_in (ms).
+     * Takes voice fading out back up to volume.
+    */
+    void play(int fade_in = 0);
+    void pause();
+
+    /* Stops voice, after fading it out over fade_out (ms) if playing */
+    void stop(int fade_out = 0);
+
+    /* Sets volume (linear, 0 to 100), ramping to it over ramp (ms) */
+    void setVolume(int volume, int ramp = VOLUME_RAMP);
+    void setPan(float pan);
+
+private slots:
+    void onDurationChanged(QString const& path, qint64 duration);
+
+private:
+    /* Called by engine, once mixer played all of source decoded */
+    void onStreamDrained(int generation);
+
+    /* Called by engine, once mixer finished ramp of serial */
+    void onStreamRampFinished(int serial);
+
+    /* Called by engine, once mixer played up to finish notice */
+    void onStreamPositionReached(int generation);
+
+    /* Sets frame mixer notifies at from duration and finish notice */
+    void updateFinishNotice();
+
+    /* Gets gain of volume */
+    float getGain() const;
+
+    void setState(State state);
+
+    AudioEngine* engine_;
+    AudioStreamPtr stream_;
+    AudioStreamDecoder* decoder_;
+
+    QString source_;
+    State state_;
+    int volume_;
+    float pan_;
+
+    // decoder got started on source (and not stopped since)
+    bool loaded_;
+
+    // stops once ramp of fade_serial_ finished
+    bool fading_out_;
+    int fade_serial_;
+
+    qint64 duration_;
+    int finish_notice_;
+};
+
+#endif // SOUND_AUDIO_VOICE_H
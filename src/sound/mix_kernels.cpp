@@ -0,0 +1,122 @@
+#include "mix_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace MixKernels {
+
+void mixStereo(float *out, const float *in, int frames, float gain_l, float gain_r)
+{
+    int samples = frames * 2;
+    int i = 0;
+
+#ifdef MIX_KERNELS_SSE2
+    // 4 frames per iteration, gains alternate like the samples
+    __m128 gains = _mm_setr_ps(gain_l, gain_r, gain_l, gain_r);
+    for(; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_loadu_ps(in + i);
+        __m128 b = _mm_loadu_ps(in + i + 4);
+        __m128 o_a = _mm_loadu_ps(out + i);
+        __m128 o_b = _mm_loadu_ps(out + i + 4);
+        _mm_storeu_ps(out + i, _mm_add_ps(o_a, _mm_mul_ps(a, gains)));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(o_b, _mm_mul_ps(b, gains)));
+    }
+#endif
+
+    for(; i + 2 <= samples; i += 2) {
+        out[i] += in[i] * gain_l;
+        out[i + 1] += in[i + 1] * gain_r;
+    }
+}
+
+void mixStereoRamp(float *out, const float *in, int frames, float gain_l, float gain_r, float step_l, float step_r)
+{
+    int f = 0;
+
+#ifdef MIX_KERNELS_SSE2
+    // 2 frames per vector, gains computed from frame index rather than summed up, so they do not drift
+    __m128 base = _mm_setr_ps(gain_l, gain_r, gain_l + step_l, gain_r + step_r);
+    __m128 step = _mm_setr_ps(step_l, step_r, step_l, step_r);
+    for(; f + 4 <= frames; f += 4) {
+        __m128 g_a = _mm_add_ps(base, _mm_mul_ps(step, _mm_set1_ps((float) f)));
+        __m128 g_b = _mm_add_ps(base, _mm_mul_ps(step, _mm_set1_ps((float) (f + 2))));
+        __m128 a = _mm_loadu_ps(in + 2 * f);
+        __m128 b = _mm_loadu_ps(in + 2 * f + 4);
+        __m128 o_a = _mm_loadu_ps(out + 2 * f);
+        __m128 o_b = _mm_loadu_ps(out + 2 * f + 4);
+        _mm_storeu_ps(out + 2 * f, _mm_add_ps(o_a, _mm_mul_ps(a, g_a)));
+        _mm_storeu_ps(out + 2 * f + 4, _mm_add_ps(o_b, _mm_mul_ps(b, g_b)));
+    }
+#endif
+
+    for(; f < frames; ++f) {
+        out[2 * f] += in[2 * f] * (gain_l + f * step_l);
+        out[2 * f + 1] += in[2 * f + 1] * (gain_r + f * step_r);
+    }
+}
+
+void toInt16(qint16 *out, const float *in, int samples)
+{
+    int i = 0;
+
+#ifdef MIX_KERNELS_SSE2
+    // clamp before conversion, out of range floats convert to INT_MIN
+    __m128 scale = _mm_set1_ps(32767.0f);
+    __m128 lo = _mm_set1_ps(-1.0f);
+    __m128 hi = _mm_set1_ps(1.0f);
+    for(; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi);
+        __m128i a_i = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+        __m128i b_i = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a_i, b_i));
+    }
+#endif
+
+    for(; i < samples; ++i) {
+        float v = qBound(-1.0f, in[i], 1.0f);
+        out[i] = (qint16) qRound(v * 32767.0f);
+    }
+}
+
+void fromInt16(float *out, const qint16 *in, int samples)
+{
+    int i = 0;
+    float const scale = 1.0f / 32768.0f;
+
+#ifdef MIX_KERNELS_SSE2
+    // sign extend 16 to 32 bit by unpacking into the high halves and shifting back
+    __m128 s = _mm_set1_ps(scale);
+    for(; i + 8 <= samples; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+#endif
+
+    for(; i < samples; ++i)
+        out[i] = in[i] * scale;
+}
+
+void panGains(float gain, float pan, float &gain_l, float &gain_r)
+{
+    // balance law, centered voices keep their level on both sides
+    pan = qBound(-1.0f, pan, 1.0f);
+    gain_l = gain * qMin(1.0f, 1.0f - pan);
+    gain_r = gain * qMin(1.0f, 1.0f + pan);
+}
+
+bool usesSse2()
+{
+#ifdef MIX_KERNELS_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace MixKernels
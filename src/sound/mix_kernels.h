@@ -0,0 +1,37 @@
+#ifndef SOUND_MIX_KERNELS_H
+#define SOUND_MIX_KERNELS_H
+
+#include <QtGlobal>
+
+/*
+ * Sample processing functions of the audio mixer (see AudioMixer).
+ * All buffers hold interleaved stereo samples (left, right).
+ * Uses SSE2 where the target supports it (always true on x86-64),
+ * plain loops otherwise. Buffers need no particular alignment.
+*/
+namespace MixKernels {
+
+/* Adds frames of in to out, left samples scaled by gain_l, right ones by gain_r */
+void mixStereo(float* out, float const* in, int frames, float gain_l, float gain_r);
+
+/*
+ * Adds frames of in to out with gain changing linearly per frame,
+ * frame i scaled by gain_l + i * step_l (left) and gain_r + i * step_r (right)
+*/
+void mixStereoRamp(float* out, float const* in, int frames, float gain_l, float gain_r, float step_l, float step_r);
+
+/* Converts samples to 16 bit, clipping at full scale */
+void toInt16(qint16* out, float const* in, int samples);
+
+/* Converts 16 bit samples to float (full scale at 1.0) */
+void fromInt16(float* out, qint16 const* in, int samples);
+
+/* Gets left and right gain for given gain and pan (-1 left to 1 right), center keeps gain on both sides */
+void panGains(float gain, float pan, float& gain_l, float& gain_r);
+
+/* Returns true if functions got built with SSE2 */
+bool usesSse2();
+
+} // namespace MixKernels
+
+#endif // SOUND_MIX_KERNELS_H
@@ -0,0 +1,162 @@
+#include "preroll_cache.h"
+
+#include <QFileInfo>
+#include <QDebug>
+
+#include "audio_engine.h"
+#include "preroll_decoder.h"
+
+// length of heads decoded (ms)
+static const int HEAD_DURATION = 3000;
+
+// memory heads may take up by default, about 50 heads of 3s at 48kHz
+static const qint64 DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+PrerollCache* PrerollCache::instance_ = nullptr;
+
+PrerollCache::PrerollCache()
+    : QObject()
+    , decoder_(0)
+    , entries_()
+    , failed_()
+    , clock_(0)
+    , size_(0)
+    , budget_(DEFAULT_BUDGET)
+{
+    qRegisterMetaType<AudioHeadPtr>("AudioHeadPtr");
+
+    AudioEngine* engine = AudioEngine::instance();
+
+    decoder_ = new PrerollDecoder(engine->getFormat(), HEAD_DURATION);
+    decoder_->moveToThread(engine->getDecoderThread());
+    connect(this, SIGNAL(headRequested(QString const&)),
+            decoder_, SLOT(enqueue(QString const&)));
+    connect(decoder_, SIGNAL(headDecoded(QString const&, AudioHeadPtr)),
+            this, SLOT(onHeadDecoded(QString const&, AudioHeadPtr)));
+    connect(decoder_, SIGNAL(headFailed(QString const&)),
+            this, SLOT(onHeadFailed(QString const&)));
+}
+
+PrerollCache* PrerollCache::instance() {
+    if(!instance_) {
+        instance_ = new PrerollCache;
+    }
+    return instance_;
+}
+
+PrerollCache::~PrerollCache()
+{
+    // decoder thread may have been stopped by engine already
+    if(decoder_->thread()->isRunning())
+        decoder_->deleteLater();
+    else
+        delete decoder_;
+    instance_ = nullptr;
+}
+
+const AudioHeadPtr PrerollCache::get(const QString &path)
+{
+    QHash<QString, Entry>::iterator it = entries_.find(path);
+    if(it == entries_.end() || it->head.isNull())
+        return AudioHeadPtr();
+
+    // file changed since head got decoded
+    if(QFileInfo(path).lastModified() != it->head->mtime) {
+        size_ -= bytes(it->head);
+        entries_.erase(it);
+        return AudioHeadPtr();
+    }
+
+    it->stamp = ++clock_;
+    return it->head;
+}
+
+void PrerollCache::request(const QString &path)
+{
+    if(path.isEmpty())
+        return;
+
+    QHash<QString, Failure>::iterator failure = failed_.find(path);
+    if(failure != failed_.end()) {
+        QFileInfo info(path);
+        if(info.lastModified() == failure->mtime && info.size() == failure->size)
+            return;
+
+        // file changed since, may decode now
+        failed_.erase(failure);
+    }
+
+    QHash<QString, Entry>::iterator it = entries_.find(path);
+    if(it != entries_.end()) {
+        it->stamp = ++clock_;
+        return;
+    }
+
+    // entry without head marks decoding in progress
+    Entry e;
+    e.stamp = ++clock_;
+    entries_.insert(path, e);
+    emit headRequested(path);
+}
+
+void PrerollCache::setBudget(qint64 bytes)
+{
+    budget_ = qMax((qint64) 0, bytes);
+    evict();
+}
+
+qint64 PrerollCache::getBudget() const
+{
+    return budget_;
+}
+
+qint64 PrerollCache::getSize() const
+{
+    return size_;
+}
+
+void PrerollCache::onHeadDecoded(const QString &path, AudioHeadPtr head)
+{
+    // dropped meanwhile
+    QHash<QString, Entry>::iterator it = entries_.find(path);
+    if(it == entries_.end() || !it->head.isNull())
+        return;
+
+    it->head = head;
+    size_ += bytes(head);
+    evict();
+}
+
+void PrerollCache::onHeadFailed(const QString &path)
+{
+    // not retried until file changes, voices report the error once played
+    QFileInfo info(path);
+    Failure failure;
+    failure.mtime = info.lastModified();
+    failure.size = info.size();
+
+    entries_.remove(path);
+    failed_.insert(path, failure);
+}
+
+void PrerollCache::evict()
+{
+    while(size_ > budget_) {
+        QHash<QString, Entry>::iterator oldest = entries_.end();
+        for(QHash<QString, Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            if(!it->head.isNull() && (oldest == entries_.end() || it->stamp < oldest->stamp))
+                oldest = it;
+        }
+        if(oldest == entries_.end())
+            break;
+
+        // voices playing the head keep their reference
+        size_ -= bytes(oldest->head);
+        entries_.erase(oldest);
+    }
+}
+
+qint64 PrerollCache::bytes(const AudioHeadPtr &head)
+{
+    return head ? (qint64) head->samples.size() * sizeof(float) : 0;
+}
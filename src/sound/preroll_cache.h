@@ -0,0 +1,113 @@
+#ifndef SOUND_PREROLL_CACHE_H
+#define SOUND_PREROLL_CACHE_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QDateTime>
+#include <QVector>
+#include <QHash>
+
+/*
+ * Decoded beginning of a sound file (interleaved stereo floats at engine sample rate).
+ * complete is set if the head holds the whole file.
+*/
+struct AudioHead {
+    QVector<float> samples;
+    bool complete;
+    QDateTime mtime;
+
+    AudioHead()
+        : samples()
+        , complete(false)
+        , mtime()
+    {}
+};
+
+typedef QSharedPointer<const AudioHead> AudioHeadPtr;
+
+class PrerollDecoder;
+
+/*
+ * Budgeted cache of decoded sound file heads, so voices can start
+ * playing from memory while the rest of the file gets decoded (see AudioStreamDecoder).
+ * Heads get decoded on a decoder thread of the AudioEngine, one file at a time.
+ * Once over budget, heads requested least recently get dropped first.
+ * All functions are to be called from the main thread.
+*/
+class PrerollCache : public QObject
+{
+    Q_OBJECT
+public:
+    static PrerollCache* instance();
+    virtual ~PrerollCache();
+
+    // delete copy and move c'tors
+    PrerollCache(const PrerollCache &) = delete;
+    PrerollCache(PrerollCache &&) = delete;
+
+    // delete assign operator
+    void operator=(const PrerollCache&) = delete;
+    void operator=(PrerollCache&&) = delete;
+
+    /* Gets head of file at path, null if not (yet) decoded or file changed since */
+    AudioHeadPtr const get(QString const& path);
+
+    /* Gets head decoded for file at path (if missing) and keeps it from being dropped soon */
+    void request(QString const& path);
+
+    /* Sets memory heads may take up in total (bytes) */
+    void setBudget(qint64 bytes);
+    qint64 getBudget() const;
+
+    /* Gets memory taken by heads (bytes) */
+    qint64 getSize() const;
+
+signals:
+    void headRequested(QString const& path);
+
+private slots:
+    void onHeadDecoded(QString const& path, AudioHeadPtr head);
+    void onHeadFailed(QString const& path);
+
+private:
+    PrerollCache();
+
+    /* Drops least recently requested heads until within budget */
+    void evict();
+
+    struct Entry {
+        AudioHeadPtr head;
+        quint64 stamp;
+
+        Entry()
+            : head()
+            , stamp(0)
+        {}
+    };
+
+    /* File state a head failed to decode for, retried once it changes */
+    struct Failure {
+        QDateTime mtime;
+        qint64 size;
+
+        Failure()
+            : mtime()
+            , size(0)
+        {}
+    };
+
+    static qint64 bytes(AudioHeadPtr const& head);
+
+    PrerollDecoder* decoder_;
+    QHash<QString, Entry> entries_;
+    QHash<QString, Failure> failed_;
+    quint64 clock_;
+    qint64 size_;
+    qint64 budget_;
+
+    static PrerollCache* instance_;
+};
+
+Q_DECLARE_METATYPE(AudioHeadPtr)
+
+#endif // SOUND_PREROLL_CACHE_H
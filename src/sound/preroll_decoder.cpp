@@ -0,0 +1,115 @@
+#include "preroll_decoder.h"
+
+#include <QFileInfo>
+#include <QDebug>
+
+#include "audio_stream_decoder.h"
+
+PrerollDecoder::PrerollDecoder(const QAudioFormat &format, int head_ms, QObject *parent)
+    : QObject(parent)
+    , format_(format)
+    , head_samples_(0)
+    , decoder_(0)
+    , queue_()
+    , current_()
+    , head_(0)
+{
+    format_.setSampleType(QAudioFormat::Float);
+    format_.setSampleSize(32);
+    head_samples_ = (int) ((qint64) format_.sampleRate() * head_ms / 1000) * 2;
+}
+
+PrerollDecoder::~PrerollDecoder()
+{
+    if(decoder_ != 0)
+        decoder_->stop();
+    delete head_;
+}
+
+void PrerollDecoder::enqueue(const QString &path)
+{
+    if(path == current_ || queue_.contains(path))
+        return;
+
+    queue_.append(path);
+    startNext();
+}
+
+void PrerollDecoder::onBufferReady()
+{
+    while(head_ != 0 && decoder_->bufferAvailable()) {
+        AudioStreamDecoder::appendStereo(decoder_->read(), head_->samples);
+
+        if(head_->samples.size() >= head_samples_) {
+            head_->samples.resize(head_samples_);
+            finishCurrent(false);
+            return;
+        }
+    }
+}
+
+void PrerollDecoder::onFinished()
+{
+    onBufferReady();
+    if(head_ != 0)
+        finishCurrent(true);
+}
+
+void PrerollDecoder::onError(QAudioDecoder::Error err)
+{
+    qDebug() << "FAILURE: could not pre-decode sound file";
+    qDebug() << " > path:" << current_;
+    qDebug() << " > error:" << err << decoder_->errorString();
+
+    if(head_ != 0) {
+        head_->samples.clear();
+        finishCurrent(false);
+    }
+}
+
+void PrerollDecoder::startNext()
+{
+    if(head_ != 0 || queue_.isEmpty())
+        return;
+
+    // created on first use, like decoders of voices
+    if(decoder_ == 0) {
+        decoder_ = new QAudioDecoder(this);
+        decoder_->setAudioFormat(format_);
+        connect(decoder_, SIGNAL(bufferReady()),
+                this, SLOT(onBufferReady()));
+        connect(decoder_, SIGNAL(finished()),
+                this, SLOT(onFinished()));
+        connect(decoder_, SIGNAL(error(QAudioDecoder::Error)),
+                this, SLOT(onError(QAudioDecoder::Error)));
+    }
+
+    current_ = queue_.takeFirst();
+    head_ = new AudioHead;
+    head_->samples.reserve(head_samples_);
+    head_->mtime = QFileInfo(current_).lastModified();
+
+    decoder_->setSourceFilename(current_);
+    decoder_->start();
+}
+
+void PrerollDecoder::finishCurrent(bool complete)
+{
+    decoder_->stop();
+
+    AudioHead* head = head_;
+    QString path = current_;
+    head_ = 0;
+    current_.clear();
+
+    if(head->samples.isEmpty()) {
+        delete head;
+        emit headFailed(path);
+    }
+    else {
+        head->complete = complete;
+        emit headDecoded(path, AudioHeadPtr(head));
+    }
+
+    startNext();
+}
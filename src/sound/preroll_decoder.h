@@ -0,0 +1,52 @@
+#ifndef SOUND_PREROLL_DECODER_H
+#define SOUND_PREROLL_DECODER_H
+
+#include <QObject>
+#include <QAudioDecoder>
+#include <QAudioFormat>
+#include <QStringList>
+
+#include "preroll_cache.h"
+
+/*
+ * Decodes heads of sound files for the PrerollCache, one file after another.
+ * Lives on a decoder thread of the AudioEngine.
+*/
+class PrerollDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    /* Heads get decoded up to head_ms, in given format */
+    PrerollDecoder(QAudioFormat const& format, int head_ms, QObject* parent = 0);
+    ~PrerollDecoder();
+
+signals:
+    void headDecoded(QString const& path, AudioHeadPtr head);
+    void headFailed(QString const& path);
+
+public slots:
+    /* Queues file at path for decoding */
+    void enqueue(QString const& path);
+
+private slots:
+    void onBufferReady();
+    void onFinished();
+    void onError(QAudioDecoder::Error err);
+
+private:
+    /* Starts decoding next queued file, if idle */
+    void startNext();
+
+    /* Hands over head of current file, or reports it failed if nothing got decoded */
+    void finishCurrent(bool complete);
+
+    QAudioFormat format_;
+    int head_samples_;
+    QAudioDecoder* decoder_;
+
+    QStringList queue_;
+    QString current_;
+    AudioHead* head_;
+};
+
+#endif // SOUND_PREROLL_DECODER_H
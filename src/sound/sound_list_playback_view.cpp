@@ -42,12 +42,40 @@ SoundListPlaybackView::~SoundListPlaybackView()
 
 void SoundListPlaybackView::setSoundFiles(const QList<SoundFileRecord *> &sound_files)
 {
+    if(model() != model_) {
+        playable_index_ = QPersistentModelIndex();
+        setModel(model_);
+    }
+
     model_->clear();
     foreach(SoundFileRecord* rec, sound_files)
         addSoundFile(rec);
     setColumnWidth(0, verticalHeader()->defaultSectionSize());
 }
 
+void SoundListPlaybackView::setSoundFiles(const QList<SoundFileRecord> &sound_files)
+{
+    if(model() != model_) {
+        playable_index_ = QPersistentModelIndex();
+        setModel(model_);
+    }
+
+    model_->clear();
+    foreach(SoundFileRecord const& rec, sound_files)
+        addSoundFile(rec.id, rec.name, rec.path);
+    setColumnWidth(0, verticalHeader()->defaultSectionSize());
+}
+
+void SoundListPlaybackView::setLibraryModel(QAbstractItemModel *library_model)
+{
+    if(library_model == 0 || model() == library_model)
+        return;
+
+    playable_index_ = QPersistentModelIndex();
+    setModel(library_model);
+    setColumnWidth(0, verticalHeader()->defaultSectionSize());
+}
+
 void SoundListPlaybackView::setEditable(bool is_editable)
 {
     for(int i = 0; i < model_->columnCount(); ++i)
@@ -165,9 +193,9 @@ void SoundListPlaybackView::onPlayButtonClicked()
         return;
 
     SoundFileRecord rec;
-    rec.id = model_->data(model_->index(playable_index_.row(), 0), Qt::UserRole).toInt();
-    rec.path = model_->data(model_->index(playable_index_.row(), 0), Qt::UserRole+1).toString();
-    rec.name = model_->data(model_->index(playable_index_.row(), 1)).toString();
+    rec.id = model()->data(model()->index(playable_index_.row(), 0), Qt::UserRole).toInt();
+    rec.path = model()->data(model()->index(playable_index_.row(), 0), Qt::UserRole+1).toString();
+    rec.name = model()->data(model()->index(playable_index_.row(), 1)).toString();
     emit play(rec);
 }
 
@@ -202,7 +230,7 @@ void SoundListPlaybackView::addSoundFile(int id, const QString &name, const QStr
 void SoundListPlaybackView::onEntered(const QModelIndex &idx)
 {
     if(idx.isValid()) {
-        QModelIndex b_idx = model_->index(idx.row(), 0);
+        QModelIndex b_idx = model()->index(idx.row(), 0);
         auto button = new QPushButton;
         button->setIcon(play_icon_);
         button->setStyleSheet(
@@ -232,8 +260,11 @@ void SoundListPlaybackView::onDeleteAction()
         return;
 
     int row = selection.first().row();
-    int id = model_->data(model_->index(row, 0), Qt::UserRole).toInt();
-    model_->removeRow(row);
+    int id = model()->data(model()->index(row, 0), Qt::UserRole).toInt();
+
+    // library model refreshes itself once sound file got deleted
+    if(model() == model_)
+        model_->removeRow(row);
     emit deleteSoundFileRequested(id);
 }
 
@@ -245,9 +276,9 @@ void SoundListPlaybackView::performDrag()
         if(rows.contains(idx.row()))
             continue;
         SoundFileRecord* temp_rec = new SoundFileRecord;
-        temp_rec->id = model_->data(model_->index(idx.row(), 0), Qt::UserRole).toInt();
-        temp_rec->path = model_->data(model_->index(idx.row(), 0), Qt::UserRole+1).toString();
-        temp_rec->name = model_->data(model_->index(idx.row(), 1)).toString();
+        temp_rec->id = model()->data(model()->index(idx.row(), 0), Qt::UserRole).toInt();
+        temp_rec->path = model()->data(model()->index(idx.row(), 0), Qt::UserRole+1).toString();
+        temp_rec->name = model()->data(model()->index(idx.row(), 1)).toString();
         records.append(temp_rec);
         rows.insert(idx.row());
     }
@@ -21,6 +21,14 @@ public:
     virtual ~SoundListPlaybackView();
 
     void setSoundFiles(QList<SoundFileRecord*> const&);
+    void setSoundFiles(QList<SoundFileRecord> const&);
+
+    /*
+     * Shows rows of given model instead of own list (e.g. the paged sound library).
+     * Model has to provide id (Qt::UserRole) and path (Qt::UserRole+1) in column 0
+     * and name in column 1. setSoundFiles() switches back to own list.
+    */
+    void setLibraryModel(QAbstractItemModel* model);
     void setEditable(bool);
     bool getEditable();
 
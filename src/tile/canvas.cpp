@@ -383,10 +383,13 @@ ImageDisplayWidget *Canvas::getImageDisplay() const
 
 void Canvas::pushScene(QGraphicsScene* scene, QString const& name)
 {
+    if(this->scene())
+        setPlaybackPrepared(this->scene(), false);
     scene_stack_.push(scene);
     scene->setSceneRect(main_scene_->sceneRect());
     scene_names_[scene] = name;
     setScene(scene);
+    setPlaybackPrepared(scene, true);
     if(scene_stack_.size() > 1) {
         nested_path_widget_->setPathText(scene_stack_, scene_names_);
         nested_path_widget_->show();
@@ -396,8 +399,10 @@ void Canvas::pushScene(QGraphicsScene* scene, QString const& name)
 void Canvas::popScene()
 {
     if(scene_stack_.size() > 1) {
+        setPlaybackPrepared(scene_stack_.top(), false);
         scene_names_.remove(scene_stack_.pop());
         setScene(scene_stack_.top());
+        setPlaybackPrepared(scene_stack_.top(), true);
         nested_path_widget_->setPathText(scene_stack_, scene_names_);
         if(scene_stack_.size() == 1)
             nested_path_widget_->hide();
@@ -837,10 +842,12 @@ void Canvas::dropEvent(QDropEvent *event)
     tile->setPos(p);
     tile->setSize(0);
 
+    QList<int> ids;
     foreach(TableRecord* rec, records) {
         if(rec->index == SOUND_FILE)
-            tile->addMedia(*((SoundFileRecord*) rec));
+            ids.append(rec->id);
     }
+    tile->addMedia(ids);
 
     // add to scene
     scene()->addItem(tile);
@@ -931,6 +938,18 @@ void Canvas::clearTiles()
     }
 }
 
+void Canvas::setPlaybackPrepared(QGraphicsScene *s, bool state)
+{
+    foreach(QGraphicsItem* it, s->items()) {
+        QObject* o = dynamic_cast<QObject*>(it);
+        if(o) {
+            PlaylistTile* t = qobject_cast<PlaylistTile*>(o);
+            if(t)
+                t->setPlaybackPrepared(state);
+        }
+    }
+}
+
 void Canvas::initContextMenu()
 {
     context_menu_ = new QMenu;
@@ -255,6 +255,12 @@ private:
      */
     void clearTiles();
 
+    /**
+     * Enables or disables playback preparation of all PlaylistTiles in given scene
+     * (see PlaylistTile::setPlaybackPrepared).
+    */
+    void setPlaybackPrepared(QGraphicsScene* s, bool state);
+
     /**
      * @brief initializes the context menu of this view.
      */
@@ -7,6 +7,7 @@
 #include <QJsonArray>
 
 #include "sound/sound_list_view_dialog.h"
+#include "playlist/playlist_weights_dialog.h"
 #include "misc/volume_mapper.h"
 
 namespace Tile {
@@ -98,12 +99,14 @@ void PlaylistTile::receiveExternalData(const QMimeData *data)
     if(records.size() == 0)
         return;
 
-    // add media for each sound file record
+    // add media for all sound file records at once
+    QList<int> ids;
     foreach(TableRecord* rec, records) {
         if(rec->index != SOUND_FILE)
             continue;
-        addMedia(*((SoundFileRecord*) rec));
+        ids.append(rec->id);
     }
+    addMedia(ids);
 
     // delete temp records
     while(records.size() > 0) {
@@ -145,6 +148,14 @@ bool PlaylistTile::addMedia(int record_id)
     return playlist_->addMedia(record_id);
 }
 
+int PlaylistTile::addMedia(const QList<int> &record_ids)
+{
+    if(model_ == 0)
+        return 0;
+
+    return playlist_->addMedia(record_ids);
+}
+
 bool PlaylistTile::addMedia(const SoundFileRecord &r)
 {
     if(model_ == 0)
@@ -170,8 +181,22 @@ const QJsonObject PlaylistTile::toJsonObject() const
 
     // store playlist
     QJsonArray arr_pl;
-    foreach(SoundFileRecord* rec, playlist_->getSoundFileList())
-        arr_pl.append(JsonMimeDataParser::toJsonObject(rec));
+    for(int i = 0; i < playlist_->mediaCount(); ++i) {
+        SoundFileRecord* rec = playlist_->getSoundFile(i);
+        if(rec == 0)
+            continue;
+        QJsonObject sound_obj = JsonMimeDataParser::toJsonObject(rec);
+
+        // allows relinking the file once moved (see setFromJsonObject)
+        QString fingerprint = model_->getFingerprintById(rec->id);
+        if(fingerprint.size() > 0)
+            sound_obj["fingerprint"] = fingerprint;
+
+        // weight for weighted play order
+        sound_obj["weight"] = playlist_->getWeight(i);
+
+        arr_pl.append(sound_obj);
+    }
     obj["playlist"] = arr_pl;
 
     //store settings
@@ -187,8 +212,10 @@ bool PlaylistTile::setFromJsonObject(const QJsonObject &obj)
     if(!BaseTile::setFromJsonObject(obj))
         return false;
 
-    // parse playlist
+    // parse playlist, sound files get added at once after validation
     if(obj.contains("playlist") && obj["playlist"].isArray()) {
+        QList<int> ids;
+        QList<double> weights;
         foreach(QJsonValue val, obj["playlist"].toArray()) {
             QJsonObject sound_obj = val.toObject();
             if(sound_obj.isEmpty())
@@ -203,6 +230,17 @@ bool PlaylistTile::setFromJsonObject(const QJsonObject &obj)
             // check existance against actual database
             SoundFileRecord* sf_rec = (SoundFileRecord*) rec;
             QList<SoundFileRecord*> actual_recs = model_->getSoundFilesByRelativePath(sf_rec->relative_path);
+
+            // file may have been moved (or re-imported elsewhere), look it up by content
+            if(actual_recs.size() == 0 && sound_obj["fingerprint"].isString()) {
+                actual_recs = model_->getSoundFilesByFingerprint(sound_obj["fingerprint"].toString());
+                if(actual_recs.size() > 0) {
+                    qDebug() << "NOTIFICATION: relinked SoundFile by content fingerprint";
+                    qDebug() << " > relative path:" << sf_rec->relative_path;
+                    qDebug() << " > now:" << actual_recs[0]->relative_path;
+                }
+            }
+
             if(actual_recs.size() == 0) {
                 qDebug() << "FAILURE: Could not verify SoundFile existance.";
                 qDebug() << " > SoundFile:" << sound_obj << "does not exist in any ResourceDirectory.";
@@ -234,18 +272,27 @@ bool PlaylistTile::setFromJsonObject(const QJsonObject &obj)
                 sf_rec->copyFrom(actual_recs[0]);
             }
 
-            bool success = playlist_->addMedia(*sf_rec);
-            if(!success) {
-                qDebug() << "FAILURE: Could not add SoundFile from JSON";
-                qDebug() << " > " << sound_obj;
-                sf_rec = 0;
-                delete rec;
-                return false;
-            }
+            ids.append(sf_rec->id);
+
+            // optional, missing in files of earlier versions
+            weights.append(sound_obj["weight"].isDouble() ? sound_obj["weight"].toDouble() : -1.0);
 
             sf_rec = 0;
             delete rec;
         }
+
+        int first = playlist_->mediaCount();
+        int added = playlist_->addMedia(ids);
+        if(added != ids.size()) {
+            qDebug() << "FAILURE: Could not add SoundFiles from JSON";
+            qDebug() << " > added:" << added << "of" << ids.size();
+            return false;
+        }
+
+        for(int i = 0; i < weights.size(); ++i) {
+            if(weights[i] >= 0.0)
+                playlist_->setWeight(first + i, weights[i]);
+        }
     }
 
     // parse settings
@@ -267,6 +314,11 @@ bool PlaylistTile::setFromJsonObject(const QJsonObject &obj)
     return true;
 }
 
+void PlaylistTile::setPlaybackPrepared(bool state)
+{
+    player_->setPrepareEnabled(state);
+}
+
 void PlaylistTile::setMedia(const QMediaContent &c)
 {
     player_->setMedia(c);
@@ -362,6 +414,12 @@ void PlaylistTile::onContents()
     }
 }
 
+void PlaylistTile::onWeights()
+{
+    PlaylistWeightsDialog d(playlist_);
+    d.exec();
+}
+
 void PlaylistTile::mouseReleaseEvent(QGraphicsSceneMouseEvent *e)
 {
     if(mode_ != MOVE && e->button() == Qt::LeftButton) {
@@ -375,6 +433,15 @@ void PlaylistTile::mouseReleaseEvent(QGraphicsSceneMouseEvent *e)
     BaseTile::mouseReleaseEvent(e);
 }
 
+QVariant PlaylistTile::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
+{
+    // scenes of nested tiles not shown have no view
+    if(change == ItemSceneHasChanged)
+        setPlaybackPrepared(scene() != 0 && !scene()->views().isEmpty());
+
+    return BaseTile::itemChange(change, value);
+}
+
 void PlaylistTile::closePlaylistSettings()
 {
     playlist_settings_widget_->deleteLater();
@@ -409,8 +476,14 @@ void PlaylistTile::createContextMenu()
     connect(contents_action, SIGNAL(triggered()),
             this, SLOT(onContents()));
 
+    QAction* weights_action = new QAction(tr("Weights..."),this);
+
+    connect(weights_action, SIGNAL(triggered()),
+            this, SLOT(onWeights()));
+
     context_menu_->addAction(configure_action);
     context_menu_->addAction(contents_action);
+    context_menu_->addAction(weights_action);
     context_menu_->addSeparator();
 
     BaseTile::createContextMenu();
@@ -32,6 +32,9 @@ public:
     bool addMedia(const SoundFileRecord& r);
     bool addMedia(int record_id);
 
+    /* Adds sound files of given ids at once, returns number added (see Playlist::addMedia) */
+    int addMedia(QList<int> const& record_ids);
+
     void setSoundFileModel(SoundFileTableModel* m);
     SoundFileTableModel* getSoundFileModel();
 
@@ -46,6 +49,12 @@ public:
     */
     virtual bool setFromJsonObject(const QJsonObject& obj);
 
+    /**
+     * Enables pre-decoding the sound file next activation starts with
+     * (see PlaylistPlayer::prepare). Set by Canvas for tiles of the scene shown.
+    */
+    void setPlaybackPrepared(bool state);
+
 public slots:
     virtual void setMedia(const QMediaContent& c);
     virtual void play();
@@ -73,12 +82,20 @@ protected slots:
     /** slot to open contents view */
     virtual void onContents();
 
+    /** slot to open weights of contents for weighted play order */
+    void onWeights();
+
 protected:
     /*
      * BC overrides
     */
     virtual void mouseReleaseEvent(QGraphicsSceneMouseEvent* e);
 
+    /**
+     * Enables playback preparation while tile is in a scene shown.
+    */
+    virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
     /**
      * creates context menu
     */